@@ -2,7 +2,7 @@
  * @file 10_gray_code.cpp
  * @author Usam Tayyab (usamtayyab9@gmail.com)
  * @brief 
- *      Compilation command: g++ -std=c++17 9_primes_factors.cpp
+ *      Compilation command: g++ -std=c++20 -O2 -mavx2 10_gray_code.cpp
  *      This file is solution to "Problem 10.  Gray Code"
  *      mentioned in "Chapter 1: Math Problems" of the book:
  *      - The Modern C++ Challenge by Marius Bancilla (available at amazon https://www.amazon.com/Modern-Challenge-programmer-real-world-problems/dp/1788993861)
@@ -25,6 +25,16 @@
  *      2. BinaryToGray() which converts a binary string to gray code(also a binary string).
  *      3. GrayToBinary() which converts a gray code to binary string. 
  *      
+ *      Conversions are done on integers, strings are only produced by ToBinary() when printing:
+ *      - BinaryToGray(uint32_t) computes b ^ (b >> 1).
+ *      - GrayToBinary(uint32_t) computes prefix XOR of all higher bits in 5 shift-xor steps.
+ *      - Overloads taking spans convert many values at once, using AVX2(8 values per instruction)
+ *        or SSE2(4 values per instruction) when the compiler targets them.
+ *      - WriteGrayCodeTable() streams gray codes of all 2^k numbers of k bits(k <= 32) to a binary
+ *        stream, converting one chunk at a time.
+ *      The string overloads of BinaryToGray() and GrayToBinary() use the integer overloads for strings of
+ *      at most 32 bits and convert longer strings bit by bit.
+ *      
  *      Driver code:
  *      The program start by initializing two variables indicating number of bits and
  *      a 'limit' upto which gray code will be printed. Program prints the following
@@ -34,14 +44,28 @@
  *          - Gray code encoding of number
  *          - Decoded gray code
  *      dirver code prints the above info for all numbers from 0 to 'limit' constant defined.
+ *      Then checks the string overloads on empty and longer than 32-bit strings, writes gray codes of
+ *      all 24-bit numbers to a file in the temporary directory, prints the time taken and removes the file.
  * @copyright Copyright (c) 2023
  * 
  */
 #include <iostream>
+#include <fstream>
 #include <string>
 #include <algorithm>
 #include <iterator>
 #include <iomanip>
+#include <numeric>
+#include <vector>
+#include <span>
+#include <chrono>
+#include <cstdint>
+#include <cassert>
+#include <filesystem>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 using std::begin;
 using std::cin;
@@ -51,6 +75,12 @@ using std::end;
 using std::reverse;
 using std::string;
 using std::transform;
+using std::ofstream;
+using std::ostream;
+using std::span;
+using std::vector;
+using std::chrono::steady_clock;
+using std::chrono::duration;
 
 /**
  * @brief Converts a decimal number to its binary representation with a specified number of digits.
@@ -77,57 +107,148 @@ string ToBinary(const size_t &N_arg, const size_t &digits)
 }
 
 /**
- * @brief Converts a binary number to its Gray code representation.
- * 
- *      The function creates a string to store the Gray code equivalent of the input binary string.
- *      It initializes the first bit of the Gray code with the same value as the first bit of the input binary.
- *      It then uses the exclusive OR (XOR) operation between consecutive bits of the binary string
- *      to calculate the corresponding Gray code bit.
- * 
- * @param bin - binary which has to be converted to gray code
- * @return string - a binary string in which param bin is expressed as gray code 
+ * @brief Converts a number to its Gray code i.e. each bit is XOR of itself and the next higher bit.
+ */
+constexpr uint32_t BinaryToGray(const uint32_t &binary)
+{
+    return binary ^ (binary >> 1);
+}
+
+/**
+ * @brief Converts a Gray code to its number. Each bit of the number is XOR of all bits of the gray code
+ *      at the same or higher positions, which is computed as a prefix XOR in log2(32) = 5 steps.
+ */
+constexpr uint32_t GrayToBinary(uint32_t gray)
+{
+    gray ^= gray >> 1;
+    gray ^= gray >> 2;
+    gray ^= gray >> 4;
+    gray ^= gray >> 8;
+    gray ^= gray >> 16;
+    return gray;
+}
+
+/**
+ * @brief Converts every number of @param binary to its gray code in @param gray.
+ *      Converts min(size(binary), size(gray)) values. Vector registers are used for as many
+ *      values as possible, and the remaining values are converted one at a time.
+ */
+void BinaryToGray(span<const uint32_t> binary, span<uint32_t> gray)
+{
+    const auto kSize = std::min(size(binary), size(gray));
+    auto idx         = size_t{ 0 };
+#if defined(__AVX2__)
+    for (; idx + 8 <= kSize ;idx += 8)
+    {
+        const auto kValue = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(binary.data() + idx));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(gray.data() + idx), _mm256_xor_si256(kValue, _mm256_srli_epi32(kValue, 1)));
+    }
+#elif defined(__SSE2__)
+    for (; idx + 4 <= kSize ;idx += 4)
+    {
+        const auto kValue = _mm_loadu_si128(reinterpret_cast<const __m128i *>(binary.data() + idx));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(gray.data() + idx), _mm_xor_si128(kValue, _mm_srli_epi32(kValue, 1)));
+    }
+#endif
+    for (; idx < kSize ;++idx) { gray[idx] = BinaryToGray(binary[idx]); }
+}
+
+/**
+ * @brief Converts every gray code of @param gray to its number in @param binary.
+ *      Same as above, using the 5 step prefix XOR on each vector register.
+ */
+void GrayToBinary(span<const uint32_t> gray, span<uint32_t> binary)
+{
+    const auto kSize = std::min(size(gray), size(binary));
+    auto idx         = size_t{ 0 };
+#if defined(__AVX2__)
+    for (; idx + 8 <= kSize ;idx += 8)
+    {
+        auto value = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(gray.data() + idx));
+        value      = _mm256_xor_si256(value, _mm256_srli_epi32(value, 1));
+        value      = _mm256_xor_si256(value, _mm256_srli_epi32(value, 2));
+        value      = _mm256_xor_si256(value, _mm256_srli_epi32(value, 4));
+        value      = _mm256_xor_si256(value, _mm256_srli_epi32(value, 8));
+        value      = _mm256_xor_si256(value, _mm256_srli_epi32(value, 16));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(binary.data() + idx), value);
+    }
+#elif defined(__SSE2__)
+    for (; idx + 4 <= kSize ;idx += 4)
+    {
+        auto value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(gray.data() + idx));
+        value      = _mm_xor_si128(value, _mm_srli_epi32(value, 1));
+        value      = _mm_xor_si128(value, _mm_srli_epi32(value, 2));
+        value      = _mm_xor_si128(value, _mm_srli_epi32(value, 4));
+        value      = _mm_xor_si128(value, _mm_srli_epi32(value, 8));
+        value      = _mm_xor_si128(value, _mm_srli_epi32(value, 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(binary.data() + idx), value);
+    }
+#endif
+    for (; idx < kSize ;++idx) { binary[idx] = GrayToBinary(gray[idx]); }
+}
+
+/**
+ * @brief Converts a binary string to its Gray code string, having the same number of bits.
+ *      Strings of at most 32 bits are converted using the integer overload, longer strings
+ *      are converted bit by bit i.e. each gray bit is XOR of a bit and its previous(higher) bit.
+ *      An empty string gives an empty string.
  */
 string BinaryToGray(const string &bin)
 {
-    auto gray = string(size(bin), '0');
+    if (empty(bin)) { return string{}; }
+    if (size(bin) <= 32) { return ToBinary(BinaryToGray(static_cast<uint32_t>(std::stoul(bin, nullptr, 2))), size(bin)); }
+
+    auto gray    = string(size(bin), '0');
     gray.front() = bin.front();
     transform(cbegin(bin) + 1, cend(bin), cbegin(bin), begin(gray) + 1,
-    [](const auto &prev, const auto &next)
+    [](const auto &next, const auto &prev)
     {
-        const auto kPrevInt = prev - '0';
-        const auto kNextInt = next - '0';
-        const auto kGrayBit = (kNextInt + kPrevInt) % 2;
-        return kGrayBit + '0';
+        return static_cast<char>((((next - '0') + (prev - '0')) % 2) + '0');
     });
     return gray;
 }
 
 /**
- * @brief Converts a Gray code number to its binary representation.
- * 
- *      The function creates a string to store the binary equivalent of the input Gray code string.
- *      It initializes the first bit of the binary with the same value as the first bit of the input Gray code.
- *      It then uses the exclusive OR (XOR) operation between consecutive bits of the Gray code string
- *      and the corresponding bits of the previously calculated binary string to reconstruct the original binary.
- * 
- * @param gray - The Gray code number to be converted to binary.
- * @return A string representing the binary equivalent of the input Gray code.
+ * @brief Converts a Gray code string to its binary string, having the same number of bits.
+ *      Strings of at most 32 bits are converted using the integer overload, longer strings
+ *      are converted bit by bit i.e. each binary bit is XOR of the gray bit and the previous binary bit.
+ *      An empty string gives an empty string.
  */
 string GrayToBinary(const string &gray)
 {
-    auto binary = string(size(gray), '0');
+    if (empty(gray)) { return string{}; }
+    if (size(gray) <= 32) { return ToBinary(GrayToBinary(static_cast<uint32_t>(std::stoul(gray, nullptr, 2))), size(gray)); }
+
+    auto binary    = string(size(gray), '0');
     binary.front() = gray.front();
     transform(cbegin(gray) + 1, cend(gray), cbegin(binary), begin(binary) + 1,
     [](const auto &gray_ch, const auto &prev_binary_ch)
     {
-        const auto kBinaryInt      = prev_binary_ch - '0';
-        const auto kGrayInt        = gray_ch        - '0';
-        const auto kCurrentGrayBit = (kBinaryInt + kGrayInt) % 2;
-        return kCurrentGrayBit + '0';
+        return static_cast<char>((((gray_ch - '0') + (prev_binary_ch - '0')) % 2) + '0');
     });
     return binary;
 }
 
+/**
+ * @brief Writes gray codes of all numbers from 0 to 2^@param bits - 1, in order, to @param output
+ *      as raw 32-bit values. Numbers are generated and converted one chunk of `kChunkSize`
+ *      values at a time, so memory use does not depend on @param bits(at most 32).
+ */
+void WriteGrayCodeTable(ostream &output, const unsigned &bits)
+{
+    constexpr auto kChunkSize = size_t{ 1 } << 16;
+    const auto kCount         = uint64_t{ 1 } << std::min(bits, 32u);
+    auto numbers              = vector<uint32_t>(kChunkSize);
+    auto codes                = vector<uint32_t>(kChunkSize);
+    for (auto first = uint64_t{ 0 }; first < kCount ;first += kChunkSize)
+    {
+        const auto kChunk = static_cast<size_t>(std::min<uint64_t>(kChunkSize, kCount - first));
+        std::iota(begin(numbers), begin(numbers) + kChunk, static_cast<uint32_t>(first));
+        BinaryToGray(span{ numbers }.first(kChunk), span{ codes }.first(kChunk));
+        output.write(reinterpret_cast<const char *>(codes.data()), kChunk * sizeof(uint32_t));
+    }
+}
+
 int main()
 {
     constexpr auto kNumberOfBits = 5;
@@ -137,17 +258,38 @@ int main()
     cout << "| Number | Binary | Gray Encoded | Gray Decoded |\n";
     cout << "|--------|--------|--------------|--------------|\n";
 
-    for (auto i = 0; i <= kLimit ;++i)
+    for (auto i = uint32_t{ 0 }; i <= kLimit ;++i)
     {
-        const auto kBin     = ToBinary(i, kNumberOfBits);
-        const auto kGrayEnc = BinaryToGray(kBin);
+        const auto kGrayEnc = BinaryToGray(i);
         const auto kGrayDec = GrayToBinary(kGrayEnc);
         cout << "| " << std::setw(6) << i            << " |  " 
-             << kBin                                 << " | " 
-             << std::setw(12) << kGrayEnc << " |  "
-             << std::setw(11) << kGrayDec << " | "
+             << ToBinary(i, kNumberOfBits)           << " | " 
+             << std::setw(12) << ToBinary(kGrayEnc, kNumberOfBits) << " |  "
+             << std::setw(11) << ToBinary(kGrayDec, kNumberOfBits) << " | "
              << '\n';
         cout << "|________|________|______________|______________|\n";
     }
+
+    assert(BinaryToGray(string{}) == string{});
+    assert(GrayToBinary(string{}) == string{});
+    assert(BinaryToGray(string{ "10110" }) == string{ "11101" });
+    assert(GrayToBinary(string{ "11101" }) == string{ "10110" });
+    const auto kLongBinary = string(40, '1');
+    const auto kLongGray   = "1" + string(39, '0');
+    assert(BinaryToGray(kLongBinary) == kLongGray);
+    assert(GrayToBinary(kLongGray) == kLongBinary);
+    const auto kWideBinary = ToBinary(0xF0F0'F0F0'F0F0'F0F0ull, 64) + "1011";
+    assert(GrayToBinary(BinaryToGray(kWideBinary)) == kWideBinary);
+
+    constexpr auto kTableBits = 24u;
+    const auto kTablePath     = (std::filesystem::temp_directory_path() / "gray_codes_24.bin").string();
+    {
+        auto table_file     = ofstream{ kTablePath, std::ios::binary };
+        const auto kStart   = steady_clock::now();
+        WriteGrayCodeTable(table_file, kTableBits);
+        const auto kSeconds = duration<double>(steady_clock::now() - kStart).count();
+        cout << "Wrote gray codes of all " << kTableBits << "-bit numbers to " << kTablePath << " in " << kSeconds * 1000 << "ms\n";
+    }
+    std::filesystem::remove(kTablePath);
     return 0;
 }
\ No newline at end of file
@@ -2,7 +2,7 @@
  * @file 11_numeral_to_roman.cpp
  * @author Usama Tayyab (usamatayyab9@gmail.com)
  * @brief 
- *      Compilation command : g++ -std=c++17 11_numeral_to_roman.cpp
+ *      Compilation command : g++ -std=c++20 -O2 11_numeral_to_roman.cpp
  *      This file is solution to "Problem 11.  Converting numerical values to Roman"
  *      mentioned in "Chapter 1: Math Problems" of the book:
  *      - The Modern C++ Challenge by Marius Bancilla (available at amazon https://www.amazon.com/Modern-Challenge-programmer-real-world-problems/dp/1788993861)
@@ -11,8 +11,14 @@
  *      "Write a program that, given a number entered by the user, prints its Roman numeral equivalent"
  * 
  *      The struct NumeralToRomanConverter is used for converting a number into its Roman representation.
+ *      For converting many numbers at once, roman numerals of all numbers from 1 to 3999 are generated at
+ *      compile time into a single character blob(see RomanNumeralTable). ToRomanBatch() copies numerals
+ *      from the blob into a caller provided buffer without any allocation, and FromRoman() validates
+ *      and decodes a roman numeral back to its number.
  *       Driver code:
  *      The program intially asks the user to input a number. The prints it roman eqibalent string.
+ *      Then verifies that every numeral in the table decodes back to its number, and compares the
+ *      throughput of NumeralToRomanConverter and ToRomanBatch().
  * 
  * @copyright Copyright (c) 2023
  * 
@@ -22,14 +28,32 @@
 #include <string_view>
 #include <utility>
 #include <array>
+#include <vector>
+#include <span>
+#include <optional>
+#include <algorithm>
+#include <chrono>
+#include <cassert>
+#include <cstdint>
 
 using std::array;
 using std::cin;
 using std::cout;
 using std::endl;
+using std::optional;
 using std::pair;
+using std::span;
 using std::string;
 using std::string_view;
+using std::vector;
+using std::chrono::steady_clock;
+using std::chrono::duration;
+using namespace std::string_view_literals;
+
+inline constexpr auto kRomanUnitPlaceTable     = array{ ""sv, "I"sv, "II"sv, "III"sv, "IV"sv, "V"sv, "VI"sv, "VII"sv, "VIII"sv, "IX"sv };
+inline constexpr auto kRomanTensPlaceTable     = array{ ""sv, "X"sv, "XX"sv, "XXX"sv, "XL"sv, "L"sv, "LX"sv, "LXX"sv, "LXXX"sv, "XC"sv };
+inline constexpr auto kRomanHunderedPlaceTable = array{ ""sv, "C"sv, "CC"sv, "CCC"sv, "CD"sv, "D"sv, "DC"sv, "DCC"sv, "DCCC"sv, "CM"sv };
+inline constexpr auto kRomanThousandPlaceTable = array{ ""sv, "M"sv, "MM"sv, "MMM"sv };
 
 /**
  * @brief A structure for converting a number to its eqivalent roman literal.
@@ -47,6 +71,7 @@ struct NumeralToRomanConverter
         
         auto value        = num;
         auto romans_array = array<string_view, 4>{}; // contain roman for each of unit, tens, hundered place of num
+        auto thousands    = string{};                // owns the thousand place literal referred by romans_array[0]
 
         if (const auto kUnitDigit = value % 10; kUnitDigit > 0) { romans_array[3] = kUnitPlaceTable[kUnitDigit - 1]; }
         value /= 10;
@@ -57,7 +82,11 @@ struct NumeralToRomanConverter
         if (const auto kHunderedDigit = value % 10; kHunderedDigit > 0) { romans_array[1] = kHunderedPlaceTable[kHunderedDigit - 1]; }
         value /= 10;
 
-        if (value > 0) { romans_array[0] = string(value, kThousand); }
+        if (value > 0)
+        {
+            thousands       = string(value, kThousand);
+            romans_array[0] = thousands;
+        }
         /*!
          * At this point:
          * romans_array[0] will contain roman literal for value's thousand place digit 
@@ -74,11 +103,152 @@ struct NumeralToRomanConverter
         return roman;
     }
 };
+/**
+ * @brief Appends roman numeral of @param n, place by place, to @param output starting at
+ *      @param position and returns the position after it. When @param output is null only the
+ *      length is accumulated, which is used for sizing the blob of RomanNumeralTable.
+ */
+constexpr size_t AppendRomanNumeral(const size_t &n, char *output, size_t position)
+{
+    const auto kParts = array{ kRomanThousandPlaceTable[n / 1000], kRomanHunderedPlaceTable[(n / 100) % 10],
+                               kRomanTensPlaceTable[(n / 10) % 10], kRomanUnitPlaceTable[n % 10] };
+    for (const auto &part : kParts)
+    {
+        for (const auto &ch : part)
+        {
+            if (nullptr != output) { output[position] = ch; }
+            ++position;
+        }
+    }
+    return position;
+}
+
+constexpr size_t RomanNumeralsLength(const size_t &max_number)
+{
+    auto total = size_t{ 0 };
+    for (auto n = size_t{ 1 }; n <= max_number ;++n) { total = AppendRomanNumeral(n, nullptr, total); }
+    return total;
+}
+
+/**
+ * @brief Roman numerals of all numbers from 1 to kMaxNumber stored back to back in a single
+ *      character blob. Numeral of n is blob[offsets[n], offsets[n + 1]). Built at compile time.
+ */
+struct RomanNumeralTable
+{
+    static constexpr auto kMaxNumber = size_t{ 3999 };
+
+    array<char, RomanNumeralsLength(kMaxNumber)> blob{};
+    array<uint16_t, kMaxNumber + 2>              offsets{}; // offsets[0] and offsets[1] are 0, numeral of 0 is empty
+
+    constexpr RomanNumeralTable()
+    {
+        for (auto n = size_t{ 1 }; n <= kMaxNumber ;++n)
+        {
+            offsets[n + 1] = static_cast<uint16_t>(AppendRomanNumeral(n, blob.data(), offsets[n]));
+        }
+    }
+
+    constexpr string_view operator[](const size_t &n) const
+    {
+        return string_view{ blob.data() + offsets[n], static_cast<size_t>(offsets[n + 1] - offsets[n]) };
+    }
+};
+
+inline constexpr auto kRomanNumeralTable = RomanNumeralTable{};
+
+/**
+ * @brief Writes roman numerals of @param numbers back to back into @param buffer.
+ *      Numeral of numbers[i] is written at buffer[offsets[i], offsets[i + 1]), so @param offsets
+ *      must have room for size(numbers) + 1 entries. Numbers outside [1, 3999] produce an empty numeral.
+ *      Writing stops at the first numeral that does not fit in @param buffer.
+ * @return Number of numerals written, offsets upto index returned value are valid.
+ */
+size_t ToRomanBatch(span<const uint16_t> numbers, span<char> buffer, span<uint32_t> offsets)
+{
+    assert(size(offsets) > size(numbers));
+    auto position = size_t{ 0 };
+    offsets[0]    = 0;
+    for (auto idx = size_t{ 0 }; idx < size(numbers) ;++idx)
+    {
+        const auto kNumber  = numbers[idx];
+        const auto kNumeral = (kNumber <= RomanNumeralTable::kMaxNumber) ? kRomanNumeralTable[kNumber] : string_view{};
+        if (size(kNumeral) > size(buffer) - position) { return idx; }
+
+        std::copy(cbegin(kNumeral), cend(kNumeral), begin(buffer) + position);
+        position += size(kNumeral);
+        offsets[idx + 1] = static_cast<uint32_t>(position);
+    }
+    return size(numbers);
+}
+
+/**
+ * @brief Decodes a roman numeral into its number. Only canonical numerals of numbers from 1 to 3999
+ *      are accepted, e.g. "IIII" or "IC" are rejected.
+ *      Numeral is matched place by place, thousands first. For each place the longest matching
+ *      pattern of that place's table is taken. Since every place uses its own set of letters, the
+ *      longest match is the only possible one. The numeral is valid if all characters are consumed.
+ * @return number, or an empty optional if @param roman is not a valid numeral.
+ */
+optional<uint16_t> FromRoman(string_view roman)
+{
+    const auto kMatchPlace = [&roman](const auto &table) -> size_t
+    {
+        auto best = size_t{ 0 };
+        for (auto digit = size_t{ 1 }; digit < size(table) ;++digit)
+        {
+            if (roman.starts_with(table[digit]) && size(table[digit]) > size(table[best])) { best = digit; }
+        }
+        roman.remove_prefix(size(table[best]));
+        return best;
+    };
+
+    const auto kThousands = kMatchPlace(kRomanThousandPlaceTable);
+    const auto kHundereds = kMatchPlace(kRomanHunderedPlaceTable);
+    const auto kTens      = kMatchPlace(kRomanTensPlaceTable);
+    const auto kUnits     = kMatchPlace(kRomanUnitPlaceTable);
+    const auto kNumber    = kThousands * 1000 + kHundereds * 100 + kTens * 10 + kUnits;
+
+    auto result = optional<uint16_t>{};
+    if (roman.empty() && kNumber > 0) { result = static_cast<uint16_t>(kNumber); }
+    return result;
+}
+
 int main()
 {
     cout << "Enter a number: ";
     auto n = size_t{ 0 };
     cin >> n;
     cout << n << " converted to roman is " << NumeralToRomanConverter{}(n) << '\n';
+
+    for (auto number = size_t{ 1 }; number <= RomanNumeralTable::kMaxNumber ;++number)
+    {
+        assert(kRomanNumeralTable[number] == NumeralToRomanConverter{}(number));
+        assert(FromRoman(kRomanNumeralTable[number]) == number);
+    }
+    assert(!FromRoman("IIII") && !FromRoman("IC") && !FromRoman("MMMM") && !FromRoman("") && !FromRoman("XLX"));
+
+    constexpr auto kRepetitions = size_t{ 1000 };
+    auto numbers                = vector<uint16_t>{};
+    for (auto repetition = size_t{ 0 }; repetition < kRepetitions ;++repetition)
+    {
+        for (auto number = uint16_t{ 1 }; number <= RomanNumeralTable::kMaxNumber ;++number) { numbers.push_back(number); }
+    }
+
+    auto start_timepoint = steady_clock::now();
+    auto total_length    = size_t{ 0 };
+    for (const auto &number : numbers) { total_length += NumeralToRomanConverter{}(number).size(); }
+    const auto kConverterSeconds = duration<double>(steady_clock::now() - start_timepoint).count();
+
+    auto buffer     = vector<char>(total_length);
+    auto offsets    = vector<uint32_t>(size(numbers) + 1);
+    start_timepoint = steady_clock::now();
+    const auto kWritten      = ToRomanBatch(numbers, buffer, offsets);
+    const auto kBatchSeconds = duration<double>(steady_clock::now() - start_timepoint).count();
+    assert(kWritten == size(numbers) && offsets.back() == total_length);
+
+    cout << "Converting " << size(numbers) << " numbers:\n";
+    cout << "    NumeralToRomanConverter: " << size(numbers) / kConverterSeconds / 1e6 << " million numerals/s\n";
+    cout << "    ToRomanBatch           : " << size(numbers) / kBatchSeconds / 1e6 << " million numerals/s\n";
     return 0;
 }
\ No newline at end of file
@@ -2,7 +2,7 @@
  * @file 12_largest_collatz_sequence.cpp
  * @author Usama Tayyab (usamatayyab9@gmail.com)
  * @brief 
- *      Compilation command : g++ -std=c++17 12_largest_collatz_sequence.cpp
+ *      Compilation command : g++ -std=c++20 -O2 12_largest_collatz_sequence.cpp -lpthread
  *      This file is solution to "Problem 12. Largest Collatz sequence"
  *      mentioned in "Chapter 1: Math Problems" of the book:
  *      - The Modern C++ Challenge by Marius Bancilla (available at amazon https://www.amazon.com/Modern-Challenge-programmer-real-world-problems/dp/1788993861)
@@ -30,22 +30,41 @@
  *      For more visit https://en.wikipedia.org/wiki/Collatz_conjecture
  * 
  *      This solution uses a struct CollatzSequence for calculating number of steps of collatz sequence.
+ *      For large limits(e.g. 10^9) the class LongestCollatzEngine is provided, which caches lengths
+ *      in a flat uint16_t array and scans the range on multiple threads. See class comments.
  *      Driver code: 
  *      Program starts with 1 and goes upto a specified constant value of 1,000,000 and calculates 
  *      length of collatz sequence length of each number. While doing so it keeps track of maximum
  *      sequence length obtained so far and which number it is obtained. Finally prints number and 
  *      sequence length which is maximum.
+ *      Then computes the same using LongestCollatzEngine, verifies both results are same and prints
+ *      time taken by each approach along with throughput of the engine in numbers per second.
  * 
  * @copyright Copyright (c) 2023
  * 
  */
 #include <iostream>
 #include <unordered_map>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cassert>
+#include <cstdint>
 
 using std::cout;
 using std::cin;
 using std::endl;
 using std::unordered_map;
+using std::vector;
+using std::thread;
+using std::atomic_ref;
+using std::memory_order_relaxed;
+using std::chrono::steady_clock;
+using std::chrono::duration;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
 
 
 /**
@@ -92,6 +111,118 @@ struct CollatzSequence
     }
 };
 
+/**
+ * @brief Finds the number upto a limit which produces the longest Collatz sequence.
+ * 
+ * Unlike CollatzSequence, which stores every value visited in a hash map, this class
+ * caches sequence lengths in a flat uint16_t array indexed by the number itself, and
+ * only for numbers below `cache_size`. Values above it are iterated without storing.
+ * So memory is bounded by 2 * cache_size bytes regardless of how high a sequence goes.
+ * 
+ * Lengths are computed iteratively:
+ * - Starting from n, apply the Collatz steps until the value drops below n and its
+ *   length is found in the cache. For odd x the two steps 3x + 1 and (3x + 1) / 2 are
+ *   done together, since 3x + 1 is always even.
+ * - Length of n is the number of steps taken plus cached length of the value reached.
+ * 
+ * The range [1, limit] is divided into blocks of `kBlockSize` numbers, and blocks are
+ * interleaved among threads i.e. thread t processes blocks t, t + T, t + 2T..., so that
+ * all threads move upwards together and find most of their lookups already cached.
+ * The cache is shared by all threads through relaxed atomic_ref loads/stores. An entry
+ * not yet written by another thread reads as 0 and the iteration simply continues
+ * further down, so the result does not depend on thread timing.
+ * Each thread keeps its own maximum, which are merged once all threads finish.
+ */
+class LongestCollatzEngine
+{
+public:
+    struct Result
+    {
+        uint64_t number = 1;
+        uint64_t length = 1;
+    };
+
+    static constexpr auto kBlockSize = uint64_t{ 1 } << 16;
+
+    /**
+     * @param limit - Numbers from 1 to limit(inclusive) are scanned.
+     * @param cache_size - Lengths of numbers below cache_size are cached, clamped to limit + 1.
+     * @param thread_count - 0 is treated as 1.
+     */
+    LongestCollatzEngine(const uint64_t &limit, const uint64_t &cache_size, const size_t &thread_count = thread::hardware_concurrency())
+        : limit_{ limit }, thread_count_{ std::max(thread_count, size_t{ 1 }) }, cache_(std::min(cache_size, limit + 1), 0)
+    {
+    }
+
+    explicit LongestCollatzEngine(const uint64_t &limit) : LongestCollatzEngine(limit, limit + 1)
+    {
+    }
+
+    Result operator()()
+    {
+        if (size(cache_) > 1) { cache_[1] = 1; }
+
+        const auto kBlockCount = limit_ / kBlockSize + 1;
+        auto thread_results    = vector<Result>(thread_count_);
+        auto threads           = vector<thread>{};
+        for (auto thread_idx = size_t{ 0 }; thread_idx < thread_count_ ;++thread_idx)
+        {
+            threads.push_back(thread{ [this, thread_idx, kBlockCount, &result = thread_results[thread_idx]]()
+            {
+                for (auto block = uint64_t{ thread_idx }; block < kBlockCount ;block += thread_count_)
+                {
+                    const auto kLast = std::min((block + 1) * kBlockSize - 1, limit_);
+                    for (auto n = std::max(block * kBlockSize, uint64_t{ 1 }); n <= kLast ;++n)
+                    {
+                        if (const auto kLength = Length(n); kLength > result.length)
+                        {
+                            result = Result{ n, kLength };
+                        }
+                    }
+                }
+            }});
+        }
+        for (auto &t : threads) { t.join(); }
+
+        // Ties are resolved in favour of the smaller number, same as a sequential scan.
+        return *std::max_element(begin(thread_results), end(thread_results), [](const auto &lhs, const auto &rhs)
+        {
+            return (lhs.length < rhs.length) || (lhs.length == rhs.length && lhs.number > rhs.number);
+        });
+    }
+
+private:
+    uint64_t Length(const uint64_t &N)
+    {
+        auto steps = uint64_t{ 0 };
+        auto x     = N;
+        while (1 != x)
+        {
+            if (x < N && x < size(cache_))
+            {
+                if (const auto kCached = atomic_ref<uint16_t>{ cache_[x] }.load(memory_order_relaxed); 0 != kCached)
+                {
+                    steps += kCached - 1;
+                    break;
+                }
+            }
+            if (0 == (x & 1)) { x >>= 1;               steps += 1; }
+            else              { x = (3 * x + 1) >> 1;  steps += 2; }
+        }
+        const auto kLength = steps + 1;
+        if (N < size(cache_))
+        {
+            atomic_ref<uint16_t>{ cache_[N] }.store(static_cast<uint16_t>(kLength), memory_order_relaxed);
+        }
+        return kLength;
+    }
+
+    uint64_t         limit_;
+    size_t           thread_count_;
+    vector<uint16_t> cache_; // cache_[n] is length of collatz sequence of n, 0 if not computed yet
+};
+
+#if !defined(MATH_KERNELS_BENCHMARK) // benchmark_math_kernels.cpp includes this file for its solution
 int main()
 {
     constexpr auto kLimit           = 1'000'000;
@@ -99,8 +230,9 @@ int main()
     
     cout << "Computing largest collatz sequence upto " << kLimit << "...\n";
     
-    auto largest_collatz_length = 1;
-    auto largest_collatz_number = 1;
+    auto start_timepoint        = steady_clock::now();
+    auto largest_collatz_length = size_t{ 1 };
+    auto largest_collatz_number = size_t{ 1 };
     for (auto i = 1; i <= kLimit ;++i)
     {
         if (auto length = collatz_sequence_generator(i); length > largest_collatz_length)
@@ -109,7 +241,17 @@ int main()
             largest_collatz_length = length;
         }
     }
+    const auto kDuration = duration_cast<milliseconds>(steady_clock::now() - start_timepoint);
     cout << "Largest collatz sequence length:  " << largest_collatz_length << '\n';
     cout << "Largest collatz sequence number:  " << largest_collatz_number << '\n';
+    cout << "Using CollatzSequence took: " << kDuration.count() << "ms\n";
+
+    start_timepoint            = steady_clock::now();
+    const auto kResult         = LongestCollatzEngine{ kLimit }();
+    const auto kEngineDuration = duration<double>(steady_clock::now() - start_timepoint);
+    assert(kResult.length == largest_collatz_length && kResult.number == largest_collatz_number);
+    cout << "Using LongestCollatzEngine took: " << duration_cast<milliseconds>(kEngineDuration).count() << "ms, throughput: "
+         << static_cast<uint64_t>(kLimit / kEngineDuration.count()) << " numbers/s\n";
     return 0;
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
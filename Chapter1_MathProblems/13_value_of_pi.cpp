@@ -2,7 +2,7 @@
  * @file 13_value_of_pi.cpp
  * @author Usama Tayyab (usamatayyab9@gmail.com)
  * @brief 
- *      Compilation command : g++ -std=c++17 13_value_of_pi.cpp
+ *      Compilation command : g++ -std=c++20 -O2 13_value_of_pi.cpp -lpthread
  *      This file is solution to "Problem 13. Computing the value of Pi"
  *      mentioned in "Chapter 1: Math Problems" of the book:
  *      - The Modern C++ Challenge by Marius Bancilla (available at amazon https://www.amazon.com/Modern-Challenge-programmer-real-world-problems/dp/1788993861)
@@ -14,19 +14,61 @@
  *      1. Using limit method
  *      2. Using Leibniz formula
  *      3. Chudnovsky algorithm for calculating Pi
+ *      The third approach works in long double, so it is limited to a few terms. For computing millions
+ *      of digits, ChudnovskyPiEngine from arbitrary_precision_pi.h is provided, which evaluates the
+ *      same series with arbitrary precision integers using binary splitting.
  *      Driver code:
  *      The program calculates the value of Pi using all three algortihms above and prints them.
+ *      Then checks the digits from ChudnovskyPiEngine against `kKnownDigits`, the last 20 digits and FNV-1a
+ *      hash of known digits of π at several lengths, and exits with 1 if any of them differ.
+ *      Then computes `kDigits` digits of Pi using ChudnovskyPiEngine, writes them to the file pi_digits.txt
+ *      in the temporary directory and prints the time taken by each phase of the computation.
  *      See function  comments for each method implementation
  * @copyright Copyright (c) 2023
  * 
  */
 #include <iostream>
+#include <fstream>
 #include <cmath>
 #include <limits>
+#include <sstream>
+#include <string_view>
+#include <array>
+#include <filesystem>
+
+#include "arbitrary_precision_pi.h"
 
 using std::cout;
 using std::endl;
+using std::ofstream;
 using std::pow;
+using std::string_view;
+
+struct KnownDigits
+{
+    size_t      digits;
+    string_view last_digits;
+    uint64_t    hash;        // FNV-1a of "3." followed by the digits
+};
+
+/*! Computed independently using Machin's formula with exact integers */
+inline constexpr auto kKnownDigits = std::array{
+    KnownDigits{ 1'000,  "66111959092164201989", 0xf5151782d608b542 },
+    KnownDigits{ 25'000, "37739951006589528877", 0x2c79e477d7ec0f10 },
+    KnownDigits{ 30'000, "82603050099451082478", 0xf73cdb7b8ca05209 },
+    KnownDigits{ 40'000, "85262133252473837651", 0x03f86904522228e3 },
+    KnownDigits{ 59'999, "81966662490358577899", 0xd715d6da4ccbaf3e },
+};
+
+uint64_t Fnv1aHash(string_view text)
+{
+    auto hash = uint64_t{ 0xcbf29ce484222325 };
+    for (const auto &kCh : text)
+    {
+        hash = (hash ^ static_cast<unsigned char>(kCh)) * 0x100000001b3;
+    }
+    return hash;
+}
 
 auto PIUsingLimitMethod()
 {
@@ -43,7 +85,7 @@ struct LeibnizFormulaForPI
     double operator()(const size_t &N)
     {
         auto sum = 0.0;
-        for (auto k = 0; k < N; ++k)
+        for (auto k = size_t{ 0 }; k < N; ++k)
         {
             const auto kNumerator   = pow(-1, k);
             const auto kDenominator = (2.0 * k) + 1.0;
@@ -70,7 +112,7 @@ struct ChudnovskyAlgorithmForPI
         constexpr auto kNegativeOne         = long_double{ -1.0       };
         constexpr auto kPositiveOne         = long_double{ +1.0       };
         auto sum                            = long_double{ 0.0        };
-        for (auto k = 0; k < N; ++k)
+        for (auto k = size_t{ 0 }; k < N; ++k)
         {
             const auto kPowerOfNegativeOne  = (0 == k % 2) ? kPositiveOne : kNegativeOne;
             const auto kFactorialOf6k       = Factorial(6 * k);
@@ -100,6 +142,7 @@ private:
     }
 };
 
+#if !defined(MATH_KERNELS_BENCHMARK) // benchmark_math_kernels.cpp includes this file for its solution
 int main()
 {
     cout << "Value of π using limit method is: " << PIUsingLimitMethod() << '\n';
@@ -110,5 +153,31 @@ int main()
     auto number_of_terms_chudnovsky = 3;
     cout << "Value of π using Chudnovksy algorithm upto " << number_of_terms_chudnovsky << " terms is: " << ChudnovskyAlgorithmForPI{}(number_of_terms_chudnovsky) << '\n';
 
+    for (const auto &kKnown : kKnownDigits)
+    {
+        auto engine = ChudnovskyPiEngine{ kKnown.digits };
+        auto output = std::ostringstream{};
+        engine.WriteDigits(output);
+        const auto kText = output.str();
+        if (kText.size() != kKnown.digits + 2 || !kText.ends_with(kKnown.last_digits) || Fnv1aHash(kText) != kKnown.hash)
+        {
+            cout << "Digits of π computed upto " << kKnown.digits << " digits are wrong\n";
+            return 1;
+        }
+    }
+    cout << "Digits of π match known digits upto " << kKnownDigits.back().digits << " digits\n";
+
+    constexpr auto kDigits     = size_t{ 1'000'000 };
+    const auto kDigitsFile     = (std::filesystem::temp_directory_path() / "pi_digits.txt").string();
+    auto pi_engine             = ChudnovskyPiEngine{ kDigits };
+    auto output_file           = ofstream{ kDigitsFile };
+    pi_engine.WriteDigits(output_file);
+    cout << "Wrote " << kDigits << " digits of π to " << kDigitsFile << '\n';
+    for (const auto &[phase, duration] : pi_engine.PhaseTimings())
+    {
+        cout << "    " << phase << ": " << duration.count() << "ms\n";
+    }
+
     return 0;
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
@@ -2,7 +2,7 @@
  * @file 14_validating_isbn.cpp
  * @author Usama Tayyab (usamatayyab9@gmail.com)
  * @brief 
- *      Compilation command: g++ -std=c++17 14_validating_isbn.cpp
+ *      Compilation command: g++ -std=c++20 -O2 -mavx2 14_validating_isbn.cpp -lpthread
  *      This file is solution to "Problem 14. Validating ISBNs"
  *      mentioned in "Chapter 1: Math Problems" of the book:
  *      - The Modern C++ Challenge by Marius Bancilla (available at amazon https://www.amazon.com/Modern-Challenge-programmer-real-world-problems/dp/1788993861)
@@ -18,9 +18,23 @@
  *      For more infor visit https://en.wikipedia.org/wiki/ISBN#Check_digits
  *      
  *      This file provides functions verifying both ISBN-10 and ISBN-13 numbers.
+ *      
+ *      For validating large catalog files with one ISBN per line, ValidateISBNFile() is provided:
+ *      - The file is memory-mapped and divided into one chunk per thread, chunk boundaries are
+ *        moved to the start of the next line.
+ *      - Line ends are found with FindNewline(), which compares 32(AVX2) or 16(SSE2) bytes at a time.
+ *      - Each line is validated by IsValidISBNLine() as either ISBN-10 or ISBN-13. With SSSE3 the
+ *        digit check and the weighted sum of a line are computed with a few vector instructions,
+ *        weights are multiplied and added using _mm_maddubs_epi16.
+ *      - Result is a bitmap with one bit per line, optionally valid lines are also written to a
+ *        filtered output file.
  *      Driver code:
  *      The program first takes an s=input from the user. Then ISBN-10 and ISBN-13 validation statuses of 
  *      input number;
+ *      Then generates a catalog file of random ISBNs in the temporary directory, validates it using
+ *      ValidateISBNFile(), checks the bitmap against IsValidISBN_10() and IsValidISBN_13(), prints the
+ *      time taken and removes the files. The catalog has 100'000 lines unless a line count is given as
+ *      the first command line argument, e.g. `./a.out 10000000` for benchmarking.
  * 
  * @copyright Copyright (c) 2023
  * 
@@ -30,13 +44,41 @@
 #include <string_view>
 #include <algorithm>
 #include <cctype>
+#include <array>
+#include <vector>
+#include <optional>
+#include <fstream>
+#include <random>
+#include <thread>
+#include <chrono>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 using std::all_of;
+using std::array;
 using std::cout;
 using std::cin;
 using std::endl;
+using std::optional;
 using std::string;
 using std::string_view;
+using std::thread;
+using std::vector;
+using std::chrono::steady_clock;
+using std::chrono::duration;
 
 /**
  * @brief Tests if @param ch is a digit or not
@@ -130,7 +172,249 @@ bool IsValidISBN_13(string_view isbn)
     return is_valid;
 }
 
-int main()
+/**
+ * @brief Returns pointer to the first '\n' in [@param first, @param last), or @param last if there is none.
+ *      Compares 32 bytes(AVX2) or 16 bytes(SSE2) per iteration, remaining bytes are checked one by one.
+ */
+const char* FindNewline(const char *first, const char *last)
+{
+#if defined(__AVX2__)
+    const auto kNewlines = _mm256_set1_epi8('\n');
+    for (; last - first >= 32 ;first += 32)
+    {
+        const auto kBytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(first));
+        const auto kMask  = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(kBytes, kNewlines)));
+        if (0 != kMask) { return first + std::countr_zero(kMask); }
+    }
+#elif defined(__SSE2__)
+    const auto kNewlines = _mm_set1_epi8('\n');
+    for (; last - first >= 16 ;first += 16)
+    {
+        const auto kBytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+        const auto kMask  = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(kBytes, kNewlines)));
+        if (0 != kMask) { return first + std::countr_zero(kMask); }
+    }
+#endif
+    for (; first != last && '\n' != *first ;++first) {}
+    return first;
+}
+
+#if defined(__SSSE3__)
+/**
+ * @brief Tests if the first @param length(10 or 13) characters of @param isbn form a valid ISBN.
+ *      Loads 16 bytes, so @param isbn must point to atleast 16 readable bytes.
+ *      Digits are obtained by subtracting '0' from every byte, a byte is a digit if it is(unsigned) <= 9.
+ *      Weights of bytes after @param length are 0, hence they do not contribute to the sum.
+ */
+bool IsValidISBN16Bytes(const char *isbn, const size_t &length)
+{
+    const auto kBytes       = _mm_loadu_si128(reinterpret_cast<const __m128i *>(isbn));
+    const auto kDigits      = _mm_sub_epi8(kBytes, _mm_set1_epi8('0'));
+    const auto kIsDigit     = _mm_cmpeq_epi8(_mm_min_epu8(kDigits, _mm_set1_epi8(9)), kDigits);
+    const auto kLengthMask  = (1 << length) - 1;
+    if (kLengthMask != (_mm_movemask_epi8(kIsDigit) & kLengthMask)) { return false; }
+
+    const auto kWeights = (10 == length) ? _mm_setr_epi8(10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 0, 0, 0, 0, 0)
+                                         : _mm_setr_epi8(1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 0, 0, 0);
+    const auto kPairSums = _mm_maddubs_epi16(kDigits, kWeights);          // 8 sums of 2 weighted digits
+    auto sums            = _mm_madd_epi16(kPairSums, _mm_set1_epi16(1));  // 4 sums of 4 weighted digits
+    sums                 = _mm_add_epi32(sums, _mm_shuffle_epi32(sums, _MM_SHUFFLE(1, 0, 3, 2)));
+    sums                 = _mm_add_epi32(sums, _mm_shuffle_epi32(sums, _MM_SHUFFLE(2, 3, 0, 1)));
+    const auto kSum      = _mm_cvtsi128_si32(sums);
+    return 0 == kSum % ((10 == length) ? 11 : 10);
+}
+#endif
+
+/**
+ * @brief Tests if the line [@param first, @param last) is a valid ISBN-10 or ISBN-13 number.
+ *      A trailing '\r' is ignored. @param buffer_end is the end of the buffer containing the line,
+ *      bytes upto it may be read when validating with vector instructions.
+ */
+bool IsValidISBNLine(const char *first, const char *last, const char *buffer_end)
+{
+    if (first != last && '\r' == *(last - 1)) { --last; }
+    const auto kLength = static_cast<size_t>(last - first);
+    if (10 != kLength && 13 != kLength) { return false; }
+#if defined(__SSSE3__)
+    if (buffer_end - first >= 16) { return IsValidISBN16Bytes(first, kLength); }
+
+    auto padded = array<char, 16>{};
+    std::memcpy(padded.data(), first, kLength);
+    return IsValidISBN16Bytes(padded.data(), kLength);
+#else
+    (void)buffer_end;
+    const auto kIsbn = string_view{ first, kLength };
+    return IsValidISBN_10(kIsbn) || IsValidISBN_13(kIsbn);
+#endif
+}
+
+/**
+ * @brief Read-only memory mapping of a whole file. Mapping is released on destruction.
+ */
+class MappedFile
+{
+public:
+    MappedFile(const MappedFile &) = delete;
+    MappedFile& operator=(const MappedFile &) = delete;
+
+    /**
+     * @brief Maps @param path into memory. is_open() returns false if the file can not be opened
+     *      or mapped. An empty file is opened successfully with an empty view.
+     */
+    explicit MappedFile(string_view path)
+    {
+        const auto kFd = open(string{ path }.c_str(), O_RDONLY);
+        if (-1 == kFd) { return; }
+
+        struct stat file_stat{};
+        if (0 == fstat(kFd, &file_stat))
+        {
+            size_ = static_cast<size_t>(file_stat.st_size);
+            if (0 == size_)
+            {
+                is_open_ = true;
+            }
+            else if (auto *mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, kFd, 0); MAP_FAILED != mapping)
+            {
+                madvise(mapping, size_, MADV_SEQUENTIAL);
+                data_    = static_cast<const char *>(mapping);
+                is_open_ = true;
+            }
+        }
+        close(kFd);
+    }
+
+    ~MappedFile()
+    {
+        if (nullptr != data_) { munmap(const_cast<char *>(data_), size_); }
+    }
+
+    bool is_open() const { return is_open_; }
+    string_view View() const { return (nullptr != data_) ? string_view{ data_, size_ } : string_view{}; }
+
+private:
+    const char *data_    = nullptr;
+    size_t      size_    = 0;
+    bool        is_open_ = false;
+};
+
+/**
+ * @brief Result of ValidateISBNFile().
+ */
+struct ISBNFileReport
+{
+    size_t           line_count  = 0;
+    size_t           valid_count = 0;
+    vector<uint64_t> valid_lines; // bitmap, bit i is set if line i is a valid ISBN-10 or ISBN-13
+
+    bool IsValidLine(const size_t &line) const { return 0 != ((valid_lines[line / 64] >> (line % 64)) & 1); }
+};
+
+/**
+ * @brief Validates every line of the file @param path, see IsValidISBNLine(). A last line without
+ *      '\n' is also validated.
+ *      File is divided into @param thread_count chunks which are validated in parallel. Each thread
+ *      builds a bitmap for lines of its chunk, chunk bitmaps are concatenated at the end.
+ * @param path
+ * @param filtered_output_path - if not empty, valid lines are written to this file in input order
+ * @param thread_count - 0 is treated as 1
+ * @return report for all lines, or an empty optional if @param path can not be opened.
+ */
+optional<ISBNFileReport> ValidateISBNFile(string_view path, string_view filtered_output_path = {},
+    size_t thread_count = thread::hardware_concurrency())
+{
+    struct ChunkResult
+    {
+        size_t           line_count  = 0;
+        size_t           valid_count = 0;
+        vector<uint64_t> valid_lines;
+        string           filtered;
+    };
+
+    const auto kFile = MappedFile{ path };
+    if (!kFile.is_open()) { return {}; }
+
+    const auto kText     = kFile.View();
+    const auto *kBegin   = kText.data();
+    const auto *kEnd     = kText.data() + size(kText);
+    const auto kFiltered = !filtered_output_path.empty();
+    thread_count         = std::clamp<size_t>(thread_count, 1, std::max<size_t>(size(kText) / 4096, 1));
+
+    // Chunk i is [boundaries[i], boundaries[i + 1]), every boundary except the last one is a start of a line
+    auto boundaries = vector<const char *>{ kBegin };
+    for (auto chunk = size_t{ 1 }; chunk < thread_count ;++chunk)
+    {
+        const auto *kNewline = FindNewline(std::max(kBegin + size(kText) * chunk / thread_count, boundaries.back()), kEnd);
+        boundaries.push_back((kNewline == kEnd) ? kEnd : kNewline + 1);
+    }
+    boundaries.push_back(kEnd);
+
+    auto results = vector<ChunkResult>(thread_count);
+    auto threads = vector<thread>{};
+    for (auto chunk = size_t{ 0 }; chunk < thread_count ;++chunk)
+    {
+        threads.push_back(thread{ [&result = results[chunk], first = boundaries[chunk], last = boundaries[chunk + 1], kEnd, kFiltered]()
+        {
+            for (auto *line = first; line != last ;)
+            {
+                const auto *kLineEnd = FindNewline(line, last);
+                if (0 == result.line_count % 64) { result.valid_lines.push_back(0); }
+                if (IsValidISBNLine(line, kLineEnd, kEnd))
+                {
+                    result.valid_lines.back() |= uint64_t{ 1 } << (result.line_count % 64);
+                    ++result.valid_count;
+                    if (kFiltered) { result.filtered.append(line, kLineEnd).push_back('\n'); }
+                }
+                ++result.line_count;
+                line = (kLineEnd == last) ? last : kLineEnd + 1;
+            }
+        }});
+    }
+    for (auto &t : threads) { t.join(); }
+
+    auto report   = ISBNFileReport{};
+    auto filtered = std::ofstream{};
+    if (kFiltered) { filtered.open(string{ filtered_output_path }, std::ios::binary | std::ios::trunc); }
+    for (const auto &result : results)
+    {
+        // Append chunk bitmap, shifted by the number of lines already in the report
+        const auto kShift = report.line_count % 64;
+        for (auto idx = size_t{ 0 }; idx < size(result.valid_lines) ;++idx)
+        {
+            const auto kWord = result.valid_lines[idx];
+            if (0 == kShift) { report.valid_lines.push_back(kWord); continue; }
+
+            report.valid_lines.back() |= kWord << kShift;
+            if (idx * 64 + (64 - kShift) < result.line_count) { report.valid_lines.push_back(kWord >> (64 - kShift)); }
+        }
+        report.line_count  += result.line_count;
+        report.valid_count += result.valid_count;
+        if (kFiltered) { filtered.write(result.filtered.data(), size(result.filtered)); }
+    }
+    return report;
+}
+
+/**
+ * @brief Returns the next line of a random catalog, a 10 digit line for even @param idx and a 13 digit
+ *      line otherwise. About half of the lines have their check digit corrected to make them valid.
+ *      Same seeded @param generator gives same lines, so a catalog can be checked without storing it.
+ */
+string RandomCatalogLine(std::mt19937_64 &generator, const size_t &idx)
+{
+    auto line = std::to_string(generator() % 10'000'000'000'000);
+    line.resize((0 == idx % 2) ? 10 : 13, '7');
+    if (0 == generator() % 2)
+    {
+        for (auto digit = '0'; digit <= '9' ;++digit)
+        {
+            line.back() = digit;
+            if (IsValidISBN_10(line) || IsValidISBN_13(line)) { break; }
+        }
+    }
+    return line;
+}
+
+int main(int argc, char *argv[])
 {
     auto str = string{};
     cout << "Enter ISBN to validate: ";
@@ -138,5 +422,39 @@ int main()
 
     cout << "ISBN-10 validation status : " << std::boolalpha << IsValidISBN_10(str) << '\n';
     cout << "ISBN-13 validation status : " << std::boolalpha << IsValidISBN_13(str) << '\n';
+
+    // Number of catalog lines can be given as first argument e.g. 10000000 for benchmarking
+    constexpr auto kSeed         = uint64_t{ 14 };
+    const auto kLineCount        = (argc > 1) ? static_cast<size_t>(std::stoull(argv[1])) : size_t{ 100'000 };
+    const auto kDirectory        = std::filesystem::temp_directory_path();
+    const auto kCatalogFile      = (kDirectory / "isbn_catalog.txt").string();
+    const auto kFilteredFile     = (kDirectory / "isbn_catalog_valid.txt").string();
+    {
+        auto generator = std::mt19937_64{ kSeed };
+        auto catalog   = std::ofstream{ kCatalogFile, std::ios::binary | std::ios::trunc };
+        for (auto idx = size_t{ 0 }; idx < kLineCount ;++idx)
+        {
+            catalog << RandomCatalogLine(generator, idx) << '\n';
+        }
+    }
+
+    const auto kStartTimepoint = steady_clock::now();
+    const auto kReport         = ValidateISBNFile(kCatalogFile, kFilteredFile);
+    const auto kSeconds        = duration<double>(steady_clock::now() - kStartTimepoint).count();
+    assert(kReport && kReport->line_count == kLineCount);
+    auto generator = std::mt19937_64{ kSeed };
+    for (auto idx = size_t{ 0 }; idx < kLineCount ;++idx)
+    {
+        const auto kLine = RandomCatalogLine(generator, idx);
+        assert(kReport->IsValidLine(idx) == (IsValidISBN_10(kLine) || IsValidISBN_13(kLine)));
+    }
+    {
+        auto filtered = std::ifstream{ kFilteredFile, std::ios::binary };
+        assert(static_cast<size_t>(std::count(std::istreambuf_iterator<char>{ filtered }, std::istreambuf_iterator<char>{}, '\n')) == kReport->valid_count);
+    }
+    cout << "Validated " << kReport->line_count << " lines of " << kCatalogFile << " in " << kSeconds << " seconds, "
+         << kReport->valid_count << " valid ISBNs written to " << kFilteredFile << '\n';
+    std::filesystem::remove(kCatalogFile);
+    std::filesystem::remove(kFilteredFile);
     return 0;
 }
\ No newline at end of file
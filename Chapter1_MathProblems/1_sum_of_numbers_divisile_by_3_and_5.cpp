@@ -105,6 +105,7 @@ auto Soln(unsigned int limit)
     return sum;
 }
 
+#if !defined(MATH_KERNELS_BENCHMARK) // benchmark_math_kernels.cpp includes this file for its solution
 int main()
 {
     cout << "Please enter a number: ";
@@ -130,4 +131,5 @@ int main()
 
 
     return 0;
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
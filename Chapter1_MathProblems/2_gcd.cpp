@@ -2,23 +2,42 @@
  * @file 2_gcd.cpp
  * @author Usama Tayyab (usamatayyab9@gmail.com)
  * @brief
- *          Compilation command: g++ -std=c++17 2_gcd.cpp
+ *          Compilation command: g++ -std=c++20 -O2 2_gcd.cpp
  *          This file serves as the solution to Problem 2, which involves calculating gcd
  *          of two numbers. It corresponds to Chapter 1's Math Problems in the book "The Modern C++ Challenge"
  *          (available on Amazon: https://www.amazon.com/Modern-Challenge-programmer-real-world-problems/dp/1788993861). 
  *          
+ *          Two implementations are provided:
+ *          1. GCD() which uses Euclidean algorithm, one division per step.
+ *          2. BinaryGCD() which uses Stein's algorithm. It only uses shifts and subtractions,
+ *             all factors of 2 are removed at once by counting trailing zeros(std::countr_zero).
+ *             64-bit division takes tens of cycles on many CPUs, which BinaryGCD() avoids completely.
+ *             For more info visit https://en.wikipedia.org/wiki/Binary_GCD_algorithm
+ *          
  *          Driver code:
  *          Program start by taking two numbers from user as input on the console.
  *          Then prints their greatest common divisor(gcd).  
+ *          Then compares time taken by GCD() and BinaryGCD() for random pairs of numbers.
  * 
  * 
  * @copyright Copyright (c) 2023
  */
 #include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <bit>
+#include <utility>
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
 
 using std::cin;
 using std::cout;
 using std::endl;
+using std::vector;
+using std::chrono::steady_clock;
+using std::chrono::duration;
 
 /**
  * @brief 
@@ -34,6 +53,38 @@ auto GCD(const size_t &a, const size_t &b)
 	return GCD(b, a % b);
 }
 
+/**
+ * @brief 
+ *          Uses Stein's algorithm(binary gcd) for computing greatest common divisor of two elements.
+ *          gcd(2^i * a', 2^j * b') = 2^min(i, j) * gcd(a', b'), where a' and b' are odd. For two odd
+ *          numbers gcd(a, b) = gcd(|a - b|, min(a, b)) and |a - b| is even, so its trailing zeros are
+ *          removed before the next step.
+ * @param   a 
+ * @param   b 
+ * @return  Greatest common divisor of a and b 
+ */
+uint64_t BinaryGCD(uint64_t a, uint64_t b)
+{
+    if (0 == a) { return b; }
+    if (0 == b) { return a; }
+
+    const auto kCommonTwos = std::countr_zero(a | b);
+    auto a_twos            = std::countr_zero(a);
+    b >>= std::countr_zero(b);
+    while (0 != a)
+    {
+        /*! Trailing zeros of the difference are counted while min(a, b) is being computed,
+            which keeps the dependency chain of each iteration short. */
+        a >>= a_twos;
+        const auto kDifference = b - a;
+        const auto kAbsolute   = (a > b) ? a - b : kDifference;
+        a_twos                 = std::countr_zero(kDifference); // same as trailing zeros of |b - a|
+        b                      = std::min(a, b);
+        a                      = kAbsolute;
+    }
+    return b << kCommonTwos;
+}
+
 int main()
 {
     auto a = size_t{ 0 };
@@ -42,7 +93,25 @@ int main()
     cout << "Enter first number  : "; cin >> a;
     cout << "Enter second number : "; cin >> b;
     
-    cout << "gcd(" << a << "," << b << ") = " << GCD(a, b);
+    cout << "gcd(" << a << "," << b << ") = " << GCD(a, b) << '\n';
     
+    constexpr auto kPairCount = size_t{ 10'000'000 };
+    auto generator            = std::mt19937_64{ 2 };
+    auto pairs                = vector<std::pair<uint64_t, uint64_t>>(kPairCount);
+    for (auto &[x, y] : pairs) { x = generator(); y = generator(); }
+
+    const auto kTime = [&pairs](const auto &gcd)
+    {
+        const auto kStartTimepoint = steady_clock::now();
+        auto checksum              = uint64_t{ 0 };
+        for (const auto &[x, y] : pairs) { checksum += gcd(x, y); }
+        return std::pair{ checksum, duration<double>(steady_clock::now() - kStartTimepoint).count() };
+    };
+    const auto [kEuclidChecksum, kEuclidSeconds] = kTime([](const uint64_t &x, const uint64_t &y) { return GCD(x, y); });
+    const auto [kBinaryChecksum, kBinarySeconds] = kTime(BinaryGCD);
+    assert(kEuclidChecksum == kBinaryChecksum);
+    cout << "gcd of " << kPairCount << " random pairs:\n";
+    cout << "    GCD()       : " << kEuclidSeconds << " seconds\n";
+    cout << "    BinaryGCD() : " << kBinarySeconds << " seconds\n";
     return 0;
 }
\ No newline at end of file
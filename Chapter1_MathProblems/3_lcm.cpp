@@ -2,18 +2,28 @@
  * @file 3_lcm.cpp
  * @author Usama Tayyab (usamatayyab9@gmail.com)
  * @brief 
- *          Compilation command: g++ -std=c++17 3_lcm.cpp
+ *          Compilation command: g++ -std=c++20 -O2 3_lcm.cpp -lpthread
  *          This file is solution to "Problem 3 : Least common multiple" of book
  *          The Modern C++ Challenge(available at amazon https://www.amazon.com/Modern-Challenge-programmer-real-world-problems/dp/1788993861)
  *          The lcm is calculted using gcd. gcd function is same as in problem 2(2_gcd.cpp).
  *          This file provides two functions for calculating least common multiple(lcm):
  *          1. LCM which calculates the lcm of two numbers.
  *          2. LCMOfMany which calculates lcm of multiples numbers.
+ *          LCMOfMany silently overflows when the lcm does not fit in the element type. For large
+ *          inputs of 64-bit numbers the following are provided:
+ *          3. BinaryGCD which is same as in problem 2(2_gcd.cpp), it uses shifts instead of divisions.
+ *          4. CheckedLCM which computes the lcm of two numbers using a 128-bit product, and reports
+ *             overflow instead of wrapping around.
+ *          5. ParallelLCMOfMany which divides the input into one chunk per thread, each thread folds
+ *             its chunk using CheckedLCM, and the partial results are then combined pairwise in a tree.
+ *             Threads stop early once any of them overflows.
  * 
  *          Driver code:
  *          The program start by initializing a vector with two elements 4 and 6.
  *          Then prints these elements, the caculates their lcm using LCMOfMany function
  *          and finally prints the result.
+ *          Then computes lcm of millions of random periods using a sequential fold of CheckedLCM and
+ *          using ParallelLCMOfMany, and prints their timings. Also shows that overflow is detected.
  * 
  * @copyright Copyright (c) 2023
  * 
@@ -25,6 +35,16 @@
 #include <vector>
 #include <iterator>
 #include <type_traits>
+#include <optional>
+#include <span>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <chrono>
+#include <bit>
+#include <limits>
+#include <cassert>
+#include <cstdint>
 
 using std::cin;
 using std::cout;
@@ -36,6 +56,13 @@ using std::cend;
 using std::copy;
 using std::ostream_iterator;
 using std::vector;
+using std::optional;
+using std::span;
+using std::thread;
+using std::chrono::steady_clock;
+using std::chrono::duration;
+
+using uint128_t = unsigned __int128;
 
 /**
  * @brief 
@@ -75,6 +102,99 @@ auto LCMOfMany(const Container &c)
     return lcm;
 }
 
+/**
+ * @brief 
+ *          Uses Stein's algorithm(binary gcd) for computing greatest common divisor of two elements.
+ *          Same as BinaryGCD in problem 2(2_gcd.cpp).
+ * @param   a 
+ * @param   b 
+ * @return  Greatest common divisor of a and b 
+ */
+uint64_t BinaryGCD(uint64_t a, uint64_t b)
+{
+    if (0 == a) { return b; }
+    if (0 == b) { return a; }
+
+    const auto kCommonTwos = std::countr_zero(a | b);
+    auto a_twos            = std::countr_zero(a);
+    b >>= std::countr_zero(b);
+    while (0 != a)
+    {
+        a >>= a_twos;
+        const auto kDifference = b - a;
+        const auto kAbsolute   = (a > b) ? a - b : kDifference;
+        a_twos                 = std::countr_zero(kDifference);
+        b                      = std::min(a, b);
+        a                      = kAbsolute;
+    }
+    return b << kCommonTwos;
+}
+
+/**
+ * @brief Calculates lcm of @param a and @param b as (a / gcd(a, b)) * b. The product is computed
+ *      in 128 bits, so overflow is detected exactly. lcm is 0 if either of them is 0.
+ *      When folding many numbers the running lcm is usually already a multiple of the next number,
+ *      that case is checked first as it needs a single division instead of a gcd.
+ * @return lcm of a and b, or an empty optional if it does not fit in 64 bits.
+ */
+optional<uint64_t> CheckedLCM(const uint64_t &a, const uint64_t &b)
+{
+    if (0 == a || 0 == b) { return 0; }
+    if (0 == a % b)       { return a; }
+
+    const auto kProduct = uint128_t{ a / BinaryGCD(a, b) } * b;
+    auto result         = optional<uint64_t>{};
+    if (kProduct <= std::numeric_limits<uint64_t>::max()) { result = static_cast<uint64_t>(kProduct); }
+    return result;
+}
+
+/**
+ * @brief Calculates lcm of all elements of @param numbers, 1 if @param numbers is empty.
+ *      numbers are divided into @param thread_count contiguous chunks. Each thread folds its chunk
+ *      with CheckedLCM, then the partial lcms are combined pairwise, halving their count at every
+ *      level, until one remains. Once a thread overflows the others stop at their next check.
+ *      A chunk whose lcm becomes 0 also stops early as the total lcm is 0 then.
+ * @param numbers
+ * @param thread_count - 0 is treated as 1
+ * @return lcm, or an empty optional if lcm does not fit in 64 bits.
+ */
+optional<uint64_t> ParallelLCMOfMany(span<const uint64_t> numbers, size_t thread_count = thread::hardware_concurrency())
+{
+    constexpr auto kCheckInterval = size_t{ 4096 }; // elements folded between checks of the overflow flag
+    thread_count                  = std::clamp(thread_count, size_t{ 1 }, std::max(size(numbers), size_t{ 1 }));
+    const auto kChunk             = (size(numbers) + thread_count - 1) / thread_count;
+
+    auto overflowed = std::atomic<bool>{ false };
+    auto partials   = vector<optional<uint64_t>>(thread_count, uint64_t{ 1 });
+    auto threads    = vector<thread>{};
+    for (auto chunk = size_t{ 0 }; chunk < thread_count ;++chunk)
+    {
+        threads.push_back(thread{ [numbers, chunk, kChunk, &overflowed, &lcm = partials[chunk]]()
+        {
+            const auto kFirst = std::min(chunk * kChunk, size(numbers));
+            const auto kLast  = std::min(kFirst + kChunk, size(numbers));
+            for (auto idx = kFirst; idx < kLast && lcm && 0 != *lcm ;++idx)
+            {
+                if (0 == (idx - kFirst) % kCheckInterval && overflowed.load(std::memory_order_relaxed)) { return; }
+                lcm = CheckedLCM(*lcm, numbers[idx]);
+            }
+            if (!lcm) { overflowed.store(true, std::memory_order_relaxed); }
+        }});
+    }
+    for (auto &t : threads) { t.join(); }
+    if (overflowed.load()) { return {}; }
+
+    for (auto stride = size_t{ 1 }; stride < size(partials) ;stride *= 2)
+    {
+        for (auto idx = size_t{ 0 }; idx + stride < size(partials) ;idx += 2 * stride)
+        {
+            partials[idx] = CheckedLCM(*partials[idx], *partials[idx + stride]);
+            if (!partials[idx]) { return {}; }
+        }
+    }
+    return partials[0];
+}
+
 int main()
 {
     auto elements = vector{4, 6};
@@ -84,7 +204,31 @@ int main()
         cout << elem << " ";
     }
     auto i = LCMOfMany(elements);
-    cout << " is " << LCMOfMany(elements);
-    
+    cout << " is " << LCMOfMany(elements) << '\n';
+
+    // lcm of 1...46 fits in 64 bits, lcm of 1...47 does not
+    constexpr auto kPeriodCount = size_t{ 20'000'000 };
+    constexpr auto kMaxPeriod   = uint64_t{ 46 };
+    auto generator              = std::mt19937_64{ 3 };
+    auto periods                = vector<uint64_t>(kPeriodCount);
+    for (auto &period : periods) { period = generator() % kMaxPeriod + 1; }
+
+    auto start_timepoint = steady_clock::now();
+    auto sequential_lcm  = optional<uint64_t>{ 1 };
+    for (auto idx = size_t{ 0 }; idx < size(periods) && sequential_lcm ;++idx) { sequential_lcm = CheckedLCM(*sequential_lcm, periods[idx]); }
+    const auto kSequentialSeconds = duration<double>(steady_clock::now() - start_timepoint).count();
+
+    start_timepoint             = steady_clock::now();
+    const auto kParallelLCM     = ParallelLCMOfMany(periods);
+    const auto kParallelSeconds = duration<double>(steady_clock::now() - start_timepoint).count();
+    assert(sequential_lcm && sequential_lcm == kParallelLCM);
+
+    cout << "LCM of " << kPeriodCount << " periods in [1, " << kMaxPeriod << "] is " << *kParallelLCM << '\n';
+    cout << "    Sequential CheckedLCM : " << kSequentialSeconds << " seconds\n";
+    cout << "    ParallelLCMOfMany     : " << kParallelSeconds << " seconds\n";
+
+    periods.back() = kMaxPeriod + 1;
+    cout << "After replacing last period with " << kMaxPeriod + 1 << " LCM "
+         << (ParallelLCMOfMany(periods) ? "fits" : "overflows") << " in 64 bits\n";
     return 0;
 }
\ No newline at end of file
@@ -2,18 +2,24 @@
  * @file 4_largest_prime_smaller_than_given_number.cpp
  * @author Usama Tayyab (usamatayyab9@gmail.com)
  * @brief 
- *          Compilation command : g++ -std=c++17 ./4_largest_prime_smaller_than_given_number.cpp
+ *          Compilation command : g++ -std=c++20 -O2 ./4_largest_prime_smaller_than_given_number.cpp -lpthread
  * 
  *          This file is solution to "Problem 4: Largest prime smaller than given number"
  *          mentioned in "Chapter 1: Math Problems" of the book:
  *              - The Modern C++ Challenge(available at amazon https://www.amazon.com/Modern-Challenge-programmer-real-world-problems/dp/1788993861)
  *          
  *          This file contains two functions IsPrime() and LargestPrimeSmallerThanN() see their comments section
- *          for their implemntation.
+ *          for their implemntation. LargestPrimeSmallerThanN() is backed by the segmented sieve from
+ *          prime_sieve.h, so it can answer inputs upto 10^12 using only an L2-sized buffer. IsPrime() is
+ *          the trial division test, and is kept for verifying the result of the sieve.
+ *          PrimeCount() from prime_counting.h counts primes upto N without enumerating them, using
+ *          Meissel's formula. It counts primes below 10^14 in seconds.
  *          Driver code:
  *          The program start by taking an input number(N) from the user, then computes the largest prime
  *          smaller than 'n' using function LargestPrimeSmallerThanN(). If no such prime exists it prints
  *          the message "No prime number exist smaller than <n>" otherwise prints the computed prime number.
+ *          Then prints the number of primes upto N. Timings of PrimeCount() for powers of 10 are measured by
+ *          benchmark_math_kernels.cpp.
  * 
  * 
  * @copyright Copyright (c) 2023
@@ -23,6 +29,11 @@
 #include <cmath>
 #include <utility>
 #include <optional>
+#include <cassert>
+#include <cstdint>
+
+#include "prime_sieve.h"
+#include "prime_counting.h"
 
 using std::cin;
 using std::cout;
@@ -70,7 +81,9 @@ bool IsPrime(const auto &N)
  *            ouput for function will be an empty std::optional value.
  *          - Similary for N == 1 and N == 2, no primes exist of lesser value.
  *          - For N == 3, 2 is the answer as it is smaller than it and also prime number.
- *          - Search the range [N - 1, 1], and stop on the first prime found.  
+ *          - Search the range [N - 1, 1], and stop on the first prime found. The search is done
+ *            by SegmentedPrimeSieve::PrevPrime() which sieves a segment of odd numbers below N
+ *            instead of testing each candidate with trial division.
  *          - NOTE: It is possible that N itself is prime number, and problem clearly states that
  *            result must be smaller than N. Hence in this case result can not be N. That is
  *            the reason search starts from N - 1.
@@ -83,31 +96,33 @@ auto LargestPrimeSmallerThanN(auto N)
     auto result = optional<decltype(N)>{};
     if (N >= 3)
     {
-        for (auto i = N - 1; i > 1 ;--i)
+        const auto kSieve = SegmentedPrimeSieve{ static_cast<uint64_t>(N), 1 };
+        if (const auto kPrime = kSieve.PrevPrime(static_cast<uint64_t>(N)); kPrime)
         {
-            if (IsPrime(i)) {
-                result = i;
-                break;
-            }
+            result = static_cast<decltype(N)>(kPrime.value());
         }
     }
     return result;
 }
 
+#if !defined(MATH_KERNELS_BENCHMARK) // benchmark_math_kernels.cpp includes this file for its solution
 int main()
 {
-    auto i = 0;
+    auto i = int64_t{ 0 };
     cout << "Enter a number: ";
     cin >> i;
 
     auto result = LargestPrimeSmallerThanN(i);
     if (result)
     {
+        assert(IsPrime(result.value()));
         cout << "Largest prime smaller than " << i << " is : " << result.value();
     }
     else
     {
         cout << "No prime number exist smaller than " << i;
     }
+    cout << "\nNumber of primes upto " << i << " : " << ((i > 1) ? PrimeCount(static_cast<uint64_t>(i)) : 0) << '\n';
     return 0;
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
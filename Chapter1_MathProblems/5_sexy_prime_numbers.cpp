@@ -2,7 +2,7 @@
  * @file 5_sexy_prime_numbers.cpp
  * @author Usama Tayyab (usamatayyab@gmail.com)
  * @brief 
- *          Compilation command : g++ -std=c++17 5_sexy_prime_numbers.cpp
+ *          Compilation command : g++ -std=c++20 -O2 5_sexy_prime_numbers.cpp -lpthread
  *          This file is solution to "Problem 5. Sexy prime pairs"
  *          mentioned in "Chapter 1: Math Problems" of the book:
  *              - The Modern C++ Challenge(available at amazon https://www.amazon.com/Modern-Challenge-programmer-real-world-problems/dp/1788993861)
@@ -14,72 +14,55 @@
  *              - 11 and 17
  *              - 13 and 19
  *          
- *          This file contains two functions IsPrime() and PrintAllSexyPrimesUptoN(). See function definition for more details.
+ *          This file contains the function PrintAllSexyPrimesUptoN(), which enumerates primes using the
+ *          multi-threaded segmented sieve from prime_sieve.h. See function definition for more details.
  *          Driver code:
  *          Program start by taking a number input from user and then prints all sexy primes upto it.
  *  
  * @copyright Copyright (c) 2023
  */
 #include <iostream>
-#include <utility>
-#include <cmath>
+#include <cstdint>
+#include <deque>
+
+#include "prime_sieve.h"
 
 using std::cin;
 using std::cout;
+using std::deque;
 using std::endl;
-using std::pair;
-using std::sqrt;
 
 /**
- * @brief   Tests whether a given number is prime or not.
+ * @brief   Prints all pairs of sexy primes (p, p + 6) where p <= @param N.
  * @details
- *          - Check # 1: Any number <= 1 is not a prime number.
- *          - Check # 2: Only even no. that is prime is 2 rest are all odd.
- *          - Traverses all numbers in range [3, sqrt(@param N)]. If N is divisible
- *            by any number in the range, then it considered not to be a prime.
+ *          Primes upto N + 6 are visited in increasing order using SegmentedPrimeSieve::ForEachPrime().
+ *          Primes <= N that are seen within the last 6 numbers are kept in a small queue. When a prime
+ *          q is visited, primes smaller than q - 6 are dropped from the front of the queue, and if the
+ *          front of the queue is q - 6 then (q - 6, q) is a sexy prime pair.
+ *          Since 2 can not form a sexy prime with 8 so search begins with 3.
  * @param   N
- * @return  true, if N is prime 
- * @return  false, if N is not a prime
  */
-bool IsPrime(const auto &N)
-{
-    auto is_prime = false;
-    if (N > 1) //1 is not prime number
-    {
-        if ((1 == (N & 1)) || (2 == N)) //even-odd test. Only odd numbers are prime, 2 is only prime number that is even
-        {
-            is_prime = true;
-            for (auto [i, limit] = pair{ 3, sqrt(N) }; i <= limit ;i += 2)
-            {
-                if (0 == (N % i))
-                {
-                    is_prime = false;
-                    break;
-                }
-            }
-        }
-    }
-    return is_prime;
-}
-
 void PrintAllSexyPrimesUptoN(const auto N)
 {
-    /*!
-        Since 2 can not form a sexy prime with 8 so search begins with 3.
-    */
-    constexpr auto three = std::integral_constant<decltype(N), 3>::value; //For avoiding integral type issues i.e. overflow
-    for (auto i = three; i <= N ;i += 2)
+    if (N < 3) { return; }
+
+    const auto kLimit = static_cast<uint64_t>(N) + 6;
+    const auto kSieve = SegmentedPrimeSieve{ kLimit };
+    auto recent_primes = deque<uint64_t>{};
+    kSieve.ForEachPrime(3, kLimit, [&recent_primes, N](const uint64_t &prime)
     {
-        if (IsPrime(i) && IsPrime(i + 6))
+        while (!recent_primes.empty() && recent_primes.front() + 6 < prime) { recent_primes.pop_front(); }
+        if (!recent_primes.empty() && recent_primes.front() + 6 == prime)
         {
-            cout << i << " , " << i + 6 << endl;
+            cout << recent_primes.front() << " , " << prime << '\n';
         }
-    }
+        if (prime <= static_cast<uint64_t>(N)) { recent_primes.push_back(prime); }
+    });
 }
 
 int main()
 {
-    auto i = 0;
+    auto i = int64_t{ 0 };
     cout << "Enter a number: ";
     cin >> i;
 
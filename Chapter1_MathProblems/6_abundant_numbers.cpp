@@ -2,7 +2,7 @@
  * @file 6_abundant_numbers.cpp
  * @author Usama Tayyab (usamatayyab9@gmail.com)
  * @brief 
- *          Compilation command: g++ -std=c++17 6_abundant_numbers.cpp
+ *          Compilation command: g++ -std=c++20 -O2 6_abundant_numbers.cpp -lpthread
  * 
  *          This file is solution to "Problem 6.  Abundant numbers"
  *          mentioned in "Chapter 1: Math Problems" of the book:
@@ -20,6 +20,8 @@
  *          Driver code: 
  *          The program starts by taking a number `N` as input from user via the console.
  *          Then prints all the abundant numbers from 1 to N.
+ *          Sums of proper divisors of all numbers from 1 to N are computed at once using the
+ *          divisor sieve from divisor_sum_table.h.
  *          See function comments for implementation. 
  * 
  * 
@@ -27,62 +29,37 @@
  * 
  */
 #include <iostream>
-#include <utility>
+#include <cstdint>
+
+#include "divisor_sum_table.h"
 
 using std::cin;
 using std::cout;
 using std::endl;
-using std::pair;
 
 /**
  * @brief 
+ *      Prints all abundant numbers and their abundance from 1 to @param N.
  *      For reference proper divisor for a number is defined as:
  *          A positive divisor of n that is different from n is called a proper divisor.
  *          For more info, visit: https://en.wikipedia.org/wiki/Divisor
  *      
- *      Algorithm:
- *          N := Input parameter
- *          sum := 0, output parameter
- *          for i in range [1,N/2]:
- *              if N is divisible i:
- *                  add i to sum
- *          
- * @param N 
- * @return sum of all proper divisors of N
- */
-auto SumOfProperDivisors(const auto N)
-{
-    auto sum = size_t{ 1 };
-    for (auto [i, limit] = pair{ 2, N / 2 }; i <= limit ;++i)
-    {
-        if (0 == (N % i))
-        {
-            sum += i;
-        }
-    }
-    return sum;
-}
-
-/**
- * @brief 
- *      Prints all abundant numbers and their abundance from 1 to @param N.
- *      First initializes a variable 'i' with value 1 with the same type as of `N`.
- *      Loop until i is less than equal to N.
- *      Initializes a variable 'sum' with sum of proper divisors of i using the
- *      function `SumOfProperDivisors()`.
- *      Then test if sum is greater than i, if yes it means i is an abundant number
- *      and print i and its abundance.
+ *      First fills a DivisorSumTable with sum of proper divisors of all numbers from 1 to N.
+ *      Then for every i from 1 to N, test if sum is greater than i, if yes it means i is an
+ *      abundant number and print i and its abundance.
  * @param N 
  */
 void PrintAbundantNumbersUptoN(const auto N)
 {
-    using integral_type = decltype(N);
-    for (auto i = integral_type{ 1 }; i <= N ;++i)
+    if (N < 1) { return; }
+
+    const auto kSums = DivisorSumTable<uint64_t>{ static_cast<uint64_t>(N) };
+    for (auto i = uint64_t{ 1 }; i <= static_cast<uint64_t>(N) ;++i)
     {
-        auto sum = SumOfProperDivisors(i);
-        if (sum > i)
+        const auto kSum = kSums[i];
+        if (kSum > i)
         {
-            cout << i << ", abundance = " << sum - i << endl;
+            cout << i << ", abundance = " << kSum - i << endl;
         }
     }
 }
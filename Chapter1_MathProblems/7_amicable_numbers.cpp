@@ -2,7 +2,7 @@
  * @file 7_amicable_numbers.cpp
  * @author Usama Tayyab (usamatayyab@gmail.com)
  * @brief
- *      Compilation command: g++ -std=c++17 7_amicable_numbers.cpp
+ *      Compilation command: g++ -std=c++20 -O2 7_amicable_numbers.cpp -lpthread
  * 
  *      This file is solution to "Problem 7. Amicable numbers"
  *      mentioned in "Chapter 1: Math Problems" of the book:
@@ -22,8 +22,9 @@
  *      Since it is stated in the problem that only amicable numbers upto 1,000,000 are required, this
  *      limit is expressed by constant variable `kLimit`.
  *      This file contains two methods of generating amicable numbers. One method generates amicable
- *      numbers at run-time while the other generates at compile-time. Two functions `SumOfProperDivisors()`
- *      and `PrintAmicableNumbers()` in accordance with each other generates amicable numbe at run-time.
+ *      numbers at run-time while the other generates at compile-time. The function `PrintAmicableNumbers()`
+ *      generates amicable numbers at run-time, using the sums of proper divisors computed by the
+ *      multi-threaded divisor sieve `DivisorSumTable`(see divisor_sum_table.h).
  *      Where as for compile-time functionality it is implemented in namespace `AmicablesNumbersConstepxr`.
  *      
  *      @note  constexpr version is tested for kLimit=10000. Hence compiling for values greater than
@@ -46,10 +47,12 @@
 #include <iterator>
 #include <utility>
 #include <vector>
-#include <unordered_set>
 #include <cmath>
 #include <type_traits>
 #include <chrono>
+#include <cstdint>
+
+#include "divisor_sum_table.h"
 
 using std::array;
 using std::cin;
@@ -63,72 +66,32 @@ using std::vector;
 using std::pair;
 using std::sqrt;
 using std::transform;
-using std::unordered_set;
 using std::chrono::steady_clock;
 using std::chrono::milliseconds;
 using std::chrono::duration_cast;
 
 inline constexpr auto kLimit = 1'000'000;
 
-/**
- * @brief 
- *      Calculates the sum of all proper divisors of @param N.
- *      Iterates through potential divisors in the range [2,sqrt(N)].
- *      Adds them to the sum if they are divisors. Additionally, it
- *      checks if the corresponding divisor (N/i) is different from
- *      the current divisor (i) and if it is also a divisor of N,
- *      adding it to the sum as well. This approach ensures that each
- *      divisor is added only once to the sum, including the cases
- *      where N/i is a divisor.
- * @param N 
- * @return sum of all proper divisors of @param N. 
- */
-auto SumOfProperDivisors(const auto N)
-{
-    auto sum = size_t{ 1 };
-    for (auto [i, limit] = pair{ 2, sqrt(N) }; i <= limit ;++i)
-    {
-        if (0 == (N % i))
-        {
-            sum += i;
-            /*! It might be possible that N/i is also divisible by N.
-                Now there are two cases:
-                1. For instance N = 12, i = 2:
-                    then, 12 % 2 == 0, add 2 to sum
-                    also 12 / 2 = 6 and 12 % 6 == 0, add 6 to sum too.
-                2. For instance N = 36, i = 6:
-                    then 36 % 6 == 0, add 6 to sum
-                    also 36 / 6 = 6 and 36 % 6 == 0, this time dont add 6 again.
-            */
-           if (auto second_divisior = N / i; second_divisior != i && (0 == N % second_divisior))
-           {
-               sum += second_divisior;
-           }
-        }
-    }
-    return sum;
-}
-
 /**
  * @brief 
  *      Prints all the amicable number from 2 to @param limit.
+ *      Sums of proper divisors of all numbers below limit are computed once using DivisorSumTable.
+ *      Entries are 32-bit, sums which do not fit are saturated, which is fine since such sums are
+ *      greater than limit and are skipped anyway.
+ *      A pair (i, sum(i)) is printed only when i < sum(i) and sum(sum(i)) == i. Hence each pair is
+ *      printed exactly once, smaller number first, without keeping track of already printed numbers.
  * @param limit 
  */
 void PrintAmicableNumbers(const size_t &limit)
 {
-    auto uset = unordered_set<size_t>{}; //For storing which elements are already printed
+    if (limit < 3) { return; }
+
+    const auto kSums = DivisorSumTable<uint32_t>{ limit - 1 };
     for (auto i = size_t{ 2 }; i < limit ;++i)
     {
-        if (uset.find(i) == cend(uset))
+        if (const auto kSum = size_t{ kSums[i] }; kSum > i && kSum < limit && kSums[kSum] == i)
         {
-            if (const auto kSum = SumOfProperDivisors(i); kSum < limit && kSum != i)
-            {
-                if (auto kSum2 = SumOfProperDivisors(kSum); kSum2 == i)
-                {
-                    uset.insert(kSum);
-                    cout << "(" << i << "," << kSum << ")\n";
-                }
-            }
+            cout << "(" << i << "," << kSum << ")\n";
         }
     }
 }
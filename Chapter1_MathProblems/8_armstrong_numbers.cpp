@@ -2,7 +2,7 @@
  * @file 8_armstrong_numbers.cpp
  * @author Usama Tayyab (usamtayyab9@gmail.com)
  * @brief 
- *      Compilation command: g++ -std=c++17 8_armstrong_numbers.cpp
+ *      Compilation command: g++ -std=c++20 -O2 8_armstrong_numbers.cpp -lpthread
  *      
  *      This file is solution to "Problem 8. Armstrong numbers"
  *      mentioned in "Chapter 1: Math Problems" of the book:
@@ -24,10 +24,15 @@
  *          fulfill a certain criteria(also speceified as parameter)
  *      3. IsArmstrong() which takes a number as input and return either true or false indicating whther 
  *          input number is armstrong or not.
+ *      Testing every number with IsArmstrong() only works for small ranges. For finding all armstrong
+ *      numbers(there are 88 of them, the largest has 39 digits) the class ArmstrongNumbersEnumerator is
+ *      provided, which enumerates digit multisets instead of numbers. See class comments.
  *      
  *      Driver code:
  *      The program first prints all 3-digit armstrong numbers. The prins all armstrong number upto
  *      a certain number specified by vairable.
+ *      Finally prints all armstrong numbers having upto `kMaxDigits` digits using ArmstrongNumbersEnumerator,
+ *      along with the time taken.
  *      See function comments for implementation details.
  * 
  * @copyright Copyright (c) 2023
@@ -35,6 +40,15 @@
  */
 #include <iostream>
 #include <cmath>
+#include <array>
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <limits>
+#include <chrono>
+#include <cstdint>
 
 using std::cin;
 using std::cout;
@@ -42,6 +56,16 @@ using std::endl;
 using std::pow;
 using std::log10;
 using std::floor;
+using std::array;
+using std::vector;
+using std::string;
+using std::thread;
+using std::atomic;
+using std::chrono::steady_clock;
+using std::chrono::milliseconds;
+using std::chrono::duration_cast;
+
+using uint128_t = unsigned __int128;
 
 /**
  * @brief Prints all 3-digit Armstrong numbers.
@@ -122,6 +146,237 @@ bool IsArmstrong(const size_t &N)
     return is_armstrong;
 }
 
+/**
+ * @brief Converts a 128-bit unsigned integer to its decimal string.
+ */
+string ToString(uint128_t N)
+{
+    auto str = string{};
+    do
+    {
+        str.insert(begin(str), static_cast<char>('0' + static_cast<int>(N % 10)));
+        N /= 10;
+    } while (0 != N);
+    return str;
+}
+
+/**
+ * @brief Finds all armstrong numbers having upto a given number of digits(at most 39).
+ * 
+ *      Sum of k-th powers of digits of a k-digit number does not depend on the order of its digits,
+ *      only on how many times each digit occurs. So instead of testing each of the 10^k numbers, every
+ *      multiset of k digits(combination with repetition) is visited once, there are only C(k + 9, 9)
+ *      of them i.e. about 1.7 * 10^9 for k = 39 instead of 10^39. For each multiset the power sum S is
+ *      computed, and S is an armstrong number if it has k digits and its digits occur exactly as many
+ *      times as in the multiset.
+ *      
+ *      Multisets are enumerated recursively, choosing how many times digit 9 occurs, then digit 8 and so on.
+ *      Powers d^k are precomputed in 128-bit integers for each length k. A branch is pruned when its
+ *      partial sum already exceeds the largest k-digit number, or when even filling all remaining
+ *      positions with the current digit can not reach the smallest k-digit number. Also every sum reachable
+ *      from a branch lies in a known range, and leading digits common to both ends of that range must be
+ *      present in the result, so a branch is pruned when its digit counts can not accommodate them.
+ *      
+ *      Work is divided into tasks, one per (length, count of digit 9) pair. Threads pick tasks from a
+ *      shared atomic counter, largest lengths first, and collect results in their own vectors which are
+ *      merged and sorted at the end.
+ *      
+ *      Largest value of unsigned __int128 has 39 digits, so for k = 39 it is used as the upper bound.
+ *      All additions and multiplications saturate at that value, so an overflowing branch is pruned.
+ */
+class ArmstrongNumbersEnumerator
+{
+public:
+    static constexpr auto kMaxDigits = size_t{ 39 };
+
+    /**
+     * @param max_digits - lengths from 1 to max_digits are searched, clamped to kMaxDigits.
+     * @param thread_count - 0 is treated as 1.
+     */
+    explicit ArmstrongNumbersEnumerator(const size_t &max_digits, const size_t &thread_count = thread::hardware_concurrency())
+        : max_digits_{ std::min(max_digits, kMaxDigits) }, thread_count_{ std::max(thread_count, size_t{ 1 }) }
+    {
+    }
+
+    /**
+     * @return All armstrong numbers having upto max_digits digits, in ascending order.
+     */
+    vector<uint128_t> operator()() const
+    {
+        auto tasks = vector<Task>{};
+        for (auto digits = max_digits_; digits >= 1 ;--digits)
+        {
+            for (auto nines = size_t{ 0 }; nines <= digits ;++nines) { tasks.push_back(Task{ digits, nines }); }
+        }
+
+        auto next_task      = atomic<size_t>{ 0 };
+        auto thread_results = vector<vector<uint128_t>>(thread_count_);
+        auto threads        = vector<thread>{};
+        for (auto &results : thread_results)
+        {
+            threads.push_back(thread{ [this, &tasks, &next_task, &results]()
+            {
+                for (auto idx = next_task++; idx < size(tasks) ;idx = next_task++)
+                {
+                    const auto kLength   = MakeLengthTables(tasks[idx].digits);
+                    const auto kNineSum  = SaturatingMultiply(tasks[idx].nines, kLength.powers[9]);
+                    auto counts          = array<size_t, 10>{};
+                    counts[9]            = tasks[idx].nines;
+                    if (kNineSum <= kLength.upper)
+                    {
+                        Search(kLength, 8, tasks[idx].digits - tasks[idx].nines, kNineSum, counts, results);
+                    }
+                }
+            }});
+        }
+        for (auto &t : threads) { t.join(); }
+
+        auto armstrong_numbers = vector<uint128_t>{};
+        for (const auto &results : thread_results)
+        {
+            armstrong_numbers.insert(end(armstrong_numbers), cbegin(results), cend(results));
+        }
+        std::sort(begin(armstrong_numbers), end(armstrong_numbers));
+        return armstrong_numbers;
+    }
+
+private:
+    static constexpr auto kMaxValue = std::numeric_limits<uint128_t>::max();
+
+    struct Task
+    {
+        size_t digits;
+        size_t nines;
+    };
+
+    struct LengthTables
+    {
+        size_t               digits;
+        array<uint128_t, 10> powers; // powers[d] = d^digits
+        uint128_t            lower;  // smallest number with `digits` digits
+        uint128_t            upper;  // largest number with `digits` digits, or kMaxValue - 1 if it does not fit
+    };
+
+    static uint128_t SaturatingAdd(const uint128_t &a, const uint128_t &b)
+    {
+        return (a > kMaxValue - b) ? kMaxValue : a + b;
+    }
+
+    static uint128_t SaturatingMultiply(const uint128_t &a, const uint128_t &b)
+    {
+        return (0 != a && b > kMaxValue / a) ? kMaxValue : a * b;
+    }
+
+    static LengthTables MakeLengthTables(const size_t &digits)
+    {
+        auto tables = LengthTables{ digits, {}, 1, 1 };
+        for (auto d = 0; d < 10 ;++d)
+        {
+            tables.powers[d] = 1;
+            for (auto i = size_t{ 0 }; i < digits ;++i) { tables.powers[d] = SaturatingMultiply(tables.powers[d], d); }
+        }
+        for (auto i = size_t{ 1 }; i < digits ;++i) { tables.lower *= 10; }
+        tables.upper = (tables.lower > kMaxValue / 10) ? kMaxValue - 1 : tables.lower * 10 - 1;
+        return tables;
+    }
+
+    /**
+     * @brief Tests whether @param N has exactly the digit counts @param counts.
+     *      N is first split into two 64-bit halves at 10^19, so that digits are extracted
+     *      using 64-bit divisions only.
+     */
+    static bool HasDigitCounts(const uint128_t &N, const array<size_t, 10> &counts)
+    {
+        constexpr auto kSplit = uint64_t{ 10'000'000'000'000'000'000u };
+        auto remaining        = counts;
+        auto high             = static_cast<uint64_t>(N / kSplit);
+        auto low              = static_cast<uint64_t>(N % kSplit);
+        const auto kConsume   = [&remaining](const uint64_t &digit) { return 0 != remaining[digit]--; };
+        const auto kLowDigits = (0 != high) ? 19 : 0; // low half is zero padded to 19 digits when high is non-zero
+        for (auto i = 0; i < kLowDigits || 0 != low ;++i, low /= 10)
+        {
+            if (!kConsume(low % 10)) { return false; }
+        }
+        for (; 0 != high ;high /= 10)
+        {
+            if (!kConsume(high % 10)) { return false; }
+        }
+        return std::all_of(cbegin(remaining), cend(remaining), [](const auto &count) { return 0 == count; });
+    }
+
+    /**
+     * @brief Writes the @param digit_count decimal digits of @param N into @param digits, most significant first.
+     */
+    static void ToDigits(const uint128_t &N, const size_t &digit_count, array<uint8_t, kMaxDigits> &digits)
+    {
+        constexpr auto kSplit = uint64_t{ 10'000'000'000'000'000'000u };
+        auto high             = static_cast<uint64_t>(N / kSplit);
+        auto low              = static_cast<uint64_t>(N % kSplit);
+        for (auto pos = digit_count; pos > 0 ;--pos)
+        {
+            if (digit_count - pos < 19) { digits[pos - 1] = static_cast<uint8_t>(low % 10);  low /= 10;  }
+            else                        { digits[pos - 1] = static_cast<uint8_t>(high % 10); high /= 10; }
+        }
+    }
+
+    /**
+     * @brief Every number reachable from the current branch lies in [low, high]. Leading digits that
+     *      are common to low and high are therefore digits of the result. Returns false if those digits
+     *      need more occurrences of a digit > @param digit than @param counts has fixed, or more
+     *      positions than the @param remaining ones for digits <= @param digit.
+     */
+    static bool IsCommonPrefixFeasible(const LengthTables &length, const size_t &digit, size_t remaining, uint128_t low, uint128_t high,
+        const array<size_t, 10> &counts)
+    {
+        low  = std::max(low, length.lower);
+        high = std::min(high, length.upper);
+        if (low > high) { return false; }
+
+        auto low_digits  = array<uint8_t, kMaxDigits>{};
+        auto high_digits = array<uint8_t, kMaxDigits>{};
+        ToDigits(low, length.digits, low_digits);
+        ToDigits(high, length.digits, high_digits);
+        auto available = counts;
+        for (auto pos = size_t{ 0 }; pos < length.digits && low_digits[pos] == high_digits[pos] ;++pos)
+        {
+            const auto kDigit = low_digits[pos];
+            if (kDigit > digit) { if (0 == available[kDigit]--) { return false; } }
+            else                { if (0 == remaining--)         { return false; } }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Chooses the count of @param digit for the remaining @param remaining positions,
+     *      from the largest count to 0, and recurses into the next smaller digit.
+     */
+    void Search(const LengthTables &length, const size_t &digit, const size_t &remaining, const uint128_t &partial_sum,
+        array<size_t, 10> &counts, vector<uint128_t> &results) const
+    {
+        if (0 == digit)
+        {
+            counts[0] = remaining;
+            if (partial_sum >= length.lower && HasDigitCounts(partial_sum, counts)) { results.push_back(partial_sum); }
+            return;
+        }
+        const auto kMaxSum = SaturatingAdd(partial_sum, SaturatingMultiply(remaining, length.powers[digit]));
+        if (kMaxSum < length.lower) { return; }
+        if (!IsCommonPrefixFeasible(length, digit, remaining, partial_sum, kMaxSum, counts)) { return; }
+
+        for (auto count = remaining + 1; count > 0 ;--count)
+        {
+            const auto kSum = SaturatingAdd(partial_sum, SaturatingMultiply(count - 1, length.powers[digit]));
+            if (kSum > length.upper) { continue; }
+
+            counts[digit] = count - 1;
+            Search(length, digit - 1, remaining - (count - 1), kSum, counts, results);
+        }
+    }
+
+    size_t max_digits_;
+    size_t thread_count_;
+};
+
 int main()
 {
     cout << "3 digit Armstrong numbers are:\n";
@@ -131,5 +386,16 @@ int main()
     cout << "Armstrong numbers upto " << limit << " are:\n";
     PrintNumbersUptoN_if(limit, IsArmstrong);
 
+    constexpr auto kMaxDigits    = size_t{ 39 };
+    const auto kStartTimepoint   = steady_clock::now();
+    const auto kArmstrongNumbers = ArmstrongNumbersEnumerator{ kMaxDigits }();
+    const auto kDuration         = duration_cast<milliseconds>(steady_clock::now() - kStartTimepoint);
+    cout << "Armstrong numbers upto " << kMaxDigits << " digits are:\n";
+    for (const auto &armstrong_number : kArmstrongNumbers)
+    {
+        cout << ToString(armstrong_number) << "\n";
+    }
+    cout << "Found " << kArmstrongNumbers.size() << " armstrong numbers in " << kDuration.count() << "ms\n";
+
     return 0;
 }
\ No newline at end of file
@@ -2,7 +2,7 @@
  * @file 9_primes_factors.cpp
  * @author Usama Tayyab (usamatayyab9@gmail.com)
  * @brief 
- *      Compilation command: g++ -std=c++17 9_primes_factors.cpp
+ *      Compilation command: g++ -std=c++20 -O2 9_primes_factors.cpp -lpthread
  *      This file is solution to "Problem 9.  Prime factors of a number"
  *      mentioned in "Chapter 1: Math Problems" of the book:
  *      - The Modern C++ Challenge by Marius Bancilla (available at amazon https://www.amazon.com/Modern-Challenge-programmer-real-world-problems/dp/1788993861)
@@ -13,12 +13,23 @@
  *      The solution is implented using a struct PrimeFactorsGenerator which generates all prime
  *      factors of a number return them as vector and a function PrintPrimeFactors() which uses
  *      uses the above struct to obtain a list of prime factors and then prints them.
+ *      PrimeFactorsGenerator supports two methods of factorization(see enum FactorizationMethod):
+ *          1. Trial division, which is the default.
+ *          2. Miller-Rabin and Brent's Pollard-rho, implemented in prime_factorization.h, which
+ *             factorizes any 64-bit number within microseconds.
+ *      For factorizing every number of a range, PrintPrimeFactorsUptoN() builds a smallest prime factor
+ *      table(see smallest_prime_factor_table.h) once and then factorizes each number using table lookups.
  *      
  *      Driver code:
  *      The program first take a number as input from user via the console. Pass it to the function
  *      PrintPrimeFactors() which prints all of its prime factors.
  *      Then Prints all the prime factors of 600'851'475'143 using the same function. Printing prime
  *      factors of 600'851'475'143 is given as an further exercise.
+ *      Then factorizes a semiprime close to 2^63 using Pollard-rho and prints it along with the time
+ *      taken, then factorizes a list of numbers on multiple threads using FactorizeMany().
+ *      Finally prints prime factors of all numbers upto 20 using the smallest prime factor table. The table
+ *      is only cached in a file when its path is given as the first command line argument e.g.
+ *      `./a.out /tmp/spf_table_20.bin`, otherwise it is built in memory.
  * 
  * @copyright Copyright (c) 2023
  * 
@@ -28,6 +39,12 @@
 #include <cmath>
 #include <algorithm>
 #include <iterator>
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+
+#include "prime_factorization.h"
+#include "smallest_prime_factor_table.h"
 
 using std::cbegin;
 using std::cend;
@@ -37,13 +54,26 @@ using std::cout;
 using std::endl;
 using std::ostream_iterator;
 using std::sqrt;
+using std::string_view;
 using std::vector;
+using std::chrono::steady_clock;
+using std::chrono::microseconds;
+using std::chrono::duration_cast;
+
+enum class FactorizationMethod
+{
+    kTrialDivision,
+    kPollardRho
+};
 
 /**
  * @brief A structure for generating prime factors of a given number.
+ *      The member `method` selects the algorithm used by the function call operator.
  */
 struct PrimeFactorsGenerator
 {
+    FactorizationMethod method = FactorizationMethod::kTrialDivision;
+
     /**
      * @brief 
      *          Divides N by d unitl it is no longer perfectly divisible by d.
@@ -73,11 +103,19 @@ struct PrimeFactorsGenerator
      *      prime so it is handled initially,  The process start with 3 continues with odd numbers until
      *      N becomes 1. Any remaining value of N greater than 1 after the loop is also a prime factor.
      * 
+     *      If `method` is FactorizationMethod::kPollardRho then FactorizePollardRho() is used instead.
+     * 
      * @param N_arg - The number for which prime factors are to be generated.
      * @return A vector containing all the prime factors of the input number.
      */
     vector<size_t> operator()(const size_t &N_arg)
     {
+        if (FactorizationMethod::kPollardRho == method)
+        {
+            const auto kFactors = FactorizePollardRho(N_arg);
+            return vector<size_t>(cbegin(kFactors), cend(kFactors));
+        }
+
         auto prime_factors  = vector<size_t>{};
         auto N              = DivideAndUpdateFatorsList(N_arg, 2, prime_factors);
         const auto kSqrtOfN = sqrt(N);
@@ -92,9 +130,9 @@ struct PrimeFactorsGenerator
     }
 };
 
-void PrintPrimeFactors(const auto &i)
+void PrintPrimeFactors(const auto &i, const FactorizationMethod &method = FactorizationMethod::kTrialDivision)
 {
-    const auto kPrimeFactors = PrimeFactorsGenerator{}(i);
+    const auto kPrimeFactors = PrimeFactorsGenerator{ method }(i);
     cout << "Prime factors of " << i << " are :\n";
     for (const auto &prime_factor : kPrimeFactors)
     {
@@ -103,7 +141,29 @@ void PrintPrimeFactors(const auto &i)
     cout << '\n';
 }
 
-int main()
+/**
+ * @brief Prints prime factors of every number from 2 to @param N.
+ *      Instead of running PrimeFactorsGenerator once per number, the smallest prime factor
+ *      table upto N is loaded from @param cache_file(or built and saved to it), after which
+ *      each number is factorized in O(log n) table lookups. An empty @param cache_file builds
+ *      the table without touching any file.
+ * @param N 
+ * @param cache_file 
+ */
+void PrintPrimeFactorsUptoN(const size_t &N, string_view cache_file)
+{
+    const auto kTable = empty(cache_file) ? SmallestPrimeFactorTable{ N } : SmallestPrimeFactorTable::LoadOrBuild(N, cache_file);
+    for (auto i = size_t{ 2 }; i <= N ;++i)
+    {
+        const auto kPrimeFactors = kTable.Factorize(i);
+        cout << i << " : ";
+        copy(cbegin(kPrimeFactors), cend(kPrimeFactors), ostream_iterator<size_t>(cout, " "));
+        cout << '\n';
+    }
+}
+
+#if !defined(MATH_KERNELS_BENCHMARK) // benchmark_math_kernels.cpp includes this file for its solution
+int main(int argc, char *argv[])
 {
     auto i = size_t{ 0 };
     cout << "Enter a number : ";
@@ -112,6 +172,25 @@ int main()
     PrintPrimeFactors(i);
     constexpr auto kLargeNumber = 600'851'475'143;
     PrintPrimeFactors(kLargeNumber);
+
+    constexpr auto kSemiprime = size_t{ 3'037'000'493 } * size_t{ 3'037'000'453 }; // close to 2^63
+    const auto kStartTimepoint = steady_clock::now();
+    PrintPrimeFactors(kSemiprime, FactorizationMethod::kPollardRho);
+    const auto kDuration = duration_cast<microseconds>(steady_clock::now() - kStartTimepoint);
+    cout << "Factorizing " << kSemiprime << " using Pollard-rho took: " << kDuration.count() << "us\n";
+
+    const auto kNumbers = vector<uint64_t>{ 18'446'744'073'709'551'615u, 9'223'372'036'854'775'783u, 1'000'000'016'000'000'063u, 600'851'475'143u };
+    const auto kFactorsList = FactorizeMany(kNumbers);
+    for (auto idx = size_t{ 0 }; idx < size(kNumbers) ;++idx)
+    {
+        cout << kNumbers[idx] << " = ";
+        copy(cbegin(kFactorsList[idx]), cend(kFactorsList[idx]), ostream_iterator<uint64_t>(cout, " "));
+        cout << '\n';
+    }
+
+    const auto kSpfCacheFile = (argc > 1) ? string_view{ argv[1] } : string_view{};
+    PrintPrimeFactorsUptoN(20, kSpfCacheFile);
     
     return 0;
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,640 @@
+/**
+ * @file arbitrary_precision_pi.h
+ * @author Usama Tayyab (usamatayyab9@gmail.com)
+ * @brief
+ *      This file provides an arbitrary precision implementation of the Chudnovsky algorithm, used by
+ *      13_value_of_pi.cpp for computing millions of digits of π.
+ *
+ *      The Chudnovsky series is:
+ *          1/π = 12 * Σ (-1)^k (6k)! (13591409 + 545140134k) / ((3k)! (k!)^3 640320^(3k + 3/2))
+ *      Each term adds about 14.18 digits, so 10^7 digits need about 705,000 terms.
+ *
+ *      The file contains:
+ *          1. BigInteger, a signed integer stored as base 10^9 limbs. Base 10^9 makes writing decimal
+ *             digits trivial. Small products use schoolbook multiplication, large products use number
+ *             theoretic transforms(NTT) modulo three primes, which are combined using the Chinese
+ *             remainder theorem(Garner's algorithm). The three transforms run on separate threads.
+ *          2. BigFloat, a BigInteger mantissa with a limb exponent, which supports truncated
+ *             multiplication and Newton iterations for reciprocal and inverse square root.
+ *          3. ChudnovskyPiEngine, which evaluates the series using binary splitting. The series is split
+ *             recursively into halves, producing integers P, Q and T for each half, which are merged
+ *             using multiplications only. Upper levels of the recursion evaluate both halves in parallel.
+ *             Finally π = 426880 * sqrt(10005) * Q / T, and the digits are streamed to an output stream.
+ *      For more info visit:
+ *          - https://en.wikipedia.org/wiki/Chudnovsky_algorithm
+ *          - https://en.wikipedia.org/wiki/Binary_splitting
+ *          - https://en.wikipedia.org/wiki/Sch%C3%B6nhage%E2%80%93Strassen_algorithm
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef ARBITRARY_PRECISION_PI_H
+#define ARBITRARY_PRECISION_PI_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <future>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+inline constexpr auto kBigIntegerBase       = uint32_t{ 1'000'000'000 };
+inline constexpr auto kBigIntegerBaseDigits = size_t{ 9 };
+
+/**
+ * @brief Number theoretic transform modulo a prime Mod = c * 2^k + 1 with primitive root PrimitiveRoot.
+ */
+template<uint32_t Mod, uint32_t PrimitiveRoot>
+struct NumberTheoreticTransform
+{
+    static constexpr uint32_t Power(uint64_t base, uint64_t exponent)
+    {
+        auto result = uint64_t{ 1 };
+        for (base %= Mod; 0 != exponent ;exponent >>= 1)
+        {
+            if (1 == (exponent & 1)) { result = result * base % Mod; }
+            base = base * base % Mod;
+        }
+        return static_cast<uint32_t>(result);
+    }
+
+    /**
+     * @brief In-place iterative radix-2 transform of @param a, whose size must be a power of 2.
+     *      For each stage, powers of the root of unity are computed once into `roots`.
+     */
+    static void Transform(std::vector<uint32_t> &a, const bool &inverse)
+    {
+        const auto kSize = size(a);
+        for (auto i = size_t{ 1 }, j = size_t{ 0 }; i < kSize ;++i)
+        {
+            auto bit = kSize >> 1;
+            for (; 0 != (j & bit) ;bit >>= 1) { j ^= bit; }
+            j ^= bit;
+            if (i < j) { std::swap(a[i], a[j]); }
+        }
+
+        auto roots = std::vector<uint32_t>(std::max(kSize / 2, size_t{ 1 }));
+        for (auto half = size_t{ 1 }; half < kSize ;half *= 2)
+        {
+            auto root = Power(PrimitiveRoot, (Mod - 1) / (2 * half));
+            if (inverse) { root = Power(root, Mod - 2); }
+            roots[0] = 1;
+            for (auto j = size_t{ 1 }; j < half ;++j) { roots[j] = static_cast<uint32_t>(uint64_t{ roots[j - 1] } * root % Mod); }
+
+            for (auto start = size_t{ 0 }; start < kSize ;start += 2 * half)
+            {
+                for (auto j = size_t{ 0 }; j < half ;++j)
+                {
+                    const auto kU = a[start + j];
+                    const auto kV = static_cast<uint32_t>(uint64_t{ a[start + j + half] } * roots[j] % Mod);
+                    a[start + j]        = (kU + kV >= Mod) ? kU + kV - Mod : kU + kV;
+                    a[start + j + half] = (kU >= kV) ? kU - kV : kU + Mod - kV;
+                }
+            }
+        }
+
+        if (inverse)
+        {
+            const auto kSizeInverse = Power(kSize, Mod - 2);
+            for (auto &value : a) { value = static_cast<uint32_t>(uint64_t{ value } * kSizeInverse % Mod); }
+        }
+    }
+
+    /**
+     * @brief Returns the cyclic convolution of @param a and @param b modulo Mod, of length
+     *      @param transform_size. When a and b are the same vector only one forward transform is done.
+     */
+    static std::vector<uint32_t> Convolve(const std::vector<uint32_t> &a, const std::vector<uint32_t> &b, const size_t &transform_size)
+    {
+        auto fa = std::vector<uint32_t>(transform_size, 0);
+        std::transform(cbegin(a), cend(a), begin(fa), [](const auto &limb) { return limb % Mod; });
+        Transform(fa, false);
+        if (&a == &b)
+        {
+            for (auto &value : fa) { value = static_cast<uint32_t>(uint64_t{ value } * value % Mod); }
+        }
+        else
+        {
+            auto fb = std::vector<uint32_t>(transform_size, 0);
+            std::transform(cbegin(b), cend(b), begin(fb), [](const auto &limb) { return limb % Mod; });
+            Transform(fb, false);
+            for (auto idx = size_t{ 0 }; idx < transform_size ;++idx)
+            {
+                fa[idx] = static_cast<uint32_t>(uint64_t{ fa[idx] } * fb[idx] % Mod);
+            }
+        }
+        Transform(fa, true);
+        return fa;
+    }
+};
+
+/**
+ * @brief A signed arbitrary precision integer stored as little-endian base 10^9 limbs.
+ *      Zero is represented by no limbs, and is never negative.
+ */
+class BigInteger
+{
+public:
+    static constexpr auto kSchoolbookThreshold  = size_t{ 48 };      // smaller operand upto this uses schoolbook
+    static constexpr auto kParallelNttThreshold = size_t{ 1 } << 15; // transforms of this size run on 3 threads
+    static constexpr auto kMaxTransformSize     = size_t{ 1 } << 23; // limited by 998244353 = 119 * 2^23 + 1
+
+    BigInteger() = default;
+
+    BigInteger(int64_t value)
+    {
+        negative_ = value < 0;
+        for (auto magnitude = negative_ ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value); 0 != magnitude ;magnitude /= kBigIntegerBase)
+        {
+            limbs_.push_back(static_cast<uint32_t>(magnitude % kBigIntegerBase));
+        }
+    }
+
+    BigInteger(std::vector<uint32_t> limbs, const bool &negative) : limbs_{ std::move(limbs) }, negative_{ negative }
+    {
+        Trim();
+    }
+
+    bool IsZero() const                         { return limbs_.empty(); }
+    bool IsNegative() const                     { return negative_; }
+    size_t LimbCount() const                    { return size(limbs_); }
+    const std::vector<uint32_t>& Limbs() const  { return limbs_; }
+
+    /**
+     * @brief Returns this * 10^(9 * @param count). For negative count, the lowest limbs
+     *      are dropped i.e. the magnitude is truncated.
+     */
+    BigInteger ShiftedLimbs(const int64_t &count) const
+    {
+        auto limbs = std::vector<uint32_t>{};
+        if (count >= 0)
+        {
+            limbs.reserve(size(limbs_) + count);
+            limbs.insert(end(limbs), count, 0);
+            limbs.insert(end(limbs), cbegin(limbs_), cend(limbs_));
+        }
+        else if (static_cast<size_t>(-count) < size(limbs_))
+        {
+            limbs.assign(cbegin(limbs_) - count, cend(limbs_));
+        }
+        return BigInteger{ std::move(limbs), negative_ };
+    }
+
+    BigInteger operator-() const
+    {
+        auto negated = *this;
+        negated.negative_ = !negative_ && !limbs_.empty();
+        return negated;
+    }
+
+    friend BigInteger operator*(const BigInteger &lhs, const BigInteger &rhs)
+    {
+        return BigInteger{ MultiplyMagnitudes(lhs.limbs_, rhs.limbs_), lhs.negative_ != rhs.negative_ };
+    }
+
+    friend BigInteger operator+(const BigInteger &lhs, const BigInteger &rhs)
+    {
+        if (lhs.negative_ == rhs.negative_)
+        {
+            return BigInteger{ AddMagnitudes(lhs.limbs_, rhs.limbs_), lhs.negative_ };
+        }
+        if (CompareMagnitudes(lhs.limbs_, rhs.limbs_) >= 0)
+        {
+            return BigInteger{ SubtractMagnitudes(lhs.limbs_, rhs.limbs_), lhs.negative_ };
+        }
+        return BigInteger{ SubtractMagnitudes(rhs.limbs_, lhs.limbs_), rhs.negative_ };
+    }
+
+    friend BigInteger operator-(const BigInteger &lhs, const BigInteger &rhs)
+    {
+        return lhs + (-rhs);
+    }
+
+private:
+    void Trim()
+    {
+        while (!limbs_.empty() && 0 == limbs_.back()) { limbs_.pop_back(); }
+        if (limbs_.empty()) { negative_ = false; }
+    }
+
+    static int CompareMagnitudes(const std::vector<uint32_t> &a, const std::vector<uint32_t> &b)
+    {
+        if (size(a) != size(b)) { return size(a) < size(b) ? -1 : 1; }
+        for (auto idx = size(a); idx > 0 ;--idx)
+        {
+            if (a[idx - 1] != b[idx - 1]) { return a[idx - 1] < b[idx - 1] ? -1 : 1; }
+        }
+        return 0;
+    }
+
+    static std::vector<uint32_t> AddMagnitudes(const std::vector<uint32_t> &a, const std::vector<uint32_t> &b)
+    {
+        const auto &kLonger  = size(a) >= size(b) ? a : b;
+        const auto &kShorter = size(a) >= size(b) ? b : a;
+        auto result          = std::vector<uint32_t>(size(kLonger) + 1, 0);
+        auto carry           = uint32_t{ 0 };
+        for (auto idx = size_t{ 0 }; idx < size(kLonger) ;++idx)
+        {
+            auto sum = kLonger[idx] + carry + (idx < size(kShorter) ? kShorter[idx] : 0);
+            carry    = sum >= kBigIntegerBase ? 1 : 0;
+            result[idx] = sum - carry * kBigIntegerBase;
+        }
+        result.back() = carry;
+        return result;
+    }
+
+    // Requires |a| >= |b|.
+    static std::vector<uint32_t> SubtractMagnitudes(const std::vector<uint32_t> &a, const std::vector<uint32_t> &b)
+    {
+        auto result = a;
+        auto borrow = int64_t{ 0 };
+        for (auto idx = size_t{ 0 }; idx < size(result) && (idx < size(b) || 0 != borrow) ;++idx)
+        {
+            auto difference = int64_t{ result[idx] } - borrow - (idx < size(b) ? int64_t{ b[idx] } : 0);
+            borrow          = difference < 0 ? 1 : 0;
+            result[idx]     = static_cast<uint32_t>(difference + borrow * kBigIntegerBase);
+        }
+        return result;
+    }
+
+    static std::vector<uint32_t> MultiplySchoolbook(const std::vector<uint32_t> &a, const std::vector<uint32_t> &b)
+    {
+        auto result = std::vector<uint32_t>(size(a) + size(b), 0);
+        for (auto i = size_t{ 0 }; i < size(a) ;++i)
+        {
+            auto carry = uint64_t{ 0 };
+            for (auto j = size_t{ 0 }; j < size(b) ;++j)
+            {
+                const auto kCurrent = result[i + j] + uint64_t{ a[i] } * b[j] + carry;
+                result[i + j] = static_cast<uint32_t>(kCurrent % kBigIntegerBase);
+                carry         = kCurrent / kBigIntegerBase;
+            }
+            result[i + size(b)] = static_cast<uint32_t>(carry);
+        }
+        return result;
+    }
+
+    /**
+     * @brief Multiplies using three NTTs with moduli m1 = 998244353, m2 = 167772161, m3 = 469762049.
+     *      Each coefficient of the product is less than min(|a|, |b|) * 10^18 which is far below
+     *      m1 * m2 * m3 ≈ 7.8 * 10^25. It is recovered by Garner's algorithm as
+     *      c = x1 + m1 * x2 + m1 * m2 * x3, where m1 * m2 = d1 * 10^9 + d0. The terms are added
+     *      into 64-bit accumulators, and d1 * x3 is carried into the next limb.
+     */
+    static std::vector<uint32_t> MultiplyNtt(const std::vector<uint32_t> &a, const std::vector<uint32_t> &b)
+    {
+        using Ntt1 = NumberTheoreticTransform<998'244'353, 3>;
+        using Ntt2 = NumberTheoreticTransform<167'772'161, 3>;
+        using Ntt3 = NumberTheoreticTransform<469'762'049, 3>;
+        constexpr auto kM1         = uint64_t{ 998'244'353 };
+        constexpr auto kM2         = uint64_t{ 167'772'161 };
+        constexpr auto kM3         = uint64_t{ 469'762'049 };
+        constexpr auto kM1InvModM2 = uint64_t{ Ntt2::Power(kM1, kM2 - 2) };
+        constexpr auto kM1M2InvM3  = uint64_t{ Ntt3::Power(kM1 * kM2 % kM3, kM3 - 2) };
+        constexpr auto kM1M2Low    = (kM1 * kM2) % kBigIntegerBase;
+        constexpr auto kM1M2High   = (kM1 * kM2) / kBigIntegerBase;
+
+        const auto kCoefficients   = size(a) + size(b) - 1;
+        const auto kTransformSize  = std::bit_ceil(kCoefficients);
+        if (kTransformSize > kMaxTransformSize)
+        {
+            throw std::length_error{ "BigInteger product is too large for the number theoretic transform" };
+        }
+
+        auto r1 = std::vector<uint32_t>{};
+        auto r2 = std::vector<uint32_t>{};
+        auto r3 = std::vector<uint32_t>{};
+        if (kTransformSize >= kParallelNttThreshold)
+        {
+            auto f1 = std::async(std::launch::async, [&a, &b, kTransformSize]() { return Ntt1::Convolve(a, b, kTransformSize); });
+            auto f2 = std::async(std::launch::async, [&a, &b, kTransformSize]() { return Ntt2::Convolve(a, b, kTransformSize); });
+            r3 = Ntt3::Convolve(a, b, kTransformSize);
+            r1 = f1.get();
+            r2 = f2.get();
+        }
+        else
+        {
+            r1 = Ntt1::Convolve(a, b, kTransformSize);
+            r2 = Ntt2::Convolve(a, b, kTransformSize);
+            r3 = Ntt3::Convolve(a, b, kTransformSize);
+        }
+
+        auto result  = std::vector<uint32_t>(size(a) + size(b) + 2, 0);
+        auto carry   = uint64_t{ 0 };
+        auto pending = uint64_t{ 0 }; // d1 * x3 of the previous coefficient
+        for (auto idx = size_t{ 0 }; idx < kCoefficients ;++idx)
+        {
+            const auto kX1 = uint64_t{ r1[idx] };
+            const auto kX2 = (r2[idx] + kM2 - kX1 % kM2) % kM2 * kM1InvModM2 % kM2;
+            const auto kX3 = (r3[idx] + 2 * kM3 - kX1 % kM3 - kM1 % kM3 * kX2 % kM3) % kM3 * kM1M2InvM3 % kM3;
+
+            const auto kTotal = carry + pending + kX1 + kM1 * kX2 + kM1M2Low * kX3;
+            result[idx] = static_cast<uint32_t>(kTotal % kBigIntegerBase);
+            carry       = kTotal / kBigIntegerBase;
+            pending     = kM1M2High * kX3;
+        }
+        for (auto idx = kCoefficients; idx < size(result) ;++idx)
+        {
+            const auto kTotal = carry + pending;
+            result[idx] = static_cast<uint32_t>(kTotal % kBigIntegerBase);
+            carry       = kTotal / kBigIntegerBase;
+            pending     = 0;
+        }
+        return result;
+    }
+
+    /**
+     * @brief Products which do not fit in kMaxTransformSize are split, the longer operand is cut into
+     *      halves a = high * 10^(9 * half) + low and a * b = (high * b) * 10^(9 * half) + low * b.
+     */
+    static std::vector<uint32_t> MultiplyMagnitudes(const std::vector<uint32_t> &a, const std::vector<uint32_t> &b)
+    {
+        if (a.empty() || b.empty()) { return {}; }
+        if (std::min(size(a), size(b)) <= kSchoolbookThreshold) { return MultiplySchoolbook(a, b); }
+        if (std::bit_ceil(size(a) + size(b) - 1) <= kMaxTransformSize) { return MultiplyNtt(a, b); }
+
+        const auto &kLonger  = size(a) >= size(b) ? a : b;
+        const auto &kShorter = size(a) >= size(b) ? b : a;
+        const auto kHalf     = size(kLonger) / 2;
+        auto low             = std::vector<uint32_t>(cbegin(kLonger), cbegin(kLonger) + kHalf);
+        auto high            = std::vector<uint32_t>(cbegin(kLonger) + kHalf, cend(kLonger));
+        auto result          = BigInteger{ MultiplyMagnitudes(high, kShorter), false }.ShiftedLimbs(static_cast<int64_t>(kHalf))
+                             + BigInteger{ MultiplyMagnitudes(low, kShorter), false };
+        return std::move(result.limbs_);
+    }
+
+    std::vector<uint32_t> limbs_;
+    bool                  negative_ = false;
+};
+
+/**
+ * @brief A floating point number with value mantissa * 10^(9 * exponent).
+ *      Operations take a precision in limbs, and truncate the result to that many limbs.
+ */
+struct BigFloat
+{
+    BigInteger mantissa;
+    int64_t    exponent = 0;
+};
+
+inline BigFloat Truncate(const BigFloat &x, const size_t &precision)
+{
+    if (x.mantissa.LimbCount() <= precision) { return x; }
+    const auto kDropped = static_cast<int64_t>(x.mantissa.LimbCount() - precision);
+    return BigFloat{ x.mantissa.ShiftedLimbs(-kDropped), x.exponent + kDropped };
+}
+
+inline BigFloat Multiply(const BigFloat &a, const BigFloat &b, const size_t &precision)
+{
+    const auto kA = Truncate(a, precision);
+    const auto kB = Truncate(b, precision);
+    return Truncate(BigFloat{ kA.mantissa * kB.mantissa, kA.exponent + kB.exponent }, precision);
+}
+
+inline BigFloat Add(const BigFloat &a, const BigFloat &b, const size_t &precision)
+{
+    const auto kExponent = std::min(a.exponent, b.exponent);
+    return Truncate(BigFloat{ a.mantissa.ShiftedLimbs(a.exponent - kExponent) + b.mantissa.ShiftedLimbs(b.exponent - kExponent), kExponent }, precision);
+}
+
+inline BigFloat Subtract(const BigFloat &a, const BigFloat &b, const size_t &precision)
+{
+    return Add(a, BigFloat{ -b.mantissa, b.exponent }, precision);
+}
+
+/**
+ * @brief Returns 1 / @param a to @param precision limbs using Newton's iteration
+ *      x = x + x * (1 - a * x), which doubles the number of correct digits in each step.
+ *      Initial estimate is 10^45 / top, where top is made of the top three limbs of a(scaled to
+ *      atleast 10^18 if a has fewer limbs) computed using long double. So the estimate has about 18
+ *      correct digits, atleast the one limb the schedule below starts from, whatever the top limbs are.
+ *      Each step works at twice the precision of the previous step(plus two guard limbs),
+ *      and one last step is done at full precision.
+ */
+inline BigFloat Reciprocal(const BigFloat &a, const size_t &precision)
+{
+    const auto &kLimbs   = a.mantissa.Limbs();
+    const auto kTopLimbs = std::min(kLimbs.size(), size_t{ 3 });
+    auto top             = 0.0L;
+    for (auto idx = kLimbs.size(); idx > kLimbs.size() - kTopLimbs ;--idx) { top = top * kBigIntegerBase + kLimbs[idx - 1]; }
+    auto top_exponent = a.exponent + static_cast<int64_t>(kLimbs.size() - kTopLimbs);
+    for (; top < 1e18L ;--top_exponent) { top *= kBigIntegerBase; }
+
+    // 10^45 / top is in (10^18, 10^27], it is split into two limbs of the mantissa
+    const auto kEstimate = 1e45L / top;
+    const auto kHigh     = static_cast<int64_t>(kEstimate / kBigIntegerBase);
+    const auto kLow      = static_cast<int64_t>(kEstimate - static_cast<long double>(kHigh) * kBigIntegerBase);
+    const auto kSign     = a.mantissa.IsNegative() ? -1 : 1;
+    auto x               = BigFloat{ BigInteger{ kSign * kHigh }.ShiftedLimbs(1) + BigInteger{ kSign * std::max<int64_t>(kLow, 0) }, -top_exponent - 5 };
+    const auto kOne      = BigFloat{ BigInteger{ 1 }, 0 };
+    for (auto current = size_t{ 1 }; ;)
+    {
+        const auto kIsLast = (current == precision);
+        current            = std::min(2 * current, precision);
+        const auto kWork   = current + 2;
+        const auto kError  = Subtract(kOne, Multiply(a, x, kWork), kWork);
+        x                  = Add(x, Multiply(x, kError, kWork), kWork);
+        if (kIsLast) { break; }
+    }
+    return Truncate(x, precision);
+}
+
+/**
+ * @brief Returns 1 / sqrt(@param a) to @param precision limbs using Newton's iteration
+ *      x = x + x * (1 - a * x^2) / 2. Halving is done by multiplying with 0.5 i.e.
+ *      mantissa 500000000 and exponent -1.
+ */
+inline BigFloat InverseSquareRoot(const uint32_t &a, const size_t &precision)
+{
+    const auto kA    = BigFloat{ BigInteger{ a }, 0 };
+    const auto kOne  = BigFloat{ BigInteger{ 1 }, 0 };
+    const auto kHalf = BigFloat{ BigInteger{ kBigIntegerBase / 2 }, -1 };
+    auto x           = BigFloat{ BigInteger{ static_cast<int64_t>(1e18 / std::sqrt(double(a))) }, -2 };
+    for (auto current = size_t{ 1 }; ;)
+    {
+        const auto kIsLast = (current == precision);
+        current            = std::min(2 * current, precision);
+        const auto kWork   = current + 2;
+        const auto kError  = Subtract(kOne, Multiply(kA, Multiply(x, x, kWork), kWork), kWork);
+        x                  = Add(x, Multiply(Multiply(x, kError, kWork), kHalf, kWork), kWork);
+        if (kIsLast) { break; }
+    }
+    return Truncate(x, precision);
+}
+
+/**
+ * @brief Computes digits of π using the Chudnovsky series with binary splitting.
+ *
+ * For a range of terms [a, b), binary splitting computes three integers:
+ *      P(a, b) = p(a + 1) * ... * p(b - 1) * p(a)
+ *      Q(a, b) = q(a) * ... * q(b - 1)
+ *      T(a, b) = Σ a(k) * P(a, k + 1) * Q(k + 1, b)
+ * where for a single term k > 0:
+ *      p(k) = -(6k - 5)(2k - 1)(6k - 1), q(k) = k^3 * 640320^3 / 24, a(k) = 13591409 + 545140134k
+ * and for k = 0, P = Q = 1 and T = 13591409.
+ * Two adjacent ranges [a, m) and [m, b) are merged as:
+ *      P(a, b) = P(a, m) * P(m, b)
+ *      Q(a, b) = Q(a, m) * Q(m, b)
+ *      T(a, b) = T(a, m) * Q(m, b) + P(a, m) * T(m, b)
+ * Then π = 426880 * sqrt(10005) * Q(0, N) / T(0, N).
+ *
+ * Upto `parallel_depth_` levels of recursion evaluate the left half on a separate thread.
+ * Time taken by each phase is recorded and can be queried using PhaseTimings().
+ */
+class ChudnovskyPiEngine
+{
+public:
+    using PhaseTiming = std::pair<std::string, std::chrono::milliseconds>;
+
+    static constexpr auto kDigitsPerTerm = 14.181647462725477;
+
+    explicit ChudnovskyPiEngine(const size_t &digits, const size_t &thread_count = std::thread::hardware_concurrency())
+        : digits_{ digits }, parallel_depth_{ static_cast<size_t>(std::bit_width(std::max(thread_count, size_t{ 1 }))) - 1 }
+    {
+    }
+
+    /**
+     * @brief Computes π and writes it as "3." followed by `digits` decimal digits into @param output.
+     *      Digits are formatted limb by limb into a buffer which is flushed in large blocks.
+     */
+    void WriteDigits(std::ostream &output)
+    {
+        timings_.clear();
+        const auto kPi = Compute();
+        assert(static_cast<int64_t>(kPi.mantissa.LimbCount()) - 1 + kPi.exponent == 0); // top limb is the integer part i.e. 3
+
+        auto start_timepoint = std::chrono::steady_clock::now();
+        const auto &kLimbs   = kPi.mantissa.Limbs();
+        auto buffer          = std::string{};
+        buffer.reserve(kBufferSize + kBigIntegerBaseDigits);
+        buffer.append(std::to_string(kLimbs.back())).append(".");
+
+        auto remaining = digits_;
+        for (auto idx = kLimbs.size() - 1; idx > 0 && remaining > 0 ;--idx)
+        {
+            auto limb  = std::array<char, kBigIntegerBaseDigits>{};
+            auto value = kLimbs[idx - 1];
+            for (auto pos = kBigIntegerBaseDigits; pos > 0 ;--pos, value /= 10)
+            {
+                limb[pos - 1] = static_cast<char>('0' + value % 10);
+            }
+
+            const auto kCount = std::min(remaining, kBigIntegerBaseDigits);
+            buffer.append(limb.data(), kCount);
+            remaining -= kCount;
+            if (size(buffer) >= kBufferSize)
+            {
+                output.write(buffer.data(), size(buffer));
+                buffer.clear();
+            }
+        }
+        output.write(buffer.data(), size(buffer));
+        output.flush();
+        RecordPhase("Writing digits", start_timepoint);
+    }
+
+    const std::vector<PhaseTiming>& PhaseTimings() const { return timings_; }
+
+private:
+    static constexpr auto kBufferSize = size_t{ 1 } << 20;
+
+    struct SplitResult
+    {
+        BigInteger P;
+        BigInteger Q;
+        BigInteger T;
+    };
+
+    BigFloat Compute()
+    {
+        const auto kTerms     = static_cast<int64_t>(digits_ / kDigitsPerTerm) + 2;
+        const auto kPrecision = digits_ / kBigIntegerBaseDigits + 3; // limbs, including guard limbs
+
+        auto start_timepoint = std::chrono::steady_clock::now();
+        const auto kSplit    = BinarySplit(0, kTerms, 0, false);
+        RecordPhase("Binary splitting", start_timepoint);
+
+        start_timepoint       = std::chrono::steady_clock::now();
+        const auto kInverseT  = Reciprocal(BigFloat{ kSplit.T, 0 }, kPrecision);
+        RecordPhase("Reciprocal of T", start_timepoint);
+
+        start_timepoint       = std::chrono::steady_clock::now();
+        const auto kSqrt10005 = Multiply(BigFloat{ BigInteger{ 10005 }, 0 }, InverseSquareRoot(10005, kPrecision), kPrecision);
+        RecordPhase("Square root of 10005", start_timepoint);
+
+        start_timepoint       = std::chrono::steady_clock::now();
+        const auto kNumerator = Multiply(Multiply(BigFloat{ kSplit.Q, 0 }, BigFloat{ BigInteger{ 426880 }, 0 }, kPrecision), kSqrt10005, kPrecision);
+        const auto kPi        = Multiply(kNumerator, kInverseT, kPrecision);
+        RecordPhase("Final multiplication", start_timepoint);
+        return kPi;
+    }
+
+    /**
+     * @brief Returns P, Q and T for terms [a, b). P is only computed if @param need_p is true,
+     *      since the rightmost ranges(including the whole series) never need it.
+     */
+    SplitResult BinarySplit(const int64_t &a, const int64_t &b, const size_t &depth, const bool &need_p) const
+    {
+        constexpr auto kC3Over24 = int64_t{ 10'939'058'860'032'000 }; // 640320^3 / 24
+        if (b - a == 1)
+        {
+            if (0 == a) { return SplitResult{ BigInteger{ 1 }, BigInteger{ 1 }, BigInteger{ 13'591'409 } }; }
+
+            const auto kP = BigInteger{ -(6 * a - 5) } * BigInteger{ (2 * a - 1) * (6 * a - 1) };
+            const auto kQ = BigInteger{ a * a } * BigInteger{ a } * BigInteger{ kC3Over24 };
+            const auto kT = kP * BigInteger{ 13'591'409 + 545'140'134 * a };
+            return SplitResult{ kP, kQ, kT };
+        }
+
+        const auto kMid = (a + b) / 2;
+        auto left       = SplitResult{};
+        auto right      = SplitResult{};
+        if (depth < parallel_depth_)
+        {
+            auto left_future = std::async(std::launch::async, [this, a, kMid, depth]() { return BinarySplit(a, kMid, depth + 1, true); });
+            right = BinarySplit(kMid, b, depth + 1, need_p);
+            left  = left_future.get();
+        }
+        else
+        {
+            left  = BinarySplit(a, kMid, depth + 1, true);
+            right = BinarySplit(kMid, b, depth + 1, need_p);
+        }
+
+        auto result = SplitResult{};
+        if (depth < parallel_depth_)
+        {
+            auto q_future = std::async(std::launch::async, [&left, &right]() { return left.Q * right.Q; });
+            result.T = left.T * right.Q + left.P * right.T;
+            if (need_p) { result.P = left.P * right.P; }
+            result.Q = q_future.get();
+        }
+        else
+        {
+            result.T = left.T * right.Q + left.P * right.T;
+            if (need_p) { result.P = left.P * right.P; }
+            result.Q = left.Q * right.Q;
+        }
+        return result;
+    }
+
+    void RecordPhase(std::string_view phase, const std::chrono::steady_clock::time_point &start_timepoint)
+    {
+        timings_.emplace_back(std::string{ phase }, std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_timepoint));
+    }
+
+    size_t                   digits_;
+    size_t                   parallel_depth_;
+    std::vector<PhaseTiming> timings_;
+};
+
+#endif // ARBITRARY_PRECISION_PI_H
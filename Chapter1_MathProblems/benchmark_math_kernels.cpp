@@ -0,0 +1,291 @@
+/**
+ * @file benchmark_math_kernels.cpp
+ * @author Usama Tayyab (usamatayyab9@gmail.com)
+ * @brief
+ *      Compilation command : g++ -std=c++20 -O2 benchmark_math_kernels.cpp -lpthread
+ *      This file is a benchmark for the kernels of "Chapter 1: Math Problems", so that regressions
+ *      can be caught and new engines can be compared against the original implementations.
+ *
+ *      The solution files of the problems are included with MATH_KERNELS_BENCHMARK defined, which leaves out
+ *      their main(), so that the benchmark measures the same code as the programs. Kernels are measured for
+ *      a few input sizes each, along with the engines which replaced them in the programs of this chapter:
+ *          - SumOfNaturalNumbers_if_n() and SumOfNaturalNumbersDivisileBy3And5 for sum upto n
+ *          - IsPrime() for counting primes upto n, against SegmentedPrimeSieve and PrimeCount(), the latter
+ *            also for powers of 10 upto 10^12 which are out of reach of the other two
+ *          - SumOfProperDivisors() for all numbers upto n, against DivisorSumTable. SumOfProperDivisors() is the
+ *            trial division upto sqrt(n) which 7_amicable_numbers.cpp used before DivisorSumTable, kept here as baseline
+ *          - CollatzSequence for the longest sequence upto n
+ *          - PrimeFactorsGenerator for factorizing all numbers upto n, using both FactorizationMethod
+ *          - LeibnizFormulaForPI and ChudnovskyAlgorithmForPI for n terms, and ChudnovskyPiEngine for n digits
+ *
+ *      Every case runs `warmup` untimed repetitions followed by `repetitions` timed ones. Each timed
+ *      repetition is measured with steady_clock, and median, min and max of the samples are reported. The 99th
+ *      percentile is reported only for atleast `kMinSamplesForP99` samples, with fewer samples it is the
+ *      maximum. Result of a kernel is passed to DoNotOptimize() so that the compiler can not drop the
+ *      computation.
+ *
+ *      Driver code:
+ *      Usage: benchmark_math_kernels [--warmup N] [--repetitions N] [--json FILE]
+ *      The program runs all cases, prints one line per case and writes all results as a JSON array to
+ *      FILE(default `kDefaultJsonFile` in the temporary directory).
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <functional>
+#include <chrono>
+#include <iomanip>
+#include <cmath>
+#include <cstdint>
+
+#define MATH_KERNELS_BENCHMARK
+#include "1_sum_of_numbers_divisile_by_3_and_5.cpp"
+#include "4_largest_prime_smaller_than_given_number.cpp"
+#include "9_primes_factors.cpp"
+#include "12_largest_collatz_sequence.cpp"
+#include "13_value_of_pi.cpp"
+#include "prime_sieve.h"
+#include "divisor_sum_table.h"
+
+using std::cout;
+using std::endl;
+using std::function;
+using std::ofstream;
+using std::optional;
+using std::ostream;
+using std::string;
+using std::string_view;
+using std::vector;
+using std::chrono::steady_clock;
+using std::chrono::duration;
+
+inline constexpr auto kDefaultJsonFile  = "benchmark_math_kernels.json";
+inline constexpr auto kMinSamplesForP99 = size_t{ 100 };
+
+/**
+ * @brief Prevents the compiler from optimizing away the computation of @param value.
+ */
+template<class T>
+void DoNotOptimize(const T &value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct BenchmarkOptions
+{
+    size_t warmup      = 2;
+    size_t repetitions = 15;
+};
+
+struct BenchmarkResult
+{
+    string           kernel;
+    uint64_t         input       = 0;
+    size_t           repetitions = 0;
+    double           median_ns   = 0;
+    optional<double> p99_ns      = std::nullopt; // Only for atleast kMinSamplesForP99 samples
+    double           min_ns      = 0;
+    double           max_ns      = 0;
+};
+
+/**
+ * @brief 
+ *      Calculates the sum of all proper divisors of @param N.
+ *      Iterates through potential divisors in the range [2,sqrt(N)].
+ *      Adds them to the sum if they are divisors, along with the corresponding
+ *      divisor N/i when it is different from i.
+ * @param N 
+ * @return sum of all proper divisors of @param N. 
+ */
+auto SumOfProperDivisors(const auto N)
+{
+    auto sum = size_t{ 1 };
+    for (auto [i, limit] = std::pair{ decltype(N){ 2 }, std::sqrt(N) }; i <= limit ;++i)
+    {
+        if (0 == (N % i))
+        {
+            sum += i;
+            if (auto second_divisior = N / i; second_divisior != i) { sum += second_divisior; }
+        }
+    }
+    return sum;
+}
+
+/**
+ * @brief Returns the @param percentile(in [0, 100]) of @param sorted_samples using nearest rank method.
+ */
+double Percentile(const vector<double> &sorted_samples, const double &percentile)
+{
+    const auto kRank = static_cast<size_t>(std::ceil(percentile / 100.0 * size(sorted_samples)));
+    return sorted_samples[std::clamp<size_t>(kRank, 1, size(sorted_samples)) - 1];
+}
+
+/**
+ * @brief Runs @param kernel with @param input, see file comments.
+ * @param kernel - callable taking the input and returning a value.
+ */
+template<class Kernel>
+BenchmarkResult RunBenchmark(string_view name, const uint64_t &input, Kernel kernel, const BenchmarkOptions &options)
+{
+    for (auto i = size_t{ 0 }; i < options.warmup ;++i) { DoNotOptimize(kernel(input)); }
+
+    auto samples = vector<double>{};
+    for (auto i = size_t{ 0 }; i < options.repetitions ;++i)
+    {
+        const auto kStartTimepoint = steady_clock::now();
+        DoNotOptimize(kernel(input));
+        samples.push_back(duration<double, std::nano>(steady_clock::now() - kStartTimepoint).count());
+    }
+    std::sort(begin(samples), end(samples));
+
+    auto result        = BenchmarkResult{ string{ name }, input, size(samples) };
+    result.median_ns   = Percentile(samples, 50);
+    if (size(samples) >= kMinSamplesForP99) { result.p99_ns = Percentile(samples, 99); }
+    result.min_ns      = samples.front();
+    result.max_ns      = samples.back();
+    return result;
+}
+
+void WriteJson(ostream &out, const vector<BenchmarkResult> &results)
+{
+    out << "[\n";
+    for (auto idx = size_t{ 0 }; idx < size(results) ;++idx)
+    {
+        const auto &kResult = results[idx];
+        out << "  {\"kernel\": \"" << kResult.kernel << "\", \"input\": " << kResult.input
+            << ", \"repetitions\": " << kResult.repetitions << std::fixed << std::setprecision(1)
+            << ", \"median_ns\": " << kResult.median_ns << ", \"p99_ns\": " << (kResult.p99_ns ? std::to_string(*kResult.p99_ns) : "null")
+            << ", \"min_ns\": " << kResult.min_ns << ", \"max_ns\": " << kResult.max_ns << "}"
+            << ((idx + 1 < size(results)) ? ",\n" : "\n");
+    }
+    out << "]\n";
+}
+
+int main(int argc, char *argv[])
+{
+    auto options   = BenchmarkOptions{};
+    auto json_file = (std::filesystem::temp_directory_path() / kDefaultJsonFile).string();
+    for (auto idx = 1; idx < argc ;idx += 2)
+    {
+        const auto kFlag = (idx + 1 < argc) ? string_view{ argv[idx] } : string_view{}; // Flag without a value prints usage
+        if      ("--warmup" == kFlag)      { options.warmup      = std::stoul(argv[idx + 1]); }
+        else if ("--repetitions" == kFlag) { options.repetitions = std::max(std::stoul(argv[idx + 1]), 1ul); }
+        else if ("--json" == kFlag)        { json_file           = argv[idx + 1]; }
+        else
+        {
+            cout << "Usage: " << argv[0] << " [--warmup N] [--repetitions N] [--json FILE]\n";
+            return 1;
+        }
+    }
+
+    struct BenchmarkCase
+    {
+        string                          name;
+        vector<uint64_t>                inputs;
+        function<uint64_t(uint64_t)>    kernel;
+    };
+    const auto kCases = vector<BenchmarkCase>{
+        { "SumOfNaturalNumbers_if_n", { 1'000, 100'000, 10'000'000 }, [](const uint64_t &n)
+        {
+            return SumOfNaturalNumbers_if_n(n, [](const auto &a){ return (a % 3 == 0) || (a % 5 == 0); });
+        }},
+        { "SumOfNaturalNumbersDivisileBy3And5", { 1'000, 100'000, 10'000'000 }, [](const uint64_t &n)
+        {
+            return SumOfNaturalNumbersDivisileBy3And5{}(n);
+        }},
+        { "IsPrime", { 10'000, 100'000, 1'000'000 }, [](const uint64_t &n)
+        {
+            auto count = uint64_t{ 0 };
+            for (auto i = uint64_t{ 1 }; i <= n ;++i) { count += IsPrime(i) ? 1 : 0; }
+            return count;
+        }},
+        { "SegmentedPrimeSieve", { 10'000, 100'000, 1'000'000 }, [](const uint64_t &n)
+        {
+            auto count = uint64_t{ 0 };
+            SegmentedPrimeSieve{ n }.ForEachPrime(1, n, [&count](const uint64_t &) { ++count; });
+            return count;
+        }},
+        { "PrimeCount", { 1'000'000, 100'000'000, 10'000'000'000, 1'000'000'000'000 }, [](const uint64_t &n)
+        {
+            return PrimeCount(n);
+        }},
+        { "SumOfProperDivisors", { 1'000, 10'000, 100'000 }, [](const uint64_t &n)
+        {
+            auto total = uint64_t{ 0 };
+            for (auto i = uint64_t{ 2 }; i <= n ;++i) { total += SumOfProperDivisors(i); }
+            return total;
+        }},
+        { "DivisorSumTable", { 1'000, 10'000, 100'000 }, [](const uint64_t &n)
+        {
+            const auto kTable = DivisorSumTable<uint64_t>{ n };
+            auto total        = uint64_t{ 0 };
+            for (auto i = uint64_t{ 2 }; i <= n ;++i) { total += kTable[i]; }
+            return total;
+        }},
+        { "CollatzSequence", { 1'000, 10'000, 100'000 }, [](const uint64_t &n)
+        {
+            auto collatz_sequence_generator = CollatzSequence{};
+            auto longest                    = uint64_t{ 0 };
+            for (auto i = uint64_t{ 1 }; i <= n ;++i) { longest = std::max<uint64_t>(longest, collatz_sequence_generator(i)); }
+            return longest;
+        }},
+        { "PrimeFactorsGenerator(TrialDivision)", { 1'000, 10'000, 100'000 }, [](const uint64_t &n)
+        {
+            auto generator = PrimeFactorsGenerator{ FactorizationMethod::kTrialDivision };
+            auto count     = uint64_t{ 0 };
+            for (auto i = uint64_t{ 2 }; i <= n ;++i) { count += size(generator(i)); }
+            return count;
+        }},
+        { "PrimeFactorsGenerator(PollardRho)", { 1'000, 10'000, 100'000 }, [](const uint64_t &n)
+        {
+            auto generator = PrimeFactorsGenerator{ FactorizationMethod::kPollardRho };
+            auto count     = uint64_t{ 0 };
+            for (auto i = uint64_t{ 2 }; i <= n ;++i) { count += size(generator(i)); }
+            return count;
+        }},
+        { "LeibnizFormulaForPI", { 1'000, 100'000, 1'000'000 }, [](const uint64_t &n)
+        {
+            return static_cast<uint64_t>(LeibnizFormulaForPI{}(n) * 1e15);
+        }},
+        { "ChudnovskyAlgorithmForPI", { 1, 2, 3 }, [](const uint64_t &n)
+        {
+            return static_cast<uint64_t>(ChudnovskyAlgorithmForPI{}(n) * 1e15);
+        }},
+        { "ChudnovskyPiEngine", { 1'000, 10'000, 100'000 }, [](const uint64_t &n)
+        {
+            auto engine = ChudnovskyPiEngine{ n };
+            auto output = std::ostringstream{};
+            engine.WriteDigits(output);
+            return static_cast<uint64_t>(output.str().back());
+        }},
+    };
+
+    auto results = vector<BenchmarkResult>{};
+    cout << std::left << std::setw(40) << "kernel" << std::setw(12) << "input"
+         << std::right << std::setw(16) << "median(ns)" << std::setw(16) << "p99(ns)" << std::setw(16) << "max(ns)" << '\n';
+    for (const auto &benchmark_case : kCases)
+    {
+        for (const auto &input : benchmark_case.inputs)
+        {
+            const auto kResult = RunBenchmark(benchmark_case.name, input, benchmark_case.kernel, options);
+            cout << std::left << std::setw(40) << kResult.kernel << std::setw(12) << kResult.input << std::right
+                 << std::fixed << std::setprecision(0) << std::setw(16) << kResult.median_ns << std::setw(16)
+                 << (kResult.p99_ns ? std::to_string(static_cast<uint64_t>(*kResult.p99_ns)) : "-") << std::setw(16) << kResult.max_ns << endl;
+            results.push_back(kResult);
+        }
+    }
+
+    auto json = ofstream{ json_file };
+    WriteJson(json, results);
+    cout << "Results written to " << json_file << '\n';
+    return 0;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file divisor_sum_table.h
+ * @author Usama Tayyab (usamatayyab9@gmail.com)
+ * @brief
+ *      This file provides a table holding the sum of proper divisors of every number in [1, limit].
+ *      It is shared by 6_abundant_numbers.cpp and 7_amicable_numbers.cpp, which otherwise spend
+ *      O(sqrt(n)) divisions per number.
+ *
+ *      The table is filled using a divisor sieve instead of dividing each number. Every divisor pair
+ *      (d, k) of m = d * k with d <= k is visited once, by iterating d upto sqrt(limit) and stepping
+ *      through the multiples of d, so filling the table takes O(n log n) additions. The only divisions
+ *      are the ones finding the first multiple of d in a block(see FillBlock()), i.e. one division per
+ *      d <= sqrt(limit) per block, O(sqrt(n)) per `kBlockSize` numbers instead of O(sqrt(n)) per number.
+ *
+ *      To keep all additions in cache the range is processed in blocks of `kBlockSize` numbers.
+ *      For each block, sums are accumulated in a per-thread buffer and then copied into the table.
+ *      Blocks are independent of each other, so they are distributed among multiple threads with
+ *      thread t processing blocks t, t + T, t + 2T... where T is the number of threads.
+ *
+ *      Type of the table entries is a template parameter. Sums that do not fit in it are saturated
+ *      to its maximum value. For example, a uint32_t table upto 10^9 needs 4GB instead of the 8GB
+ *      needed by uint64_t, which is enough for searching amicable numbers because any sum larger
+ *      than the limit is discarded anyway.
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef DIVISOR_SUM_TABLE_H
+#define DIVISOR_SUM_TABLE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <vector>
+
+template<typename ValueType = uint64_t>
+class DivisorSumTable
+{
+public:
+    static constexpr auto kBlockSize = uint64_t{ 1 } << 17;
+
+    /**
+     * @brief Computes sum of proper divisors of every number in [1, @param limit].
+     * @param limit
+     * @param thread_count - 0 is treated as 1
+     */
+    explicit DivisorSumTable(const uint64_t &limit, size_t thread_count = std::thread::hardware_concurrency())
+        : limit_{ limit }, sums_(limit + 1, 0)
+    {
+        const auto kBlockCount = (limit_ + kBlockSize) / kBlockSize; // blocks covering [0, limit]
+        thread_count           = std::clamp<size_t>(thread_count, 1, kBlockCount);
+
+        auto threads = std::vector<std::thread>{};
+        for (auto thread_idx = size_t{ 0 }; thread_idx < thread_count ;++thread_idx)
+        {
+            threads.push_back(std::thread{ [this, thread_idx, thread_count, kBlockCount]()
+            {
+                auto buffer = std::vector<uint64_t>(kBlockSize);
+                for (auto block = uint64_t{ thread_idx }; block < kBlockCount ;block += thread_count)
+                {
+                    const auto kLow  = block * kBlockSize;
+                    const auto kHigh = std::min(kLow + kBlockSize, limit_ + 1);
+                    FillBlock(kLow, kHigh, buffer);
+                }
+            }});
+        }
+        for (auto &t : threads) { t.join(); }
+    }
+
+    uint64_t Limit() const { return limit_; }
+
+    /**
+     * @brief Returns sum of proper divisors of @param N(saturated to the maximum of ValueType).
+     *      0 for N = 0 and N = 1.
+     */
+    ValueType operator[](const uint64_t &N) const { return sums_[N]; }
+
+    const std::vector<ValueType>& Data() const { return sums_; }
+
+private:
+    /**
+     * @brief Fills entries for numbers in [low, high).
+     *      For each d in [1, sqrt(high - 1)], visits every multiple m = d * k in the block with k >= d
+     *      and adds both divisors d and k(only once if k == d). This adds up all divisors of m,
+     *      including m itself(via d = 1), which is subtracted at the end to get the proper divisors.
+     */
+    void FillBlock(const uint64_t &low, const uint64_t &high, std::vector<uint64_t> &buffer)
+    {
+        std::fill(begin(buffer), begin(buffer) + (high - low), uint64_t{ 0 });
+        for (auto d = uint64_t{ 1 }; d * d < high ;++d)
+        {
+            auto k = std::max(d, (low + d - 1) / d);
+            for (auto m = k * d; m < high ;m += d, ++k)
+            {
+                buffer[m - low] += (k == d) ? d : d + k;
+            }
+        }
+
+        constexpr auto kMaxValue = uint64_t{ std::numeric_limits<ValueType>::max() };
+        for (auto m = std::max(low, uint64_t{ 1 }); m < high ;++m)
+        {
+            sums_[m] = static_cast<ValueType>(std::min(buffer[m - low] - m, kMaxValue));
+        }
+    }
+
+    uint64_t               limit_;
+    std::vector<ValueType> sums_;
+};
+
+#endif // DIVISOR_SUM_TABLE_H
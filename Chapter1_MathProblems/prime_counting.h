@@ -0,0 +1,328 @@
+/**
+ * @file prime_counting.h
+ * @author Usama Tayyab (usamatayyab9@gmail.com)
+ * @brief
+ *      This file provides the prime counting function pi(x) i.e. the number of primes <= x, used by
+ *      4_largest_prime_smaller_than_given_number.cpp. It is computed using Meissel's formula, so
+ *      primes upto x are never enumerated:
+ *
+ *          pi(x) = phi(x, a) + a - 1 - P2(x, a),  where a = pi(x^(1/3)) and
+ *
+ *          - phi(x, a) is the count of numbers in [1, x] which are not divisible by any of the first
+ *            a primes. It follows the recurrence phi(x, a) = phi(x, a - 1) - phi(x / p_a, a - 1).
+ *          - P2(x, a) is the count of numbers in [1, x] which are product of exactly two primes greater
+ *            than p_a, which is sum of pi(x / p_i) - (i - 1) for all primes p_i in (x^(1/3), x^(1/2)].
+ *
+ *      phi(x, a) is evaluated by the class LegendrePhi, the recursion is cut short using:
+ *          - Closed form for a <= 6 using a table of phi(r, a) for all r below 2 * 3 * 5 * 7 * 11 * 13.
+ *          - phi(x, a) = pi(x) - a + 1 when x < p_(a+1)^2, using PrimeCountTable upto x^(1/2).
+ *          - Memoized tables of phi(x, a) for all x < kCacheLimit and a <= kCacheMaxA, built once
+ *            by sieving with the first kCacheMaxA primes and storing the survivors with prefix counts.
+ *
+ *      P2(x, a) needs pi(x / p) for values upto x^(2/3). Range (x^(1/2), x^(2/3)] is divided among
+ *      multiple threads, each thread sieves its part using SegmentedPrimeSieve::SieveSegment() and
+ *      counts primes only upto the values x / p falling in its part. Counts of all parts are then
+ *      combined using prefix sums. Top level terms of phi(x, a) are also distributed among threads.
+ *
+ *      For more info visit https://en.wikipedia.org/wiki/Meissel%E2%80%93Lehmer_algorithm
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PRIME_COUNTING_H
+#define PRIME_COUNTING_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "prime_sieve.h"
+
+/**
+ * @brief A table answering pi(n) for all n <= limit in constant time.
+ *      Word k holds one bit per odd number in [128 * k, 128 * k + 128) and is paired with
+ *      the count of primes below 128 * k. So the table takes 1 byte per 8 numbers.
+ */
+class PrimeCountTable
+{
+public:
+    explicit PrimeCountTable(const uint64_t &limit) : limit_{ limit }, words_(limit / 128 + 1), counts_(limit / 128 + 1)
+    {
+        const auto kSieve = SegmentedPrimeSieve{ 128 * size(words_), 1 };
+        auto buffer       = std::vector<uint64_t>(SegmentedPrimeSieve::kSegmentWords);
+        for (auto first_word = size_t{ 0 }; first_word < size(words_) ;first_word += SegmentedPrimeSieve::kSegmentWords)
+        {
+            const auto kWords = std::min(SegmentedPrimeSieve::kSegmentWords, size(words_) - first_word);
+            kSieve.SieveSegment(128 * first_word + 1, 64 * kWords, buffer);
+            std::copy(begin(buffer), begin(buffer) + kWords, begin(words_) + first_word);
+        }
+
+        auto count = uint64_t{ 1 }; // 2 is the only even prime
+        for (auto idx = size_t{ 0 }; idx < size(words_) ;++idx)
+        {
+            counts_[idx] = count;
+            count += std::popcount(words_[idx]);
+        }
+    }
+
+    uint64_t Limit() const { return limit_; }
+
+    /**
+     * @brief Returns number of primes <= @param n, where n <= Limit().
+     */
+    uint64_t operator()(const uint64_t &n) const
+    {
+        if (n < 2) { return 0; }
+
+        return counts_[n / 128] + std::popcount(words_[n / 128] & OddsUptoMask(n));
+    }
+
+    /**
+     * @brief Returns mask of the bits representing odd numbers in [128 * (n / 128), n].
+     */
+    static uint64_t OddsUptoMask(const uint64_t &n)
+    {
+        const auto kOdds = (n % 128 + 1) / 2;
+        return (64 == kOdds) ? ~uint64_t{ 0 } : (uint64_t{ 1 } << kOdds) - 1;
+    }
+
+private:
+    uint64_t              limit_;
+    std::vector<uint64_t> words_;
+    std::vector<uint64_t> counts_;
+};
+
+/**
+ * @brief Computes Legendre's phi(x, a), the count of numbers in [1, x] not divisible by
+ *      any of the first a primes. See the file comments for the shortcuts used.
+ */
+class LegendrePhi
+{
+public:
+    static constexpr auto kTinyMaxA  = uint64_t{ 6 };
+    static constexpr auto kCacheMaxA = uint64_t{ 64 };
+    static constexpr auto kCacheLimit = uint64_t{ 1 } << 21;
+
+    /**
+     * @param primes - primes[i] is the i-th prime(primes[0] is unused), must contain atleast kCacheMaxA primes.
+     * @param pi - answers pi(n) for n <= pi.Limit(), must cover all primes of @param primes.
+     */
+    LegendrePhi(const std::vector<uint64_t> &primes, const PrimeCountTable &pi) : primes_{ primes }, pi_{ pi }
+    {
+        // tiny_[a][r] = phi(r, a) for r < p_1 * p_2 * ... * p_a
+        auto product = uint64_t{ 1 };
+        for (auto a = uint64_t{ 1 }; a <= kTinyMaxA ;++a)
+        {
+            product *= primes_[a];
+            tiny_[a].resize(product);
+            for (auto r = uint64_t{ 1 }; r < product ;++r)
+            {
+                auto is_coprime = true;
+                for (auto i = uint64_t{ 1 }; i <= a ;++i) { is_coprime = is_coprime && (0 != r % primes_[i]); }
+                tiny_[a][r] = tiny_[a][r - 1] + (is_coprime ? 1 : 0);
+            }
+            tiny_totient_[a] = tiny_[a].back(); // phi(product, a), product itself is not coprime
+        }
+
+        /*! Row a of the cache marks odd numbers below kCacheLimit that are not divisible by the
+            first a primes, row a + 1 is row a with odd multiples of p_(a+1) removed. */
+        constexpr auto kWords = kCacheLimit / 128;
+        auto survivors        = std::vector<uint64_t>(kWords, ~uint64_t{ 0 });
+        cache_words_.resize((kCacheMaxA + 1) * kWords);
+        cache_counts_.resize((kCacheMaxA + 1) * kWords);
+        for (auto a = uint64_t{ 1 }; a <= kCacheMaxA ;++a)
+        {
+            if (a >= 2)
+            {
+                for (auto idx = primes_[a] / 2; idx < kCacheLimit / 2 ;idx += primes_[a])
+                {
+                    survivors[idx / 64] &= ~(uint64_t{ 1 } << (idx % 64));
+                }
+            }
+            auto count = uint32_t{ 0 };
+            for (auto word = size_t{ 0 }; word < kWords ;++word)
+            {
+                cache_words_[a * kWords + word]  = survivors[word];
+                cache_counts_[a * kWords + word] = count;
+                count += std::popcount(survivors[word]);
+            }
+        }
+    }
+
+    int64_t operator()(const uint64_t &x, const uint64_t &a) const
+    {
+        if (a <= kTinyMaxA)      { return Tiny(x, a); }
+        if (x < primes_[a + 1])  { return (0 == x) ? 0 : 1; }
+        if (x <= pi_.Limit() && x < primes_[a + 1] * primes_[a + 1])
+        {
+            return static_cast<int64_t>(pi_(x)) - static_cast<int64_t>(a) + 1;
+        }
+        if (x < kCacheLimit && a <= kCacheMaxA) { return Cached(x, a); }
+
+        auto sum = Tiny(x, kTinyMaxA);
+        for (auto i = kTinyMaxA + 1; i <= a ;++i)
+        {
+            const auto kQuotient = x / primes_[i];
+            if (kQuotient < primes_[i])
+            {
+                // phi(x / p_j, j - 1) is 1 for every j >= i, as only 1 remains below p_j
+                sum -= static_cast<int64_t>(a - i + 1);
+                break;
+            }
+            sum -= (*this)(kQuotient, i - 1);
+        }
+        return sum;
+    }
+
+    /**
+     * @brief Returns phi(x, a) for a <= kTinyMaxA in constant time.
+     *      Numbers coprime to the primorial P repeat with period P, hence
+     *      phi(x, a) = (x / P) * phi(P, a) + phi(x % P, a).
+     */
+    int64_t Tiny(const uint64_t &x, const uint64_t &a) const
+    {
+        if (0 == a) { return static_cast<int64_t>(x); }
+
+        const auto kPrimorial = size(tiny_[a]);
+        return static_cast<int64_t>((x / kPrimorial) * tiny_totient_[a] + tiny_[a][x % kPrimorial]);
+    }
+
+private:
+    int64_t Cached(const uint64_t &x, const uint64_t &a) const
+    {
+        const auto kIdx = a * (kCacheLimit / 128) + x / 128;
+        return cache_counts_[kIdx] + std::popcount(cache_words_[kIdx] & PrimeCountTable::OddsUptoMask(x));
+    }
+
+    const std::vector<uint64_t>                  &primes_;
+    const PrimeCountTable                        &pi_;
+    std::array<std::vector<uint32_t>, kTinyMaxA + 1> tiny_;
+    std::array<uint64_t, kTinyMaxA + 1>            tiny_totient_{};
+    std::vector<uint64_t>                          cache_words_;
+    std::vector<uint32_t>                          cache_counts_;
+};
+
+/**
+ * @brief Returns number of primes <= @param x using Meissel's formula, see file comments.
+ *      Small values of x are answered directly from a PrimeCountTable.
+ * @param x
+ * @param thread_count - 0 is treated as 1
+ */
+inline uint64_t PrimeCount(const uint64_t &x, size_t thread_count = std::thread::hardware_concurrency())
+{
+    constexpr auto kDirectLimit = LegendrePhi::kCacheLimit;
+    if (x <= kDirectLimit) { return PrimeCountTable{ x }(x); }
+
+    thread_count          = std::max(thread_count, size_t{ 1 });
+    const auto kSqrtX     = IntegerSqrt(x);
+    auto cbrt_x           = uint64_t{ 1 };
+    while ((cbrt_x + 1) * (cbrt_x + 1) * (cbrt_x + 1) <= x) { ++cbrt_x; }
+
+    const auto kPi = PrimeCountTable{ kSqrtX };
+    auto primes    = std::vector<uint64_t>{ 0 }; // primes[i] is the i-th prime
+    for (auto n = uint64_t{ 2 }; n <= kSqrtX ;++n)
+    {
+        if (kPi(n) != kPi(n - 1)) { primes.push_back(n); }
+    }
+    const auto kA   = kPi(cbrt_x);
+    const auto kB   = kPi(kSqrtX);
+    const auto kPhi = LegendrePhi{ primes, kPi };
+
+    // phi(x, a) = phi(x, 6) - sum of phi(x / p_i, i - 1) for i in (6, a], terms are handed out dynamically
+    auto next_i      = std::atomic<uint64_t>{ LegendrePhi::kTinyMaxA + 1 };
+    auto phi_partial = std::vector<int64_t>(thread_count, 0);
+    auto threads     = std::vector<std::thread>{};
+    for (auto thread_idx = size_t{ 0 }; thread_idx < thread_count ;++thread_idx)
+    {
+        threads.push_back(std::thread{ [&, &sum = phi_partial[thread_idx]]()
+        {
+            for (auto i = next_i++; i <= kA ;i = next_i++) { sum -= kPhi(x / primes[i], i - 1); }
+        }});
+    }
+
+    /*! P2: pi(x / p_i) for i in (a, b]. Every x / p_i lies in [sqrt(x), x / p_(a+1)], pi(sqrt(x)) = b is known.
+        Odd numbers of (sqrt(x), x / p_(a+1)] are divided into one part per thread. Each thread sieves its part
+        and records, for the values x / p_i in its part, the count of primes from the start of its part upto them. */
+    struct P2Part
+    {
+        uint64_t first        = 0;
+        uint64_t last         = 0;
+        uint64_t prime_count  = 0; // primes in [first, last]
+        uint64_t target_count = 0; // values x / p_i in [first, last]
+        uint64_t local_sum    = 0; // sum of primes in [first, x / p_i] over those values
+    };
+    const auto kLow       = (kSqrtX + 1) | 1;
+    const auto kHigh      = x / primes[kA + 1];
+    const auto kOddCount  = (kHigh >= kLow) ? (kHigh - kLow) / 2 + 1 : 0;
+    const auto kPartOdds  = (kOddCount + thread_count - 1) / thread_count;
+    const auto kP2Sieve   = SegmentedPrimeSieve{ kHigh, 1 };
+    auto parts            = std::vector<P2Part>(thread_count);
+    for (auto part_idx = size_t{ 0 }; part_idx < thread_count ;++part_idx)
+    {
+        parts[part_idx].first = kLow + 2 * std::min(kOddCount, part_idx * kPartOdds);
+        parts[part_idx].last  = kLow + 2 * std::min(kOddCount, (part_idx + 1) * kPartOdds);
+        if (parts[part_idx].first == parts[part_idx].last) { continue; }
+        parts[part_idx].last -= 2; // inclusive, odd
+
+        threads.push_back(std::thread{ [&, &part = parts[part_idx]]()
+        {
+            auto bits = std::vector<uint64_t>(SegmentedPrimeSieve::kSegmentWords);
+            auto i    = kB; // values x / p_i increase as i decreases
+            while (i > kA && x / primes[i] < part.first) { --i; }
+
+            for (auto low = part.first; low <= part.last ;low += 2 * SegmentedPrimeSieve::kSegmentBits)
+            {
+                const auto kCount = std::min<uint64_t>(SegmentedPrimeSieve::kSegmentBits, (part.last - low) / 2 + 1);
+                kP2Sieve.SieveSegment(low, kCount, bits);
+
+                auto word_idx   = uint64_t{ 0 };
+                auto word_count = uint64_t{ 0 }; // primes in words [0, word_idx)
+                for (; i > kA && x / primes[i] <= low + 2 * (kCount - 1) ;--i)
+                {
+                    const auto kTarget = x / primes[i];
+                    auto count         = part.prime_count;
+                    if (kTarget >= low)
+                    {
+                        const auto kBit = (kTarget - low) / 2;
+                        for (; word_idx < kBit / 64 ;++word_idx) { word_count += std::popcount(bits[word_idx]); }
+                        const auto kMask = (kBit % 64 == 63) ? ~uint64_t{ 0 } : (uint64_t{ 1 } << (kBit % 64 + 1)) - 1;
+                        count += word_count + std::popcount(bits[word_idx] & kMask);
+                    }
+                    part.local_sum += count;
+                    ++part.target_count;
+                }
+                for (auto word = uint64_t{ 0 }; word < (kCount + 63) / 64 ;++word) { part.prime_count += std::popcount(bits[word]); }
+            }
+            // values x / p_i beyond the last odd number of the part, but before the next part
+            for (; i > kA && x / primes[i] <= part.last + 1 ;--i)
+            {
+                part.local_sum += part.prime_count;
+                ++part.target_count;
+            }
+        }});
+    }
+    for (auto &t : threads) { t.join(); }
+
+    // Targets below the first part i.e. equal to sqrt(x)
+    auto p2          = uint64_t{ 0 };
+    auto base        = kB;
+    auto targets     = uint64_t{ 0 };
+    for (const auto &part : parts)
+    {
+        p2      += part.local_sum + part.target_count * base;
+        base    += part.prime_count;
+        targets += part.target_count;
+    }
+    p2 += (kB - kA - targets) * kB;
+    for (auto i = kA + 1; i <= kB ;++i) { p2 -= i - 1; }
+
+    const auto kPhiX = kPhi.Tiny(x, LegendrePhi::kTinyMaxA) + std::accumulate(cbegin(phi_partial), cend(phi_partial), int64_t{ 0 });
+    return static_cast<uint64_t>(kPhiX) + kA - 1 - p2;
+}
+
+#endif // PRIME_COUNTING_H
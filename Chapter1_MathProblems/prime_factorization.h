@@ -0,0 +1,259 @@
+/**
+ * @file prime_factorization.h
+ * @author Usama Tayyab (usamatayyab9@gmail.com)
+ * @brief
+ *      This file provides factorization of arbitrary 64-bit numbers, used by 9_primes_factors.cpp.
+ *
+ *      Trial division needs upto sqrt(N) divisions, which for a semiprime near 2^63 is billions of
+ *      divisions. Instead this file implements:
+ *          1. MontgomeryForm64, which performs modular multiplication without any division, using
+ *             unsigned __int128 for the 128-bit products.
+ *          2. IsPrime64(), a deterministic Miller-Rabin test which is exact for every 64-bit number
+ *             using the 7 bases found by Jim Sinclair.
+ *          3. PollardRhoBrent(), Brent's variant of Pollard's rho algorithm, which finds a non-trivial
+ *             divisor of a composite number in roughly N^(1/4) steps.
+ *          4. FactorizePollardRho(), which combines the above to factorize a single number, and
+ *             FactorizeMany() which factorizes a list of numbers on multiple threads.
+ *      For more info visit:
+ *          - https://en.wikipedia.org/wiki/Montgomery_modular_multiplication
+ *          - https://en.wikipedia.org/wiki/Miller%E2%80%93Rabin_primality_test
+ *          - https://en.wikipedia.org/wiki/Pollard%27s_rho_algorithm#Variants
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PRIME_FACTORIZATION_H
+#define PRIME_FACTORIZATION_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <thread>
+#include <vector>
+
+using uint128_t = unsigned __int128;
+
+/**
+ * @brief Modular arithmetic for an odd modulus N using Montgomery representation i.e. a
+ *      value a is stored as a * 2^64 mod N. Values are always kept in the range [0, N).
+ */
+class MontgomeryForm64
+{
+public:
+    explicit MontgomeryForm64(const uint64_t &N) : N_{ N }
+    {
+        // Newton's iteration, each step doubles the number of correct low bits of N^-1 mod 2^64.
+        inverse_ = N;
+        for (auto i = 0; i < 5 ;++i) { inverse_ *= 2 - N * inverse_; }
+        one_        = (0 - N) % N; // 2^64 mod N
+        r_squared_  = static_cast<uint64_t>((uint128_t{ one_ } * one_) % N);
+    }
+
+    uint64_t Modulus() const { return N_; }
+    uint64_t One() const     { return one_; }
+
+    uint64_t ToMontgomery(const uint64_t &a) const   { return Multiply(a % N_, r_squared_); }
+    uint64_t FromMontgomery(const uint64_t &a) const { return Reduce(a); }
+
+    /**
+     * @brief Returns t * 2^-64 mod N. Computed as high(t) - high(m * N) where
+     *      m = low(t) * N^-1 mod 2^64, so that the low 64 bits cancel out exactly.
+     */
+    uint64_t Reduce(const uint128_t &t) const
+    {
+        const auto kM     = static_cast<uint64_t>(t) * inverse_;
+        const auto kHighT = static_cast<uint64_t>(t >> 64);
+        const auto kHighM = static_cast<uint64_t>((uint128_t{ kM } * N_) >> 64);
+        return (kHighT >= kHighM) ? (kHighT - kHighM) : (kHighT - kHighM + N_);
+    }
+
+    uint64_t Multiply(const uint64_t &a, const uint64_t &b) const { return Reduce(uint128_t{ a } * b); }
+
+    uint64_t Add(const uint64_t &a, const uint64_t &b) const
+    {
+        const auto kSum = a + b;
+        return (kSum >= N_ || kSum < a) ? kSum - N_ : kSum;
+    }
+
+    uint64_t Power(uint64_t base, uint64_t exponent) const
+    {
+        auto result = one_;
+        for (; 0 != exponent ;exponent >>= 1)
+        {
+            if (1 == (exponent & 1)) { result = Multiply(result, base); }
+            base = Multiply(base, base);
+        }
+        return result;
+    }
+
+private:
+    uint64_t N_;
+    uint64_t inverse_;   // N^-1 mod 2^64
+    uint64_t one_;       // Montgomery form of 1
+    uint64_t r_squared_; // 2^128 mod N, used to convert into Montgomery form
+};
+
+/**
+ * @brief Deterministic Miller-Rabin primality test, exact for all 64-bit numbers.
+ *      Numbers below 64 and numbers having a small factor are decided by trial
+ *      division, rest are tested against the bases
+ *      2, 325, 9375, 28178, 450775, 9780504 and 1795265022.
+ * @param N
+ * @return true if N is prime, false otherwise
+ */
+inline bool IsPrime64(const uint64_t &N)
+{
+    constexpr auto kSmallPrimes = std::array<uint64_t, 12>{ 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37 };
+    if (N < 2) { return false; }
+    for (const auto &prime : kSmallPrimes)
+    {
+        if (0 == N % prime) { return N == prime; }
+    }
+    if (N < 37 * 37) { return true; }
+
+    constexpr auto kBases = std::array<uint64_t, 7>{ 2, 325, 9375, 28178, 450775, 9780504, 1795265022 };
+    const auto kMont      = MontgomeryForm64{ N };
+    const auto kShift     = std::countr_zero(N - 1);
+    const auto kOddPart   = (N - 1) >> kShift;
+    const auto kMinusOne  = N - kMont.One(); // Montgomery form of N - 1
+    for (const auto &base : kBases)
+    {
+        if (0 == base % N) { continue; }
+
+        auto x = kMont.Power(kMont.ToMontgomery(base), kOddPart);
+        if (x == kMont.One() || x == kMinusOne) { continue; }
+
+        auto is_witness = true;
+        for (auto i = 1; i < kShift && is_witness ;++i)
+        {
+            x = kMont.Multiply(x, x);
+            if (x == kMinusOne) { is_witness = false; }
+        }
+        if (is_witness) { return false; }
+    }
+    return true;
+}
+
+/**
+ * @brief Returns a non-trivial divisor of an odd composite number @param N.
+ *      Iterates f(x) = x^2 + c in Montgomery form using Brent's cycle detection.
+ *      Differences |x - y| are multiplied together in batches of 128 so that only
+ *      one gcd is needed per batch. If a batch overshoots(gcd becomes N) the steps
+ *      of that batch are replayed one gcd at a time. If that still yields N, the
+ *      search restarts with the next value of c.
+ * @param N - must be odd and composite.
+ */
+inline uint64_t PollardRhoBrent(const uint64_t &N)
+{
+    constexpr auto kBatchSize = uint64_t{ 128 };
+    const auto kMont          = MontgomeryForm64{ N };
+    const auto kDistance      = [](const uint64_t &a, const uint64_t &b) { return a > b ? a - b : b - a; };
+
+    for (auto c = uint64_t{ 1 }; ;++c)
+    {
+        const auto kC = kMont.ToMontgomery(c);
+        const auto f  = [&kMont, kC](const uint64_t &x) { return kMont.Add(kMont.Multiply(x, x), kC); };
+
+        auto y       = kMont.ToMontgomery(2);
+        auto x       = y;
+        auto ys      = y;
+        auto product = kMont.One();
+        auto divisor = uint64_t{ 1 };
+        for (auto r = uint64_t{ 1 }; 1 == divisor ;r *= 2)
+        {
+            x = y;
+            for (auto i = uint64_t{ 0 }; i < r ;++i) { y = f(y); }
+            for (auto k = uint64_t{ 0 }; k < r && 1 == divisor ;k += kBatchSize)
+            {
+                ys = y;
+                for (auto i = uint64_t{ 0 }; i < std::min(kBatchSize, r - k) ;++i)
+                {
+                    y       = f(y);
+                    product = kMont.Multiply(product, kDistance(x, y));
+                }
+                divisor = std::gcd(product, N);
+            }
+        }
+        if (divisor == N)
+        {
+            do
+            {
+                ys      = f(ys);
+                divisor = std::gcd(kDistance(x, ys), N);
+            } while (1 == divisor);
+        }
+        if (divisor != N) { return divisor; }
+    }
+}
+
+/**
+ * @brief Returns all prime factors of @param N in ascending order, with repetition.
+ *      Factors below 64 are removed by trial division. Remaining cofactor is split
+ *      recursively using PollardRhoBrent() until every part passes IsPrime64().
+ * @param N
+ * @return A vector containing all the prime factors of N, empty for N < 2.
+ */
+inline std::vector<uint64_t> FactorizePollardRho(uint64_t N)
+{
+    auto prime_factors = std::vector<uint64_t>{};
+    if (N < 2) { return prime_factors; }
+
+    const auto kTrailingZeros = std::countr_zero(N);
+    prime_factors.insert(end(prime_factors), kTrailingZeros, 2);
+    N >>= kTrailingZeros;
+    for (auto d = uint64_t{ 3 }; d < 64 ;d += 2)
+    {
+        for (; 0 == N % d ;N /= d) { prime_factors.push_back(d); }
+    }
+
+    auto pending = std::vector<uint64_t>{};
+    if (N > 1) { pending.push_back(N); }
+    while (!pending.empty())
+    {
+        const auto kValue = pending.back();
+        pending.pop_back();
+        if (IsPrime64(kValue))
+        {
+            prime_factors.push_back(kValue);
+        }
+        else
+        {
+            const auto kDivisor = PollardRhoBrent(kValue);
+            pending.push_back(kDivisor);
+            pending.push_back(kValue / kDivisor);
+        }
+    }
+    std::sort(begin(prime_factors), end(prime_factors));
+    return prime_factors;
+}
+
+/**
+ * @brief Factorizes every number of @param numbers using FactorizePollardRho().
+ *      The input is divided into `thread_count` contiguous chunks, each chunk is
+ *      factorized by its own thread which writes into its own slots of the result.
+ * @param numbers
+ * @param thread_count - 0 is treated as 1
+ * @return result[i] contains the prime factors of numbers[i].
+ */
+inline std::vector<std::vector<uint64_t>> FactorizeMany(std::span<const uint64_t> numbers,
+    size_t thread_count = std::thread::hardware_concurrency())
+{
+    auto result        = std::vector<std::vector<uint64_t>>(size(numbers));
+    thread_count       = std::clamp(thread_count, size_t{ 1 }, std::max(size(numbers), size_t{ 1 }));
+    const auto kChunk  = (size(numbers) + thread_count - 1) / thread_count;
+    auto threads       = std::vector<std::thread>{};
+    for (auto first = size_t{ 0 }; first < size(numbers) ;first += kChunk)
+    {
+        threads.push_back(std::thread{ [first, last = std::min(first + kChunk, size(numbers)), numbers, &result]()
+        {
+            for (auto idx = first; idx < last ;++idx) { result[idx] = FactorizePollardRho(numbers[idx]); }
+        }});
+    }
+    for (auto &t : threads) { t.join(); }
+    return result;
+}
+
+#endif // PRIME_FACTORIZATION_H
@@ -0,0 +1,342 @@
+/**
+ * @file prime_sieve.h
+ * @author Usama Tayyab (usamatayyab9@gmail.com)
+ * @brief
+ *      This file provides a segmented Sieve of Eratosthenes that is shared by the prime
+ *      related problems of this chapter(4_largest_prime_smaller_than_given_number.cpp and
+ *      5_sexy_prime_numbers.cpp).
+ *
+ *      Layout of the sieve:
+ *          - Only odd numbers are stored, one bit per number. Bit i of a segment whose first
+ *            number is `low`(always odd) represents the number low + 2 * i. A set bit means
+ *            the number is prime.
+ *          - A segment is `kSegmentBytes` bytes long, which is sized to fit in L2 cache.
+ *            So a single segment covers 2 * 8 * kSegmentBytes consecutive integers.
+ *          - Primes upto sqrt(limit) are computed once in the constructor, and are used
+ *            for crossing off multiples in every segment.
+ *
+ *      Memory used is independent of the size of the range being sieved i.e. sieving upto
+ *      10^12 needs only sqrt(10^12) base primes plus one segment buffer per thread.
+ *
+ *      The class SegmentedPrimeSieve provides:
+ *          1. ForEachPrime() which visits all primes of a range in increasing order, sieving
+ *             segments on multiple threads.
+ *          2. Primes() which returns a lazy range of primes that sieves one segment at a time
+ *             on the calling thread, as the range is iterated.
+ *          3. PrevPrime() which returns the largest prime smaller than a given number.
+ *          4. SieveSegment() which sieves a single segment of odd numbers into a bitmap, for
+ *             callers that only need to count primes(see prime_counting.h).
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PRIME_SIEVE_H
+#define PRIME_SIEVE_H
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Returns floor(sqrt(N)) computed using integers only, so it is exact for all 64-bit values.
+ */
+constexpr uint64_t IntegerSqrt(const uint64_t &N)
+{
+    auto root = uint64_t{ 0 };
+    for (auto bit = uint64_t{ 1 } << 31; bit != 0 ;bit >>= 1)
+    {
+        if (const auto kCandidate = root | bit; kCandidate * kCandidate <= N)
+        {
+            root = kCandidate;
+        }
+    }
+    return root;
+}
+
+class SegmentedPrimeSieve
+{
+public:
+    static constexpr auto kSegmentBytes = size_t{ 128 * 1024 };
+    static constexpr auto kSegmentWords = kSegmentBytes / sizeof(uint64_t);
+    static constexpr auto kSegmentBits  = kSegmentBytes * 8;
+
+    class PrimeIterator;
+    class PrimeRange;
+
+    /**
+     * @brief Prepares a sieve that can answer queries for numbers upto and including @param limit.
+     *      Computes all odd primes upto sqrt(limit) using a plain odd-only sieve.
+     * @param limit - Largest number that will ever be queried from this sieve.
+     * @param thread_count - Number of threads used by ForEachPrime(), 0 is treated as 1.
+     */
+    explicit SegmentedPrimeSieve(const uint64_t &limit, const size_t &thread_count = std::thread::hardware_concurrency())
+        : limit_{ limit }, thread_count_{ std::max(thread_count, size_t{ 1 }) }
+    {
+        const auto kBaseLimit = IntegerSqrt(limit);
+        auto is_composite     = std::vector<bool>(kBaseLimit / 2 + 1, false); // index i represents 2 * i + 1
+        for (auto i = uint64_t{ 3 }; i <= kBaseLimit ;i += 2)
+        {
+            if (false == is_composite[i / 2])
+            {
+                base_primes_.push_back(static_cast<uint32_t>(i));
+                for (auto multiple = i * i; multiple <= kBaseLimit ;multiple += 2 * i)
+                {
+                    is_composite[multiple / 2] = true;
+                }
+            }
+        }
+    }
+
+    uint64_t Limit() const { return limit_; }
+
+    /**
+     * @brief Calls @param callback for every prime in the range [first, last] in increasing order.
+     *      Segments are handed out in batches, one segment per thread. Once all threads of a
+     *      batch finish, the primes of the batch are reported in order on the calling thread.
+     *      So @param callback does not need to be thread safe.
+     * @param first
+     * @param last - Must not be greater than Limit().
+     * @param callback - Any callable which accepts a uint64_t.
+     */
+    template<class Callback>
+    void ForEachPrime(const uint64_t &first, const uint64_t &last, Callback callback) const
+    {
+        if (first <= 2 && 2 <= last) { callback(uint64_t{ 2 }); }
+
+        auto low = std::max(first, uint64_t{ 3 }) | 1; // first odd number >= max(first, 3)
+        if (low > last) { return; }
+
+        auto buffers = std::vector<std::vector<uint64_t>>(thread_count_, std::vector<uint64_t>(kSegmentWords));
+        auto lows    = std::vector<uint64_t>(thread_count_);
+        auto counts  = std::vector<uint64_t>(thread_count_);
+        while (low <= last)
+        {
+            auto batch_size = size_t{ 0 };
+            for (; batch_size < thread_count_ && low <= last ;++batch_size)
+            {
+                lows[batch_size]   = low;
+                counts[batch_size] = std::min<uint64_t>(kSegmentBits, (last - low) / 2 + 1);
+                low += 2 * counts[batch_size];
+            }
+
+            if (1 == batch_size)
+            {
+                SieveSegment(lows[0], counts[0], buffers[0]);
+            }
+            else
+            {
+                auto threads = std::vector<std::thread>{};
+                for (auto idx = size_t{ 0 }; idx < batch_size ;++idx)
+                {
+                    threads.push_back(std::thread{ [this, idx, &lows, &counts, &buffers]()
+                    {
+                        SieveSegment(lows[idx], counts[idx], buffers[idx]);
+                    }});
+                }
+                for (auto &t : threads) { t.join(); }
+            }
+
+            for (auto idx = size_t{ 0 }; idx < batch_size ;++idx)
+            {
+                for (auto bit = NextSetBit(buffers[idx], 0, counts[idx]); bit < counts[idx] ;bit = NextSetBit(buffers[idx], bit + 1, counts[idx]))
+                {
+                    callback(lows[idx] + 2 * bit);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Returns the largest prime that is smaller than @param N, if any.
+     *      Sieves segments starting at N - 1 and moving downwards, and scans each
+     *      segment from its highest bit. Since gaps between primes upto 10^12 are
+     *      less than 1000 the first segment almost always contains the answer.
+     * @param N - Must not be greater than Limit() + 1.
+     */
+    std::optional<uint64_t> PrevPrime(const uint64_t &N) const
+    {
+        auto result = std::optional<uint64_t>{};
+        if (N == 3) { result = 2; }
+        else if (N > 3)
+        {
+            auto high   = (N - 2) | 1; // largest odd number < N
+            auto buffer = std::vector<uint64_t>(kSegmentWords);
+            while (!result && high >= 3)
+            {
+                const auto kCount = std::min<uint64_t>(kSegmentBits, (high - 3) / 2 + 1);
+                const auto kLow   = high - 2 * (kCount - 1);
+                SieveSegment(kLow, kCount, buffer);
+                if (const auto kBit = PrevSetBit(buffer, kCount); kBit < kCount)
+                {
+                    result = kLow + 2 * kBit;
+                }
+                high = kLow - 2;
+            }
+            if (!result) { result = 2; }
+        }
+        return result;
+    }
+
+    /**
+     * @brief Returns a lazy range over all primes in [first, last]. Unlike ForEachPrime()
+     *      the range sieves on the calling thread, one segment at a time while being iterated.
+     */
+    PrimeRange Primes(const uint64_t &first, const uint64_t &last) const;
+
+    /**
+     * @brief Sieves @param count odd numbers starting at @param low into @param bits.
+     *      All bits are first set. Then for each base prime p, its odd multiples starting
+     *      from max(p * p, first multiple of p >= low) are cleared.
+     *      Bit i of @param bits represents the number low + 2 * i, a set bit means it is prime.
+     * @param low - must be odd.
+     * @param count - at most kSegmentBits, low + 2 * (count - 1) must not be greater than Limit().
+     * @param bits - must have atleast (count + 63) / 64 words.
+     */
+    void SieveSegment(const uint64_t &low, const uint64_t &count, std::vector<uint64_t> &bits) const
+    {
+        const auto kWords = (count + 63) / 64;
+        std::fill(begin(bits), begin(bits) + kWords, ~uint64_t{ 0 });
+        if (const auto kTailBits = count % 64; 0 != kTailBits)
+        {
+            bits[kWords - 1] = (uint64_t{ 1 } << kTailBits) - 1;
+        }
+
+        const auto kHigh = low + 2 * (count - 1);
+        for (const auto &prime : base_primes_)
+        {
+            const auto kPrime = uint64_t{ prime };
+            if (kPrime * kPrime > kHigh) { break; }
+
+            auto start = std::max(kPrime * kPrime, ((low + kPrime - 1) / kPrime) * kPrime);
+            if (0 == (start & 1)) { start += kPrime; }
+            for (auto idx = (start - low) / 2; idx < count ;idx += kPrime)
+            {
+                bits[idx / 64] &= ~(uint64_t{ 1 } << (idx % 64));
+            }
+        }
+        if (1 == low) { bits[0] &= ~uint64_t{ 1 }; } // 1 is not a prime number
+    }
+
+private:
+    /**
+     * @brief Returns position of first set bit at or after @param from, or @param count if there is none.
+     */
+    static uint64_t NextSetBit(const std::vector<uint64_t> &bits, const uint64_t &from, const uint64_t &count)
+    {
+        auto word_idx = from / 64;
+        if (from >= count) { return count; }
+
+        auto word = bits[word_idx] & (~uint64_t{ 0 } << (from % 64));
+        const auto kWords = (count + 63) / 64;
+        while (0 == word)
+        {
+            if (++word_idx == kWords) { return count; }
+            word = bits[word_idx];
+        }
+        return word_idx * 64 + std::countr_zero(word);
+    }
+
+    /**
+     * @brief Returns position of the last set bit among the first @param count bits, or @param count if there is none.
+     */
+    static uint64_t PrevSetBit(const std::vector<uint64_t> &bits, const uint64_t &count)
+    {
+        for (auto word_idx = (count + 63) / 64; word_idx > 0 ;--word_idx)
+        {
+            if (const auto kWord = bits[word_idx - 1]; 0 != kWord)
+            {
+                return (word_idx - 1) * 64 + 63 - std::countl_zero(kWord);
+            }
+        }
+        return count;
+    }
+
+    uint64_t              limit_;
+    size_t                thread_count_;
+    std::vector<uint32_t> base_primes_; // odd primes upto sqrt(limit_)
+};
+
+/**
+ * @brief A forward iterator over primes of a range, holding a single segment buffer.
+ *      Compares equal to std::default_sentinel once all primes of the range are visited.
+ */
+class SegmentedPrimeSieve::PrimeIterator
+{
+public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type        = uint64_t;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const uint64_t *;
+    using reference         = const uint64_t &;
+
+    PrimeIterator() = default;
+    PrimeIterator(const SegmentedPrimeSieve *sieve, const uint64_t &first, const uint64_t &last)
+        : sieve_{ sieve }, last_{ last }, low_{ std::max(first, uint64_t{ 3 }) | 1 }
+    {
+        if (first <= 2 && 2 <= last) { value_ = 2; }
+        else                         { Advance(); }
+    }
+
+    reference operator*() const { return value_; }
+    PrimeIterator& operator++() { Advance(); return *this; }
+    void operator++(int) { Advance(); }
+
+    friend bool operator==(const PrimeIterator &iter, std::default_sentinel_t) { return iter.done_; }
+
+private:
+    void Advance()
+    {
+        while (true)
+        {
+            if (const auto kBit = NextSetBit(bits_, next_bit_, count_); kBit < count_)
+            {
+                value_    = low_ + 2 * kBit;
+                next_bit_ = kBit + 1;
+                return;
+            }
+            low_ += 2 * count_;
+            if (low_ > last_) { done_ = true; return; }
+
+            count_    = std::min<uint64_t>(kSegmentBits, (last_ - low_) / 2 + 1);
+            next_bit_ = 0;
+            bits_.resize(kSegmentWords);
+            sieve_->SieveSegment(low_, count_, bits_);
+        }
+    }
+
+    const SegmentedPrimeSieve *sieve_ = nullptr;
+    uint64_t last_     = 0;
+    uint64_t low_      = 0; // first number represented by current segment
+    uint64_t count_    = 0; // odd numbers in current segment, 0 until first segment is sieved
+    uint64_t next_bit_ = 0;
+    uint64_t value_    = 0;
+    bool     done_     = false;
+    std::vector<uint64_t> bits_;
+};
+
+class SegmentedPrimeSieve::PrimeRange
+{
+public:
+    PrimeRange(const SegmentedPrimeSieve *sieve, const uint64_t &first, const uint64_t &last)
+        : sieve_{ sieve }, first_{ first }, last_{ last }
+    {
+    }
+    PrimeIterator begin() const { return PrimeIterator{ sieve_, first_, last_ }; }
+    std::default_sentinel_t end() const { return std::default_sentinel; }
+
+private:
+    const SegmentedPrimeSieve *sieve_;
+    uint64_t first_;
+    uint64_t last_;
+};
+
+inline SegmentedPrimeSieve::PrimeRange SegmentedPrimeSieve::Primes(const uint64_t &first, const uint64_t &last) const
+{
+    return PrimeRange{ this, first, last };
+}
+
+#endif // PRIME_SIEVE_H
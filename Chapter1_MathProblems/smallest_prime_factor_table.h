@@ -0,0 +1,248 @@
+/**
+ * @file smallest_prime_factor_table.h
+ * @author Usama Tayyab (usamatayyab9@gmail.com)
+ * @brief
+ *      This file provides a smallest prime factor(spf) table, which is used by 9_primes_factors.cpp
+ *      for factorizing every number of a range.
+ *
+ *      The table is built in a single pass using a linear sieve i.e. each composite number is
+ *      written exactly once, by its smallest prime factor. Once built, factorizing any n <= limit
+ *      is O(log n) lookups: n is repeatedly divided by spf(n) until it becomes 1.
+ *
+ *      Layout of the table:
+ *          - Only odd numbers are stored. Entry i represents the number 2 * i + 1. Factors of 2
+ *            are removed using std::countr_zero before any lookup.
+ *          - Entries are 16-bit. Smallest prime factor of a composite n is at most sqrt(n), so for
+ *            limit < 2^32 it always fits in 16 bits. For primes the entry is 0, meaning n itself.
+ *          - Hence the table needs limit bytes of memory, e.g. 100MB for limit = 10^8.
+ *
+ *      SmallestPrimeFactorTable::LoadOrBuild() can optionally cache the table in a file. If the
+ *      file already contains a table for the same limit, it is memory-mapped read-only instead
+ *      of being rebuilt, so repeated runs start instantly. The file is replaced by rename(), never
+ *      rewritten in place, so processes which have it mapped are not affected.
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef SMALLEST_PRIME_FACTOR_TABLE_H
+#define SMALLEST_PRIME_FACTOR_TABLE_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class SmallestPrimeFactorTable
+{
+public:
+    static constexpr auto kMaxLimit = uint64_t{ 0xFFFF'FFFF };
+
+    SmallestPrimeFactorTable(const SmallestPrimeFactorTable &) = delete;
+    SmallestPrimeFactorTable& operator=(const SmallestPrimeFactorTable &) = delete;
+
+    /**
+     * @brief Builds the table for all numbers upto @param limit using a linear sieve
+     *      over odd numbers. @param limit is clamped to kMaxLimit.
+     */
+    explicit SmallestPrimeFactorTable(const uint64_t &limit) : limit_{ std::min(limit, kMaxLimit) }
+    {
+        storage_.assign(limit_ / 2 + 1, 0);
+        auto primes = std::vector<uint32_t>{};
+        for (auto i = uint64_t{ 3 }; i <= limit_ ;i += 2)
+        {
+            const auto kEntry = storage_[i / 2];
+            if (0 == kEntry) { primes.push_back(static_cast<uint32_t>(i)); }
+
+            /*! Every odd composite m = p * i, where p = spf(m) and i = m / p has no prime
+                factor smaller than p. So for each i only primes p <= spf(i) are used. */
+            const auto kSpfOfI = (0 == kEntry) ? i : uint64_t{ kEntry };
+            for (const auto &prime : primes)
+            {
+                if (prime > kSpfOfI || prime * i > limit_) { break; }
+                storage_[(prime * i) / 2] = static_cast<uint16_t>(prime);
+            }
+        }
+        entries_ = storage_.data();
+    }
+
+    SmallestPrimeFactorTable(SmallestPrimeFactorTable &&rref) noexcept
+    {
+        *this = std::move(rref);
+    }
+
+    SmallestPrimeFactorTable& operator=(SmallestPrimeFactorTable &&rref) noexcept
+    {
+        if (this != &rref)
+        {
+            Unmap();
+            limit_        = rref.limit_;
+            storage_      = std::move(rref.storage_);
+            mapping_      = std::exchange(rref.mapping_, nullptr);
+            mapping_size_ = std::exchange(rref.mapping_size_, 0);
+            entries_      = mapping_ ? rref.entries_ : storage_.data();
+            rref.entries_ = nullptr;
+        }
+        return *this;
+    }
+
+    ~SmallestPrimeFactorTable()
+    {
+        Unmap();
+    }
+
+    /**
+     * @brief Memory-maps the table for @param limit from @param cache_file if the file holds
+     *      a table for exactly that limit. Otherwise builds the table and saves it to
+     *      @param cache_file, so that the next call can map it. Failing to save the file is not
+     *      an error, the built table is returned anyway.
+     */
+    static SmallestPrimeFactorTable LoadOrBuild(const uint64_t &limit, std::string_view cache_file)
+    {
+        auto table = SmallestPrimeFactorTable{};
+        table.limit_ = std::min(limit, kMaxLimit);
+        if (false == table.Map(cache_file))
+        {
+            table = SmallestPrimeFactorTable{ limit };
+            table.Save(cache_file);
+        }
+        return table;
+    }
+
+    uint64_t Limit() const { return limit_; }
+
+    /**
+     * @brief Returns the smallest prime factor of @param N, where 2 <= N <= Limit().
+     */
+    uint64_t SmallestPrimeFactor(const uint64_t &N) const
+    {
+        if (0 == (N & 1)) { return 2; }
+        const auto kEntry = entries_[N / 2];
+        return (0 == kEntry) ? N : kEntry;
+    }
+
+    /**
+     * @brief Returns all prime factors of @param N in ascending order, with repetition.
+     *      N must not be greater than Limit(). Returns an empty vector for N < 2.
+     */
+    std::vector<size_t> Factorize(uint64_t N) const
+    {
+        auto prime_factors = std::vector<size_t>{};
+        if (N < 2) { return prime_factors; }
+
+        const auto kTrailingZeros = std::countr_zero(N);
+        prime_factors.insert(end(prime_factors), kTrailingZeros, 2);
+        for (N >>= kTrailingZeros; N > 1 ;)
+        {
+            const auto kFactor = SmallestPrimeFactor(N);
+            prime_factors.push_back(kFactor);
+            N /= kFactor;
+        }
+        return prime_factors;
+    }
+
+private:
+    static constexpr auto kMagic = std::array<char, 8>{ 'S', 'P', 'F', 'T', 'A', 'B', '1', '6' };
+
+    struct FileHeader
+    {
+        std::array<char, 8> magic;
+        uint64_t            limit;
+    };
+
+    SmallestPrimeFactorTable() = default;
+
+    size_t EntryCount() const { return limit_ / 2 + 1; }
+
+    /**
+     * @brief Maps @param file into memory if its header matches kMagic and limit_, and its
+     *      size matches the number of entries. Returns true on success.
+     */
+    bool Map(std::string_view file)
+    {
+        const auto kFd = open(std::string{ file }.c_str(), O_RDONLY);
+        if (-1 == kFd) { return false; }
+
+        const auto kExpectedSize = sizeof(FileHeader) + EntryCount() * sizeof(uint16_t);
+        auto header              = FileHeader{};
+        struct stat file_stat{};
+        auto is_valid            = (0 == fstat(kFd, &file_stat)) && (static_cast<size_t>(file_stat.st_size) == kExpectedSize) &&
+                                   (sizeof(header) == read(kFd, &header, sizeof(header))) &&
+                                   (kMagic == header.magic) && (limit_ == header.limit);
+        if (is_valid)
+        {
+            auto *mapping = mmap(nullptr, kExpectedSize, PROT_READ, MAP_SHARED, kFd, 0);
+            if (MAP_FAILED == mapping)
+            {
+                is_valid = false;
+            }
+            else
+            {
+                madvise(mapping, kExpectedSize, MADV_WILLNEED);
+                mapping_      = mapping;
+                mapping_size_ = kExpectedSize;
+                entries_      = reinterpret_cast<const uint16_t *>(static_cast<const char *>(mapping) + sizeof(FileHeader));
+            }
+        }
+        close(kFd);
+        return is_valid;
+    }
+
+    /**
+     * @brief Writes the table to a sibling temporary file and renames it to @param file. The existing
+     *      file is never truncated, as another process may have it mapped and would get SIGBUS on
+     *      touching the truncated pages. rename() replaces it atomically, mappings of the old file
+     *      stay valid.
+     */
+    void Save(std::string_view file) const
+    {
+        const auto kTarget    = std::filesystem::path{ file };
+        auto       temp_file  = kTarget;
+        temp_file            += ".tmp." + std::to_string(getpid());
+        {
+            auto output = std::ofstream{ temp_file, std::ios::binary | std::ios::trunc };
+            const auto kHeader = FileHeader{ kMagic, limit_ };
+            output.write(reinterpret_cast<const char *>(&kHeader), sizeof(kHeader));
+            output.write(reinterpret_cast<const char *>(entries_), EntryCount() * sizeof(uint16_t));
+            output.close();
+            if (!output)
+            {
+                auto ignored = std::error_code{};
+                std::filesystem::remove(temp_file, ignored);
+                return;
+            }
+        }
+        auto error = std::error_code{};
+        std::filesystem::rename(temp_file, kTarget, error);
+        if (error) { std::filesystem::remove(temp_file, error); }
+    }
+
+    void Unmap()
+    {
+        if (nullptr != mapping_)
+        {
+            munmap(mapping_, mapping_size_);
+            mapping_      = nullptr;
+            mapping_size_ = 0;
+        }
+    }
+
+    uint64_t              limit_        = 0;
+    std::vector<uint16_t> storage_;                // entries when the table is built in memory
+    void                 *mapping_      = nullptr; // entries when the table is mapped from a file
+    size_t                mapping_size_ = 0;
+    const uint16_t       *entries_      = nullptr; // entry i is spf(2 * i + 1), 0 for primes
+};
+
+#endif // SMALLEST_PRIME_FACTOR_TABLE_H
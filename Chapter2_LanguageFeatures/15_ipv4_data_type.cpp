@@ -2,7 +2,7 @@
  * @file 15_ipv4_data_type.cpp
  * @author Usama Tayyab (usamtayyab9@gmail.com)
  * @brief 
- *      Compilation command : g++ -std=c++17 15_ipv4_data_type.cpp
+ *      Compilation command : g++ -std=c++20 -O2 -mavx2 15_ipv4_data_type.cpp
  *      This file is solution to "Problem 15. IPv4 data type"
  *      mentioned in "Chapter 2: Language Features" of the book:
  *      - The Modern C++ Challenge by Marius Bancilla (available at amazon https://www.amazon.com/Modern-Challenge-programmer-real-world-problems/dp/1788993861)
@@ -13,87 +13,80 @@
  *      values in dotted form, such as 127.0.0.1 or 168.192.0.100. This is also the form in
  *      which IPv4 addresses should be formatted to an output stream."
  *      
- *      This file implements a class `IPV4` which provides all the functionality for solving this
+ *      Class `IPV4` is implemented in ipv4.h which provides all the functionality for solving this
  *      problem i.e. constructing an IPV4 address, conversion to string, print on stream and taking
- *      input from stream.
+ *      input from stream. The address is stored as a single uint32_t, and conversions from and to
+ *      text are done by FromChars() and ToChars() without any allocation, see ipv4.h for details.
  *      Driver code:
  *      An IPV4 object is constructed using an IP address and then printed on console. Afterwards
- *      an IPV4 adress is takes as input from user and the printed on the console.
+ *      an IPV4 adress is takes as input from user and the printed on the console, an invalid address
+ *      is reported.
+ *      Afterwards FromChars() and ToChars() are verified against each other and against the stream
+ *      operators, and the time for parsing and formatting `kBulkCount` addresses is printed.
  *      
  * @copyright Copyright (c) 2023
  * 
  */
 #include <iostream>
 #include <string>
-#include <cstddef>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cassert>
 #include <sstream>
-#include <locale>
-#include <array>
 
-using std::byte;
+#include "ipv4.h"
+
 using std::cin;
 using std::cout;
 using std::endl;
-using std::istream;
-using std::ostream;
 using std::string;
+using std::vector;
 using std::stringstream;
-using std::to_integer;
-using std::array;
+using std::mt19937;
+using std::uniform_int_distribution;
+using std::chrono::steady_clock;
+using std::chrono::duration;
+
+inline constexpr auto kBulkCount = size_t{ 10'000'000 };
 
 /**
- * @brief A class for representing an IPV4 address
- * 
+ * @brief Checks ToChars() and FromChars() against each other and against the stream
+ *      operators, including some invalid addresses.
  */
-class IPV4
+void VerifyConversions()
 {
-    using octet_type = unsigned char;
-    octet_type octet1{0};
-    octet_type octet2{0};
-    octet_type octet3{0};
-    octet_type octet4{0};
-
-public:
-    IPV4() = default;
-    IPV4(const octet_type b1, const octet_type b2, const octet_type b3, const octet_type b4) : 
-      octet1{b1},
-      octet2{b2},
-      octet3{b3},
-      octet4{b4}
+    auto buffer = std::array<char, 32>{};
+    auto parsed = IPV4{};
+    auto random_engine = mt19937{ 15 };
+    auto distribution  = uniform_int_distribution<uint32_t>{};
+    for (auto i = 0; i < 100'000 ;++i)
     {
-    }
+        const auto kAddress = IPV4{ distribution(random_engine) };
+        const auto kEnd     = ToChars(buffer.data(), buffer.data() + size(buffer), kAddress).ptr;
+        const auto kResult  = FromChars(buffer.data(), kEnd, parsed);
+        assert(std::errc{} == kResult.ec && kEnd == kResult.ptr && kAddress == parsed);
 
-    string ToString() const
-    {
         auto ss = stringstream{};
-        ss << static_cast<int>(octet1) << '.'
-           << static_cast<int>(octet2) << '.'
-           << static_cast<int>(octet3) << '.'
-           << static_cast<int>(octet4);
-        return ss.str();
+        ss << kAddress;
+        const auto kExtracted = static_cast<bool>(ss >> parsed);
+        assert(ss.str() == kAddress.ToString() && kExtracted && kAddress == parsed);
     }
 
-    friend istream &operator>>(istream &in, IPV4 &address)
+    for (const auto &kText : { "1.2.3", "1.2.3.4.5", "256.1.1.1", "1..2.3", "1.2.3.1000", ".1.2.3.4", "1.2.3.4.", "a.b.c.d", "1234.1.1.1" })
     {
-        auto dot1 = '\0', dot2 = '\0', dot3 = '\0';
-        auto octet1 = 0, octet2 = 0, octet3 = 0, octet4 = 0;
-        in >> octet1 >> dot1 >> octet2 >> dot2 >> octet3 >> dot3 >> octet4;
-        if ('.' == dot1 && '.' == dot2 && '.' == dot3) {
-            address.octet1 = octet1;
-            address.octet2 = octet2;
-            address.octet3 = octet3;
-            address.octet4 = octet4;
+        // Padded to 16 characters as well so that both the scalar and vectorized parsers are checked
+        for (const auto &kInput : { string{ kText }, string{ kText } + "                " })
+        {
+            const auto kResult = FromChars(kInput.data(), kInput.data() + size(kInput), parsed);
+            assert(std::errc::invalid_argument == kResult.ec && kInput.data() == kResult.ptr);
         }
-
-        return in;
     }
-};
-
-template<class StreamType> 
-StreamType& operator<<(StreamType &out, const IPV4 &address)
-{
-    out << address.ToString();
-    return out;
+    const auto kInput  = string{ "10.0.0.255/8 and more text" };
+    const auto kResult = FromChars(kInput.data(), kInput.data() + size(kInput), parsed);
+    assert(std::errc{} == kResult.ec && kInput.data() + 10 == kResult.ptr && IPV4(10, 0, 0, 255) == parsed);
+    const auto kTooSmall = ToChars(buffer.data(), buffer.data() + 14, IPV4(255, 255, 255, 255));
+    assert(std::errc::value_too_large == kTooSmall.ec);
 }
 
 int main()
@@ -101,8 +94,39 @@ int main()
     auto address1 = IPV4{192, 168, 1, 121};
     cout << address1.ToString() << endl;
     cout << "Please enter an IPv4 address:";
-    cin >> address1;
-    cout << address1 << endl;
+    if (cin >> address1) { cout << address1 << endl; }
+    else                 { cout << "Invalid IPv4 address" << endl; }
+
+    VerifyConversions();
 
+    // Addresses separated by new lines, as they would appear in a log file
+    auto text          = string{};
+    auto random_engine = mt19937{ 16 };
+    auto distribution  = uniform_int_distribution<uint32_t>{};
+    text.resize(kBulkCount * (IPV4::kMaxLength + 1));
+    auto *current = text.data();
+    auto start_timepoint = steady_clock::now();
+    for (auto i = size_t{ 0 }; i < kBulkCount ;++i)
+    {
+        current  = ToChars(current, text.data() + size(text), IPV4{ distribution(random_engine) }).ptr;
+        *current++ = '\n';
+    }
+    text.resize(current - text.data());
+    cout << "Formatted " << kBulkCount << " addresses in "
+         << duration<double>(steady_clock::now() - start_timepoint).count() << " s" << endl;
+
+    auto checksum  = uint32_t{ 0 };
+    auto address   = IPV4{};
+    const auto *kEnd = text.data() + size(text);
+    start_timepoint  = steady_clock::now();
+    for (const auto *position = text.data(); position < kEnd ;)
+    {
+        const auto kResult = FromChars(position, kEnd, address);
+        assert(std::errc{} == kResult.ec);
+        checksum ^= address.ToInteger();
+        position  = kResult.ptr + 1;
+    }
+    cout << "Parsed " << kBulkCount << " addresses(" << size(text) / (1 << 20) << " MB) in "
+         << duration<double>(steady_clock::now() - start_timepoint).count() << " s, checksum " << checksum << endl;
     return 0;
 }
\ No newline at end of file
@@ -2,7 +2,7 @@
  * @file 16_enumerating_ipv4.cpp
  * @author Usama Tayyab (usamatayyab9@gmail.com)
  * @brief 
- *      Compilation command: g++ -std=c++17 16_enumerating_ipv4.cpp
+ *      Compilation command: g++ -std=c++20 -O2 -mavx2 16_enumerating_ipv4.cpp -lpthread
  *      
  *      This file is solution to "Problem 16. Enumerating IPv4 addresses in a range"
  *      mentioned in "Chapter 2: Language Features" of the book:
@@ -13,154 +13,233 @@
  *       list all the addresses in that range. Extend the structure defined for the previous problem to
  *       implement the requested functionality."
  *      
- *      This file implements a class `IPV4` which provides all the functionality for solving this
- *      problem i.e. constructing an IPV4 address, conversion to string, print on stream, taking
- *      input from stream, converting an IPV4 address to it integer value, comparing two IPV4
- *      addresses and incrementing and IPV4 address. See function for implementation details.
+ *      Class `IPV4` from ipv4.h provides all the functionality for solving this problem i.e. constructing
+ *      an IPV4 address, conversion to string, print on stream, taking input from stream, converting an
+ *      IPV4 address to it integer value, comparing two IPV4 addresses and incrementing and IPV4 address.
+ *      Since the address is stored as a single uint32_t, comparing and incrementing are single integer
+ *      operations. A range of addresses is represented by `IPV4Range`, which has a random access iterator
+ *      and can also be constructed from a CIDR block such as 10.0.0.0/8.
  * 
  * Driver code:
  *  Program first takes two IP addresses as input from user. Then prints all IP addresses starting from
- *  first IP address entered by the user upto second IP address entered by the user.
+ *  first IP address entered by the user upto second IP address entered by the user, both inclusive.
+ *  Afterwards every address of the block `kBenchmarkCIDR` is enumerated and formatted into a buffer
+ *  with ToChars(), and the time taken is printed.
+ *  Then the longest prefix match table `IPV4RoutingTable` from ipv4_routing_table.h is checked against a
+ *  linear search over `kVerifyPrefixCount` random prefixes, built through a prefix file. Then a table is
+ *  built from the prefix file given as first command line argument, or else from `kRandomPrefixCount`
+ *  random prefixes, and the time for looking up `kLookupCount` random addresses is printed. Finally
+ *  lookups are done from `kSwapReaderCount` threads while another thread keeps swapping the table.
+ *  Usage: 16_enumerating_ipv4 [prefix_file]
  * @copyright Copyright (c) 2023
  * 
  */
 #include <iostream>
 #include <string>
-#include <cstddef>
-#include <sstream>
-#include <locale>
-#include <array>
+#include <vector>
+#include <chrono>
+#include <cassert>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <filesystem>
+#include <optional>
+
+#include "ipv4.h"
+#include "ipv4_routing_table.h"
 
-using std::byte;
 using std::cin;
 using std::cout;
 using std::endl;
-using std::istream;
-using std::ostream;
 using std::string;
-using std::stringstream;
-using std::to_integer;
-using std::array;
+using std::vector;
+using std::thread;
+using std::optional;
+using std::mt19937;
+using std::uniform_int_distribution;
+using std::discrete_distribution;
+using std::make_shared;
+using std::chrono::steady_clock;
+using std::chrono::duration;
+
+inline constexpr auto kBenchmarkCIDR     = "10.0.0.0/8";
+inline constexpr auto kVerifyPrefixCount = size_t{ 2'000 };
+inline constexpr auto kRandomPrefixCount = size_t{ 300'000 };
+inline constexpr auto kLookupCount       = size_t{ 10'000'000 };
+inline constexpr auto kSwapReaderCount   = size_t{ 4 };
 
 /**
- * @brief A class for representing an IPV4 address
- * 
+ * @brief Generates @param count random prefixes, most of them /24 and /16 to /23 as in internet routing tables.
  */
-class IPV4
+vector<IPV4Prefix> RandomPrefixes(const size_t &count, mt19937 &random_engine)
 {
-    using octet_type = unsigned char;
-    octet_type octet1{0};
-    octet_type octet2{0};
-    octet_type octet3{0};
-    octet_type octet4{0};
-
-public:
-    IPV4() = default;
-    IPV4(const octet_type b1, const octet_type b2, const octet_type b3, const octet_type b4) : 
-      octet1{b1},
-      octet2{b2},
-      octet3{b3},
-      octet4{b4}
+    auto address_distribution = uniform_int_distribution<uint32_t>{};
+    auto length_distribution  = discrete_distribution<int>{ { 1, 1, 1, 1, 1, 1, 1, 1,   // /8 to /15
+                                                              5, 5, 5, 5, 5, 5, 5, 5,   // /16 to /23
+                                                              60,                       // /24
+                                                              1, 1, 1, 1, 1, 1, 1, 1 } };// /25 to /32
+    auto prefixes = vector<IPV4Prefix>{};
+    for (auto idx = size_t{ 0 }; idx < count ;++idx)
     {
+        prefixes.push_back({ IPV4{ address_distribution(random_engine) }, static_cast<uint8_t>(8 + length_distribution(random_engine)),
+                             static_cast<uint32_t>(idx) });
     }
+    return prefixes;
+}
 
-    string ToString() const
+/**
+ * @brief Returns next hop of the longest prefix containing @param address by checking every prefix.
+ */
+optional<uint32_t> LinearLongestPrefixMatch(const vector<IPV4Prefix> &prefixes, const IPV4 &address)
+{
+    auto best        = optional<uint32_t>{};
+    auto best_length = -1;
+    for (const auto &kPrefix : prefixes)
     {
-        auto ss = stringstream{};
-        ss << static_cast<int>(octet1) << '.'
-           << static_cast<int>(octet2) << '.'
-           << static_cast<int>(octet3) << '.'
-           << static_cast<int>(octet4);
-        return ss.str();
+        const auto kHostMask = static_cast<uint32_t>((uint64_t{ 1 } << (32 - kPrefix.length)) - 1);
+        if (((kPrefix.address.ToInteger() ^ address.ToInteger()) & ~kHostMask) == 0 && kPrefix.length >= best_length)
+        {
+            best        = kPrefix.next_hop;
+            best_length = kPrefix.length;
+        }
     }
+    return best;
+}
 
-    /**
-     * @brief Converts an IPV4 address to its integer equivalent
-     * Consider 172.16.254.1 as an example:
-     * Since IPV4 is an 32-bit number grouped into 4 octets(bytes) 
-     * First convert each octet into binary of 8 bits.
-     * 172 = 10101100
-     * 16  = 00010000
-     * 254 = 11111110
-     * 1   = 00000001
-     * After writing binary together and converting to base-10 we get:
-     * (10101100 00010000 11111110 00000001) base-2 = (2886794753) base-10
-     * 
-     *  @return uint32_t - integer representation of an IPV4 address
-     */
-    uint32_t ToInteger() const
+void VerifyRoutingTable(mt19937 &random_engine)
+{
+    const auto kPrefixes = RandomPrefixes(kVerifyPrefixCount, random_engine);
+    const auto kPath     = (std::filesystem::temp_directory_path() / "16_enumerating_ipv4_prefixes.txt").string();
     {
-        auto value = (static_cast<uint32_t>(octet1) << 24) + (static_cast<uint32_t>(octet2) << 16)
-            + (static_cast<uint32_t>(octet3) << 8) + static_cast<uint32_t>(octet4);
-        return value;
+        auto file = std::ofstream{ kPath };
+        file << "# address/length next_hop\n";
+        for (const auto &kPrefix : kPrefixes) { file << kPrefix.address << '/' << int{ kPrefix.length } << ' ' << kPrefix.next_hop << '\n'; }
     }
+    const auto kTable = IPV4RoutingTable::FromFile(kPath);
+    std::filesystem::remove(kPath);
+    assert(kTable && kVerifyPrefixCount == kTable->PrefixCount());
 
-    bool operator<(const IPV4 &rhs) const
+    // Addresses near prefixes are more interesting than uniformly random ones
+    auto addresses    = vector<IPV4>{};
+    auto distribution = uniform_int_distribution<uint32_t>{};
+    for (auto idx = 0; idx < 100'000 ;++idx)
+    {
+        const auto kRandom = distribution(random_engine);
+        addresses.push_back(IPV4{ (idx % 2) ? kRandom : kPrefixes[kRandom % size(kPrefixes)].address.ToInteger() ^ (kRandom >> 20) });
+    }
+    auto next_hops = vector<uint32_t>(size(addresses));
+    kTable->Lookup(addresses, next_hops);
+    for (auto idx = size_t{ 0 }; idx < size(addresses) ;++idx)
     {
-        const auto &lhs = *this;
-        return lhs.ToInteger() < rhs.ToInteger();
+        const auto kExpected = LinearLongestPrefixMatch(kPrefixes, addresses[idx]);
+        assert(kExpected == kTable->Lookup(addresses[idx]));
+        assert(kExpected.value_or(IPV4RoutingTable::kNoRoute) == next_hops[idx]);
     }
-    
-    /**
-     * @brief Increments an IPV4 address
-     * The method increments the current IPV4 address by 1 and updates the individual octets
-     * accordingly. It uses bitwise operations and predefined bit masks to manipulate the octets.
-     * The operation is performed by adding 1 to the integer representation of the IPV4 address
-     * and extracting the updated octet values using bit masks.
-     * 
-     * Example:
-     * If the current IPV4 address is 192.168.1.255, calling Advance() will update it to 192.168.2.0.
-     * 
-     * @return IPV4& - increment the current object and returns its reference
-     */
-    IPV4& Advance()
+    assert(!IPV4Prefix::FromString("10.0.0.0/33 1") && !IPV4Prefix::FromString("10.0.0.0/8") && !IPV4Prefix::FromString("10.0.0/8 1"));
+}
+
+int main(int argc, char *argv[])
+{
+    auto address1 = IPV4{ };
+    cout << "Enter address1: "; cin >> address1;
+
+    auto address2 = IPV4{ };
+    cout << "Enter address2: "; cin >> address2;
+
+    for (const auto &address : IPV4Range{ address1, address2 })
     {
-        constexpr auto a = 0b1111'1111'0000'0000'0000'0000'0000'0000;
-        constexpr auto b = 0b0000'0000'1111'1111'0000'0000'0000'0000;
-        constexpr auto c = 0b0000'0000'0000'0000'1111'1111'0000'0000;
-        constexpr auto d = 0b0000'0000'0000'0000'0000'0000'1111'1111;
-
-        const auto kValue = ToInteger() + 1;
-        octet1 = (static_cast<uint32_t>(kValue) & a) >> 24;
-        octet2 = (static_cast<uint32_t>(kValue) & b) >> 16;
-        octet3 = (static_cast<uint32_t>(kValue) & c) >> 8;
-        octet4 = (static_cast<uint32_t>(kValue) & d);
-        
-        return *this;
+        cout << address << '\n';
     }
 
-    friend istream &operator>>(istream &in, IPV4 &address)
+    const auto kRange = IPV4Range::FromCIDR(kBenchmarkCIDR);
+    assert(kRange && 1u << 24 == kRange->size());
+    assert(IPV4(10, 0, 0, 0) == *kRange->begin() && IPV4(10, 255, 255, 255) == *(kRange->end() - 1));
+    assert(IPV4(10, 1, 0, 0) == kRange->begin()[1 << 16] && kRange->Contains(IPV4(10, 20, 30, 40)));
+    assert(!IPV4Range::FromCIDR("10.0.0.0/33") && !IPV4Range::FromCIDR("10.0.0/8"));
+    assert(uint64_t{ 1 } << 32 == IPV4Range::FromCIDR("1.2.3.4/0")->size());
+    assert(IPV4Range(IPV4(1, 2, 3, 4), IPV4(1, 2, 3, 3)).empty());
+
+    // Text of all addresses is about 230 MB, so it is formatted in blocks
+    auto buffer           = vector<char>(1 << 20);
+    auto bytes            = uint64_t{ 0 };
+    auto *current         = buffer.data();
+    const auto *kLimit    = buffer.data() + size(buffer) - (IPV4::kMaxLength + 1);
+    const auto kStartTimepoint = steady_clock::now();
+    for (const auto &address : *kRange)
     {
-        auto dot1 = '\0', dot2 = '\0', dot3 = '\0';
-        auto octet1 = 0, octet2 = 0, octet3 = 0, octet4 = 0;
-        in >> octet1 >> dot1 >> octet2 >> dot2 >> octet3 >> dot3 >> octet4;
-        if ('.' == dot1 && '.' == dot2 && '.' == dot3) {
-            address.octet1 = octet1;
-            address.octet2 = octet2;
-            address.octet3 = octet3;
-            address.octet4 = octet4;
+        current    = ToChars(current, buffer.data() + size(buffer), address).ptr;
+        *current++ = '\n';
+        if (current > kLimit)
+        {
+            bytes  += current - buffer.data();
+            current = buffer.data();
         }
-        return in;
     }
+    bytes += current - buffer.data();
+    cout << "Enumerated " << kRange->size() << " addresses of " << kBenchmarkCIDR << "(" << bytes / (1 << 20)
+         << " MB of text) in " << duration<double>(steady_clock::now() - kStartTimepoint).count() << " s" << endl;
+
+    auto random_engine = mt19937{ 16 };
+    VerifyRoutingTable(random_engine);
 
-    friend ostream &operator<<(ostream &out, const IPV4 &address)
+    auto start_timepoint = steady_clock::now();
+    const auto kTable    = (argc > 1) ? IPV4RoutingTable::FromFile(argv[1])
+                                      : IPV4RoutingTable{ RandomPrefixes(kRandomPrefixCount, random_engine) };
+    if (!kTable)
     {
-        out << address.ToString();
-        return out;
+        cout << "Unable to read prefix file " << argv[1] << endl;
+        return 1;
     }
-};
+    cout << "Built routing table of " << kTable->PrefixCount() << " prefixes(" << kTable->MemoryUsage() / (1 << 20) << " MB) in "
+         << duration<double>(steady_clock::now() - start_timepoint).count() << " s" << endl;
 
-int main()
-{
-    auto address1 = IPV4{ };
-    cout << "Enter address1: "; cin >> address1;
+    auto addresses    = vector<IPV4>{};
+    auto distribution = uniform_int_distribution<uint32_t>{};
+    for (auto idx = size_t{ 0 }; idx < kLookupCount ;++idx) { addresses.push_back(IPV4{ distribution(random_engine) }); }
 
-    auto address2 = IPV4{ };
-    cout << "Enter address2: "; cin >> address2;
+    auto next_hops  = vector<uint32_t>(kLookupCount);
+    start_timepoint = steady_clock::now();
+    for (auto idx = size_t{ 0 }; idx < kLookupCount ;++idx) { next_hops[idx] = kTable->Lookup(addresses[idx]).value_or(IPV4RoutingTable::kNoRoute); }
+    cout << "Looked up " << kLookupCount << " addresses one at a time in " << duration<double>(steady_clock::now() - start_timepoint).count() << " s" << endl;
+
+    auto batch_next_hops = vector<uint32_t>(kLookupCount);
+    start_timepoint      = steady_clock::now();
+    kTable->Lookup(addresses, batch_next_hops);
+    cout << "Looked up " << kLookupCount << " addresses in a batch in " << duration<double>(steady_clock::now() - start_timepoint).count() << " s" << endl;
+    assert(next_hops == batch_next_hops);
 
-    while (address1 < address2)
+    // Every batch must be answered entirely by one of the tables, each of which routes everything to its own next hop.
+    // Readers run concurrently with a writer which keeps swapping tables until all readers are done.
+    const auto kDefaultRoute = [](const uint32_t &next_hop) { return make_shared<const IPV4RoutingTable>(vector<IPV4Prefix>{ { IPV4{}, 0, next_hop } }); };
+    auto concurrent_table    = ConcurrentIPV4RoutingTable{ kDefaultRoute(1) };
+    auto readers_running     = std::atomic<size_t>{ kSwapReaderCount };
+    auto tables_seen         = std::atomic<size_t>{ 0 };
+    auto readers             = vector<thread>{};
+    for (auto reader_idx = size_t{ 0 }; reader_idx < kSwapReaderCount ;++reader_idx)
     {
-        cout << address1 << endl;
-        address1.Advance();
+        readers.emplace_back([&, reader_idx]()
+        {
+            auto reader       = ConcurrentIPV4RoutingTable::Reader{ concurrent_table };
+            auto batch_result = vector<uint32_t>(4096);
+            auto last_hop     = uint32_t{ 0 };
+            for (auto batch = size_t{ 0 }; batch < 2'000 ;++batch)
+            {
+                const auto &kCurrent = reader.Load();
+                const auto kOffset   = ((batch + reader_idx * 500) % 2'000) * size(batch_result);
+                kCurrent.Lookup(std::span{ addresses }.subspan(kOffset, size(batch_result)), batch_result);
+                assert(std::all_of(begin(batch_result), end(batch_result), [&](const auto &next_hop) { return next_hop == batch_result.front(); }));
+                if (batch_result.front() != last_hop) { ++tables_seen; last_hop = batch_result.front(); }
+            }
+            --readers_running;
+        });
     }
+    auto swap_count = size_t{ 0 };
+    for (; readers_running > 0 ;++swap_count) { concurrent_table.Store(kDefaultRoute(2 + swap_count % 2)); }
+    for (auto &reader : readers) { reader.join(); }
+    const auto kLastStored = (0 == swap_count) ? uint32_t{ 1 } : static_cast<uint32_t>(2 + (swap_count - 1) % 2);
+    assert(concurrent_table.Load()->Lookup(IPV4{}) == kLastStored);
+    cout << kSwapReaderCount << " readers saw " << tables_seen << " tables during " << swap_count << " swaps" << endl;
+    cout << "Lookups during table swaps were consistent" << endl;
+    return 0;
 }
\ No newline at end of file
@@ -2,7 +2,7 @@
  * @file 17_2d_array.cpp
  * @author Usama Tayyab (usamatayyab9@gmail.com)
  * @brief 
- *      Compilation command: g++ -std=c++17 17_2d_array.cpp
+ *      Compilation command: g++ -std=c++20 -O2 -mavx2 17_2d_array.cpp -lpthread
  * This file is solution to "Problem 16. Creating a 2D array with basic operations"
  * mentioned in "Chapter 2: Language Features" of the book:
  * - The Modern C++ Challenge by Marius Bancilla (available at amazon https://www.amazon.com/Modern-Challenge-programmer-real-world-problems/dp/1788993861)
@@ -27,6 +27,15 @@
  *      that compile-time array initialization can also be done.
  * - Some values on constexpr array are fetched using row, column indices denoting that constexpr
  *      values can also be access at compile time.
+ *
+ * For runtime sized numeric data matrix.h provides `Matrix<T>` with the same interface as Array2D,
+ * strided views of submatrices, blocked transpose, SIMD element wise map and a tiled multi-threaded
+ * matrix multiplication, see matrix.h for details.
+ * - The steps above on Array2D are repeated on a Matrix through a function template written
+ *      against the common interface, and the outputs are compared.
+ * - Transpose(), Map() and Multiply() are verified against straightforward loops, on submatrices as well.
+ * - Transpose and Map of a `kBenchmarkSize` x `kBenchmarkSize` matrix and multiplication of two
+ *      `kGemmBenchmarkSize` x `kGemmBenchmarkSize` matrices are timed against straightforward loops.
  *      
  * @copyright Copyright (c) 2023
  * 
@@ -36,6 +45,15 @@
 #include <initializer_list>
 #include <algorithm>
 #include <iterator>
+#include <sstream>
+#include <string>
+#include <chrono>
+#include <random>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+
+#include "matrix.h"
 
 using std::array;
 using std::cout;
@@ -47,6 +65,16 @@ using std::endl;
 using std::cend;
 using std::initializer_list;
 using std::ostream_iterator;
+using std::ostream;
+using std::string;
+using std::stringstream;
+using std::mt19937;
+using std::uniform_real_distribution;
+using std::chrono::steady_clock;
+using std::chrono::duration;
+
+inline constexpr auto kBenchmarkSize     = size_t{ 4096 };
+inline constexpr auto kGemmBenchmarkSize = size_t{ 1024 };
 
 template <class T, size_t Rows, size_t Columns>
 class Array2D
@@ -120,6 +148,136 @@ private:
     array<T, Rows * Columns> arr;
 };
 
+/**
+ * @brief Runs the steps of the driver code on @param arr, which may be an Array2D or a Matrix, and prints to @param out.
+ */
+template <class Array>
+void ExerciseArray(Array &arr, ostream &out)
+{
+    for (auto r = size_t{ 0 }; r < arr.RowCount(); ++r) {
+        for (auto c = size_t{ 0 }; c < arr.ColumnCount(); ++c) {
+            arr(r, c) *= 2;
+            out << arr.At(r, c) << " ";
+        }
+    }
+    copy(arr.cbegin(), arr.cend(), ostream_iterator<typename Array::value_type>{ out, "," });
+    out << *arr.Data();
+    arr.Fill(7);
+    copy(arr.begin(), arr.end(), ostream_iterator<typename Array::value_type>{ out, "," });
+}
+
+template <class T>
+Matrix<T> RandomMatrix(const size_t &rows, const size_t &columns, mt19937 &random_engine)
+{
+    auto matrix       = Matrix<T>(rows, columns);
+    auto distribution = uniform_real_distribution<T>{ -1, 1 };
+    for (auto &value : matrix) { value = distribution(random_engine); }
+    return matrix;
+}
+
+void VerifyMatrix(mt19937 &random_engine)
+{
+    auto array2d = Array2D<int, 2, 3>{ 1, 2, 3, 4, 5, 6 };
+    auto matrix  = Matrix<int>(2, 3, { 1, 2, 3, 4, 5, 6 });
+    auto array2d_output = stringstream{}, matrix_output = stringstream{};
+    ExerciseArray(array2d, array2d_output);
+    ExerciseArray(matrix, matrix_output);
+    assert(array2d_output.str() == matrix_output.str());
+    assert(reinterpret_cast<uintptr_t>(matrix.Data()) % kMatrixAlignment == 0);
+
+    auto threw = false;
+    try { matrix.At(2, 0); } catch (const std::out_of_range &) { threw = true; }
+    assert(threw);
+
+    auto other = Matrix<int>(1, 1, 9);
+    matrix.Swap(other);
+    assert(1 == matrix.RowCount() && 3 == other.ColumnCount() && 9 == matrix(0, 0));
+
+    // Odd sizes so that the blocked, packed and remainder paths are all taken, on submatrices
+    const auto kA = RandomMatrix<double>(150, 301, random_engine);
+    const auto kB = RandomMatrix<double>(301, 77, random_engine);
+    const auto kSubA = kA.SubMatrix(3, 5, 131, 259);
+    const auto kSubB = kB.SubMatrix(7, 2, 259, 70);
+    auto product = Matrix<double>(131, 70);
+    Multiply(kSubA, kSubB, product.View(), 3);
+    for (auto r = size_t{ 0 }; r < product.RowCount() ;++r)
+    {
+        for (auto c = size_t{ 0 }; c < product.ColumnCount() ;++c)
+        {
+            auto expected = 0.0;
+            for (auto k = size_t{ 0 }; k < kSubA.ColumnCount() ;++k) { expected += kSubA(r, k) * kSubB(k, c); }
+            assert(std::abs(expected - product(r, c)) < 1e-9);
+        }
+    }
+
+    auto transposed = Matrix<double>(259, 131);
+    Transpose(kSubA, transposed.View());
+    auto mapped = Matrix<double>(131, 259);
+    Map(kSubA, mapped.View(), [](auto x) { return x * 3.0 - 1.0; });
+    for (auto r = size_t{ 0 }; r < kSubA.RowCount() ;++r)
+    {
+        for (auto c = size_t{ 0 }; c < kSubA.ColumnCount() ;++c)
+        {
+            assert(transposed(c, r) == kSubA(r, c));
+            assert(mapped(r, c) == kSubA(r, c) * 3.0 - 1.0);
+        }
+    }
+    const auto kTwiceTransposed = Transposed(Transposed(kA));
+    assert(std::equal(kA.cbegin(), kA.cend(), kTwiceTransposed.cbegin()));
+}
+
+void BenchmarkMatrix(mt19937 &random_engine)
+{
+    const auto kMatrix  = RandomMatrix<float>(kBenchmarkSize, kBenchmarkSize, random_engine);
+    auto result         = Matrix<float>(kBenchmarkSize, kBenchmarkSize);
+
+    auto start_timepoint = steady_clock::now();
+    for (auto r = size_t{ 0 }; r < kBenchmarkSize ;++r)
+    {
+        for (auto c = size_t{ 0 }; c < kBenchmarkSize ;++c) { result(c, r) = kMatrix(r, c); }
+    }
+    cout << "Naive transpose of " << kBenchmarkSize << "x" << kBenchmarkSize << ": "
+         << duration<double>(steady_clock::now() - start_timepoint).count() << " s" << endl;
+
+    start_timepoint = steady_clock::now();
+    Transpose(kMatrix.View(), result.View());
+    cout << "Blocked transpose of " << kBenchmarkSize << "x" << kBenchmarkSize << ": "
+         << duration<double>(steady_clock::now() - start_timepoint).count() << " s" << endl;
+
+    start_timepoint = steady_clock::now();
+    Map(kMatrix.View(), result.View(), [](auto x) { return x * x + 0.5f; });
+    cout << "Map of " << kBenchmarkSize << "x" << kBenchmarkSize << ": "
+         << duration<double>(steady_clock::now() - start_timepoint).count() << " s" << endl;
+
+    const auto kA = RandomMatrix<float>(kGemmBenchmarkSize, kGemmBenchmarkSize, random_engine);
+    const auto kB = RandomMatrix<float>(kGemmBenchmarkSize, kGemmBenchmarkSize, random_engine);
+    auto naive    = Matrix<float>(kGemmBenchmarkSize, kGemmBenchmarkSize);
+    start_timepoint = steady_clock::now();
+    for (auto r = size_t{ 0 }; r < kGemmBenchmarkSize ;++r)
+    {
+        for (auto c = size_t{ 0 }; c < kGemmBenchmarkSize ;++c)
+        {
+            auto sum = 0.0f;
+            for (auto k = size_t{ 0 }; k < kGemmBenchmarkSize ;++k) { sum += kA(r, k) * kB(k, c); }
+            naive(r, c) = sum;
+        }
+    }
+    const auto kNaiveSeconds = duration<double>(steady_clock::now() - start_timepoint).count();
+
+    start_timepoint      = steady_clock::now();
+    const auto kProduct  = kA * kB;
+    const auto kSeconds  = duration<double>(steady_clock::now() - start_timepoint).count();
+    const auto kGflop    = 2.0 * kGemmBenchmarkSize * kGemmBenchmarkSize * kGemmBenchmarkSize / 1e9;
+    cout << "Naive multiplication of " << kGemmBenchmarkSize << "x" << kGemmBenchmarkSize << ": " << kNaiveSeconds << " s("
+         << kGflop / kNaiveSeconds << " GFLOPS)" << endl;
+    cout << "Tiled multiplication of " << kGemmBenchmarkSize << "x" << kGemmBenchmarkSize << ": " << kSeconds << " s("
+         << kGflop / kSeconds << " GFLOPS)" << endl;
+    for (auto idx = size_t{ 0 }; idx < kGemmBenchmarkSize * kGemmBenchmarkSize ;++idx)
+    {
+        assert(std::abs(naive.Data()[idx] - kProduct.Data()[idx]) < 1e-2f);
+    }
+}
+
 int main()
 {
     auto arr = Array2D<int, 2, 3>{ 1, 2, 3, 4, 5, 6 };
@@ -146,6 +304,10 @@ int main()
 
     constexpr auto kSum = kVal1 + kVal2;
     cout << "Sum: " << kSum << endl;
+
+    auto random_engine = mt19937{ 17 };
+    VerifyMatrix(random_engine);
+    BenchmarkMatrix(random_engine);
     
     return 0;
 }
\ No newline at end of file
@@ -2,7 +2,7 @@
  * @file 20_any_all_none.cpp
  * @author Usama Tayyab (usamatayyab9@gmail.com)
  * @brief 
- *  Compilation command: g++ -std=c++17 20_any_all_none.cpp
+ *  Compilation command: g++ -std=c++20 -O2 20_any_all_none.cpp
  * 
  * This file is solution to "Problem 20. Container any, all, none"
  * mentioned in "Chapter 2: Language Features" of the book:
@@ -31,9 +31,30 @@
  * 4. A containsNone() function which takes a container and arbitrary number of values as an argument and tests whether 
  *      NONE of the values exists in container or not using contains() and fold expressions.
  * 
+ * Since contains() is a linear search, above functions take O(n * k) time for a container of n elements and k
+ * values. So when ChooseIndexForCall() decides that the container is large enough for the number of values,
+ * a `MembershipIndex` of the container is built once per call and the values are probed in it instead. Since
+ * building an index costs more per element than a comparison, this pays off only for many values, atleast
+ * `kMinQueriesForBitset` for a bitset and `kMinQueriesForSortedVector` otherwise(measured on 1M ints, building
+ * a bitset costs about 10 linear searches and sorting about 250).
+ * A MembershipIndex can also be built once by the caller and reused for repeated queries. It stores the
+ * elements in one of the following, chosen by ChooseMembershipStrategy() from the container size, the number
+ * of queries expected and, for integral types, the range of the elements:
+ *  - kBitset: one bit per value in [min, max], used when the range is atmost `kBitsetBitsPerElement` times
+ *      the number of elements. A probe is a single bit test.
+ *  - kHashSet: an unordered_set, probe is O(1) expected time. Building it costs several times more than
+ *      sorting, so it is used only when atleast `kHashSetQueriesPerElement` queries per element are expected.
+ *  - kSortedVector: sorted and deduplicated elements, used otherwise or when T is not hashable. Values of a
+ *      batch query are sorted and searched in increasing order using galloping search, so each search starts
+ *      where the previous one ended.
+ * 
  * Driver code:
  *  Initializes a vector with some values.
  *  Then calls all of the ContainsAny(), ContainsAll() and ContainsNone() on vector with some values.
+ *  Then the queries of the problem statement are checked, and every strategy of MembershipIndex is checked
+ *  against the linear search on random containers, and with arguments of other types than the elements. Finally time taken by `kQueryCount` calls to ContainsNone()
+ *  with 8 and with 32 values on a container of `kLargeContainerSize` elements is printed, for the linear search, for
+ *  the index built per call and for a reused MembershipIndex.
  * @copyright Copyright (c) 2023
  * 
  */
@@ -45,6 +66,20 @@
 #include <array>
 #include <string>
 #include <list>
+#include <unordered_set>
+#include <optional>
+#include <functional>
+#include <type_traits>
+#include <random>
+#include <chrono>
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <numeric>
+#include <limits>
+#include <cmath>
+#include <ranges>
+#include <forward_list>
 using std::cbegin;
 using std::cend;
 using std::cout;
@@ -54,6 +89,26 @@ using std::vector;
 using std::array;
 using std::string;
 using std::list;
+using std::optional;
+using std::numeric_limits;
+using std::unordered_set;
+using std::mt19937;
+using std::uniform_int_distribution;
+using std::chrono::steady_clock;
+using std::chrono::duration;
+
+inline constexpr auto kMinContainerSizeForIndex = size_t{ 256 };
+inline constexpr auto kMinQueriesForBitset      = size_t{ 16 };
+inline constexpr auto kMinQueriesForSortedVector = size_t{ 512 };
+inline constexpr auto kBitsetBitsPerElement     = uint64_t{ 64 };
+inline constexpr auto kHashSetQueriesPerElement = size_t{ 4 };
+inline constexpr auto kLargeContainerSize       = size_t{ 1'000'000 };
+inline constexpr auto kQueryCount               = size_t{ 100 };
+
+enum class MembershipStrategy { kBitset, kHashSet, kSortedVector };
+
+template <class Container>
+using ContainerValueType = std::decay_t<decltype(*cbegin(std::declval<const Container &>()))>;
 
 /**
  * @brief Check for the existance of value in a container
@@ -71,16 +126,278 @@ bool Contains(const Container &c, const T &value)
     return find(cbegin(c), cend(c), value) != cend(c);
 }
 
+/**
+ * @brief Chooses the strategy of a MembershipIndex, see file comments.
+ * @param value_range - for integral types, max - min of the elements
+ */
+template <class T>
+MembershipStrategy ChooseMembershipStrategy(const size_t &container_size, const size_t &query_count,
+                                            const optional<uint64_t> &value_range = {})
+{
+    if (value_range && *value_range / kBitsetBitsPerElement <= container_size) { return MembershipStrategy::kBitset; }
+    if constexpr (std::is_default_constructible_v<std::hash<T>>)
+    {
+        if (query_count / kHashSetQueriesPerElement >= container_size) { return MembershipStrategy::kHashSet; }
+    }
+    return MembershipStrategy::kSortedVector;
+}
+
+/**
+ * @brief Returns minimum and maximum of non-empty container @param c. Unlike std::minmax_element this has no
+ *      branches depending on the values, so it is not slowed down by unordered values and can be vectorized.
+ */
+template <class Container>
+std::pair<ContainerValueType<Container>, ContainerValueType<Container>> MinMax(const Container &c)
+{
+    auto min = *cbegin(c), max = *cbegin(c);
+    for (const auto &value : c)
+    {
+        min = std::min(min, value);
+        max = std::max(max, value);
+    }
+    return { min, max };
+}
+
+/**
+ * @brief Returns iterator to the first element not less than @param value in sorted [@param first, @param last),
+ *      by probing first + 1, first + 2, first + 4 ... and then binary searching the last interval. So the time
+ *      taken is logarithmic in the distance of the result from @param first.
+ */
+template <class Iterator, class T>
+Iterator GallopingLowerBound(Iterator first, Iterator last, const T &value)
+{
+    const auto kSize = static_cast<size_t>(last - first);
+    auto bound       = size_t{ 1 };
+    while (bound < kSize && first[bound] < value) { bound *= 2; }
+    return std::lower_bound(first + bound / 2, first + std::min(bound + 1, kSize), value);
+}
+
+/**
+ * @brief Index of the elements of a container for answering membership queries, see file comments.
+ */
+template <class T>
+class MembershipIndex
+{
+public:
+    /**
+     * @brief Builds index of the elements of @param c, using @param strategy if given, or else the one chosen by
+     *      ChooseMembershipStrategy() for @param expected_query_count queries. kBitset is used only if
+     *      ChooseMembershipStrategy() would allow it, and kHashSet only for hashable types.
+     */
+    template <class Container>
+    explicit MembershipIndex(const Container &c, const size_t &expected_query_count = kMinQueriesForSortedVector,
+                             const optional<MembershipStrategy> &strategy = {})
+    {
+        const auto kSize = static_cast<size_t>(std::distance(cbegin(c), cend(c)));
+        auto value_range = optional<uint64_t>{};
+        if constexpr (std::is_integral_v<T>)
+        {
+            if (kSize > 0)
+            {
+                const auto [kMin, kMax] = MinMax(c);
+                min_        = kMin;
+                value_range = static_cast<uint64_t>(kMax) - static_cast<uint64_t>(kMin);
+            }
+        }
+        strategy_ = strategy.value_or(ChooseMembershipStrategy<T>(kSize, expected_query_count, value_range));
+        if (MembershipStrategy::kBitset == strategy_ && MembershipStrategy::kBitset != ChooseMembershipStrategy<T>(kSize, expected_query_count, value_range))
+        {
+            // Too wide a range for a bitset, or not an integral type
+            strategy_ = ChooseMembershipStrategy<T>(kSize, expected_query_count);
+        }
+
+        if (MembershipStrategy::kBitset == strategy_)
+        {
+            if constexpr (std::is_integral_v<T>)
+            {
+                bits_.assign(value_range.value_or(0) / 64 + 1, 0);
+                for (const auto &value : c)
+                {
+                    const auto kOffset = static_cast<uint64_t>(value) - static_cast<uint64_t>(min_);
+                    bits_[kOffset / 64] |= uint64_t{ 1 } << (kOffset % 64);
+                }
+            }
+        }
+        if (MembershipStrategy::kHashSet == strategy_)
+        {
+            if constexpr (std::is_default_constructible_v<std::hash<T>>) { hash_set_ = unordered_set<T>(cbegin(c), cend(c)); }
+            else { strategy_ = MembershipStrategy::kSortedVector; }
+        }
+        if (MembershipStrategy::kSortedVector == strategy_)
+        {
+            sorted_.assign(cbegin(c), cend(c));
+            std::sort(begin(sorted_), end(sorted_));
+            sorted_.erase(std::unique(begin(sorted_), end(sorted_)), end(sorted_));
+        }
+    }
+
+    MembershipStrategy Strategy() const { return strategy_; }
+
+    /**
+     * @brief Tests whether @param value is present. A value of another type is compared as the linear search
+     *      would i.e. by its own value, so a value which changes when converted to T(such as 2.5 or 2^32 + 5
+     *      for int) is not present.
+     */
+    template <class U>
+    bool Contains(const U &value) const
+    {
+        const auto kValue = ConvertExactly(value);
+        return kValue && ContainsValue(*kValue);
+    }
+
+    template <typename... Arguments>
+    bool ContainsAny(const Arguments& ...arguments) const
+    {
+        if (MembershipStrategy::kSortedVector != strategy_) { return (Contains(arguments) || ...); }
+        auto values      = array<T, sizeof...(Arguments)>{};
+        const auto kCount = ConvertAll(values, arguments...);
+        return CountContained(values, kCount) > 0;
+    }
+
+    template <typename... Arguments>
+    bool ContainsAll(const Arguments& ...arguments) const
+    {
+        if (MembershipStrategy::kSortedVector != strategy_) { return (Contains(arguments) && ...); }
+        auto values       = array<T, sizeof...(Arguments)>{};
+        const auto kCount = ConvertAll(values, arguments...);
+        return kCount == sizeof...(arguments) && CountContained(values, kCount) == sizeof...(arguments);
+    }
+
+    template <typename... Arguments>
+    bool ContainsNone(const Arguments& ...arguments) const
+    {
+        return !ContainsAny(arguments...);
+    }
+
+private:
+    /**
+     * @brief Returns @param value as T, or an empty optional if no T compares equal to it.
+     */
+    template <class U>
+    static optional<T> ConvertExactly(const U &value)
+    {
+        if constexpr (std::is_same_v<U, T>) { return value; }
+        else
+        {
+            // Converting a floating value outside the range of T is undefined, such values can not equal any T.
+            // For integral T, 2^digits is the first value above its range and is exactly representable in U.
+            if constexpr (std::is_floating_point_v<U> && std::is_integral_v<T>)
+            {
+                constexpr auto kLowest   = static_cast<U>(numeric_limits<T>::min());
+                constexpr auto kAboveMax = static_cast<U>(numeric_limits<T>::max() / 2 + 1) * 2;
+                if (!(value >= kLowest && value < kAboveMax)) { return {}; }
+            }
+            else if constexpr (std::is_floating_point_v<U> && std::is_floating_point_v<T>)
+            {
+                if (std::isnan(value)) { return {}; }
+                if (std::isfinite(value) && (value < numeric_limits<T>::lowest() || value > numeric_limits<T>::max())) { return {}; }
+            }
+            auto converted = static_cast<T>(value);
+            if (!std::equal_to<>{}(converted, value)) { return {}; } // the same comparison as std::find()
+            return converted;
+        }
+    }
+
+    /**
+     * @brief Stores the @param arguments which convert exactly to T at the front of @param values, returns their count.
+     */
+    template <size_t N, typename... Arguments>
+    static size_t ConvertAll(array<T, N> &values, const Arguments& ...arguments)
+    {
+        auto count = size_t{ 0 };
+        auto Store = [&values, &count](const auto &argument) {
+            if (const auto kValue = ConvertExactly(argument)) { values[count++] = *kValue; }
+        };
+        (Store(arguments), ...);
+        return count;
+    }
+
+    bool ContainsValue(const T &value) const
+    {
+        switch (strategy_)
+        {
+        case MembershipStrategy::kBitset:
+            if constexpr (std::is_integral_v<T>)
+            {
+                const auto kOffset = static_cast<uint64_t>(value) - static_cast<uint64_t>(min_);
+                return kOffset / 64 < size(bits_) && (bits_[kOffset / 64] >> (kOffset % 64)) & 1;
+            }
+            return false;
+        case MembershipStrategy::kHashSet:
+            return hash_set_.count(value) > 0;
+        case MembershipStrategy::kSortedVector:
+            return std::binary_search(cbegin(sorted_), cend(sorted_), value);
+        }
+        return false;
+    }
+
+    /**
+     * @brief Returns how many of the first @param count of @param values are present, using galloping search on sorted values.
+     */
+    template <size_t N>
+    size_t CountContained(array<T, N> &values, const size_t &count) const
+    {
+        // Insertion sort, there are only as many values as arguments of a call
+        for (auto idx = size_t{ 1 }; idx < count ;++idx)
+        {
+            for (auto pos = idx; pos > 0 && values[pos] < values[pos - 1] ;--pos) { std::swap(values[pos], values[pos - 1]); }
+        }
+        auto found    = size_t{ 0 };
+        auto position = cbegin(sorted_);
+        for (auto idx = size_t{ 0 }; idx < count ;++idx)
+        {
+            position = GallopingLowerBound(position, cend(sorted_), values[idx]);
+            found   += (position != cend(sorted_) && !(values[idx] < *position)) ? 1 : 0;
+        }
+        return found;
+    }
+
+    MembershipStrategy      strategy_ = MembershipStrategy::kSortedVector;
+    vector<uint64_t>        bits_;
+    T                       min_{};
+    unordered_set<T>        hash_set_;
+    vector<T>               sorted_;
+};
+
+/**
+ * @brief Returns the strategy of the MembershipIndex to build for checking @param query_count values in @param c,
+ *      or an empty optional if linear searches are cheaper, see file comments. For integral types a bitset
+ *      is considered, for which a pass over the container is made to find the range of the elements.
+ */
+template <class Container>
+optional<MembershipStrategy> ChooseIndexForCall(const Container &c, const size_t &query_count)
+{
+    using T = ContainerValueType<Container>;
+    const auto kSize = static_cast<size_t>(std::ranges::distance(c));
+    if (kSize < kMinContainerSizeForIndex || query_count < kMinQueriesForBitset) { return {}; }
+    if constexpr (std::is_integral_v<T>)
+    {
+        const auto [kMin, kMax] = MinMax(c);
+        const auto kRange       = static_cast<uint64_t>(kMax) - static_cast<uint64_t>(kMin);
+        if (MembershipStrategy::kBitset == ChooseMembershipStrategy<T>(kSize, query_count, kRange)) { return MembershipStrategy::kBitset; }
+    }
+    if (query_count < kMinQueriesForSortedVector) { return {}; }
+    return ChooseMembershipStrategy<T>(kSize, query_count);
+}
+
 template <class Container, typename First, typename... Arguments>
 bool ContainsAny(const Container &c, const First &first, const Arguments& ...arguments)
 {
-    return Contains(c, first) || (ContainsAny(c, arguments) || ...);
+    if (const auto kStrategy = ChooseIndexForCall(c, 1 + sizeof...(arguments)))
+    {
+        return MembershipIndex<ContainerValueType<Container>>{ c, 1 + sizeof...(arguments), kStrategy }.ContainsAny(first, arguments...);
+    }
+    return Contains(c, first) || (Contains(c, arguments) || ...);
 }
 
 template <class Container, typename First, typename... Arguments>
 bool ContainsAll(const Container &c, const First &first, const Arguments& ...arguments)
 {
-    return Contains(c, first) && (ContainsAll(c, arguments) && ...);
+    if (const auto kStrategy = ChooseIndexForCall(c, 1 + sizeof...(arguments)))
+    {
+        return MembershipIndex<ContainerValueType<Container>>{ c, 1 + sizeof...(arguments), kStrategy }.ContainsAll(first, arguments...);
+    }
+    return Contains(c, first) && (Contains(c, arguments) && ...);
 }
 
 template <class Container, typename First, typename... Arguments>
@@ -106,6 +423,103 @@ int main()
 
     cout << "Contains none of 7, 8, 9       : " << std::boolalpha << ContainsNone(ivec, 7, 8, 9) << endl; // should return false
     cout << "Contains none of 700, 800, 900 : " << std::boolalpha << ContainsNone(ivec, 700, 800, 900) << endl; // should return false
+
+    assert(ContainsAny(vector<int>{ 1, 2, 3, 4, 5, 6 }, 0, 3, 30));
+    assert(ContainsAll(array<int, 6>{ { 1, 2, 3, 4, 5, 6 } }, 1, 3, 5, 6));
+    assert(!ContainsNone(list<int>{ 1, 2, 3, 4, 5, 6 }, 0, 6));
+
+    // Every strategy against the linear search, with values which are in the container and values which are not
+    auto random_engine = mt19937{ 20 };
+    for (const auto &kRange : { int64_t{ 1'000 }, int64_t{ 1'000'000'000'000 } })
+    {
+        auto distribution = uniform_int_distribution<int64_t>{ -kRange, kRange };
+        auto container    = vector<int64_t>(2'000);
+        for (auto &value : container) { value = distribution(random_engine); }
+        auto strings      = list<string>{};
+        for (const auto &value : container) { strings.push_back(std::to_string(value)); }
+
+        for (const auto &kStrategy : { MembershipStrategy::kBitset, MembershipStrategy::kHashSet, MembershipStrategy::kSortedVector })
+        {
+            const auto kIndex       = MembershipIndex<int64_t>{ container, 1, kStrategy };
+            const auto kStringIndex = MembershipIndex<string>{ strings, 1, kStrategy };
+            for (auto i = 0; i < 1'000 ;++i)
+            {
+                const auto a = distribution(random_engine), b = container[i], c = distribution(random_engine), d = container[2 * i];
+                assert(kIndex.Contains(a) == Contains(container, a));
+                assert(kIndex.ContainsAny(a, c) == (Contains(container, a) || Contains(container, c)));
+                assert(kIndex.ContainsAll(b, d, b) && kIndex.ContainsAll(a, b) == Contains(container, a));
+                assert(kIndex.ContainsNone(a, c) == ContainsNone(container, a, c));
+                assert(kStringIndex.ContainsAll(std::to_string(b), std::to_string(d)));
+                assert(kStringIndex.Contains(std::to_string(a)) == Contains(container, a));
+            }
+        }
+        const auto kStrategy = MembershipIndex<int64_t>{ container }.Strategy();
+        assert((1'000 == kRange) == (MembershipStrategy::kBitset == kStrategy));
+    }
+
+    // Arguments of other types are compared by their own value on every path, whatever the number of arguments
+    auto thousand = vector<int>(1'000);
+    std::iota(begin(thousand), end(thousand), 0);
+    const auto kLinearAny = [&thousand](const auto& ...values) { return (Contains(thousand, values) || ...); };
+    const auto kLinearAll = [&thousand](const auto& ...values) { return (Contains(thousand, values) && ...); };
+    assert(!ContainsAny(thousand, 4294967301LL, -1, -2));
+    assert(!ContainsAny(thousand, 4294967301LL, -1, -2, -3, -4, -5, -6, -7, -8, -9, -10, -11, -12, -13, -14, 2.5));
+    assert(kLinearAny(4294967301LL, 2.5, 7.0) && ContainsAny(thousand, 4294967301LL, 2.5, 7.0));
+    assert(ContainsAny(thousand, 4294967301LL, -1, -2, -3, -4, -5, -6, -7, -8, -9, -10, -11, -12, -13, 2.5, 7.0));
+    assert(!ContainsAll(thousand, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 2.5));
+    assert(ContainsAll(thousand, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16.0, 17LL));
+    for (const auto &kStrategy : { MembershipStrategy::kBitset, MembershipStrategy::kHashSet, MembershipStrategy::kSortedVector })
+    {
+        const auto kIndex = MembershipIndex<int>{ thousand, 1, kStrategy };
+        assert(kIndex.Strategy() == kStrategy);
+        assert(kIndex.Contains(999LL) && !kIndex.Contains(4294967301LL) && !kIndex.Contains(2.5) && kIndex.Contains(2.0));
+        assert(kIndex.ContainsAny(4294967301LL, -1, 2.5) == kLinearAny(4294967301LL, -1, 2.5));
+        assert(kIndex.ContainsAny(4294967301LL, 2.5, 999u) == kLinearAny(4294967301LL, 2.5, 999u));
+        assert(kIndex.ContainsAll(1, 2.0, 3LL) == kLinearAll(1, 2.0, 3LL));
+        assert(kIndex.ContainsAll(1, 2.5, 3LL) == kLinearAll(1, 2.5, 3LL));
+        assert(kIndex.ContainsNone(-4294967296LL, 1e10) == !kLinearAny(-4294967296LL, 1e10));
+        assert(kIndex.Contains(999.0) && !kIndex.Contains(2147483648.0) && !kIndex.Contains(-2147483649.0) && !kIndex.Contains(1e300));
+        assert(!kIndex.Contains(numeric_limits<double>::quiet_NaN()) && !kIndex.Contains(numeric_limits<double>::infinity()));
+    }
+    const auto kFloatIndex = MembershipIndex<float>{ vector<float>{ 0.5f, 1.0f, 2.0f }, 1, MembershipStrategy::kSortedVector };
+    assert(kFloatIndex.Contains(0.5) && !kFloatIndex.Contains(1e300) && kFloatIndex.ContainsNone(-1e300, 0.1));
+
+    // Containers without size() are measured with std::ranges::distance()
+    const auto kForwardList = std::forward_list<int>(cbegin(thousand), cend(thousand));
+    assert(ContainsAny(std::forward_list<int>{ 1, 2, 3 }, 1, 2) && ContainsNone(std::forward_list<int>{ 1, 2, 3 }, 4, 5));
+    assert(ContainsAll(kForwardList, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16.0, 17LL, 999));
+    assert(!ContainsAny(kForwardList, -1, -2, -3, -4, -5, -6, -7, -8, -9, -10, -11, -12, -13, -14, -15, 2.5, 1e10));
+
+    // Values in a range small enough for a bitset, and queried values which are absent so that linear searches scan everything
+    auto large_container = vector<int>(kLargeContainerSize);
+    auto distribution    = uniform_int_distribution<int>{ 0, 4 * static_cast<int>(kLargeContainerSize) };
+    for (auto &value : large_container) { value = distribution(random_engine); }
+    const auto kV = [](const size_t &idx) { return -1 - static_cast<int>(idx); };
+    const auto kLinearContainsNone = [&](const auto& ...values) { return !(Contains(large_container, values) || ...); };
+
+    auto found = size_t{ 0 };
+    const auto kBenchmark = [&]<size_t... Idx>(std::index_sequence<Idx...>)
+    {
+        constexpr auto kValueCount = sizeof...(Idx);
+        auto start_timepoint = steady_clock::now();
+        for (auto q = size_t{ 0 }; q < kQueryCount ;++q) { found += kLinearContainsNone(kV(q + Idx)...) ? 0 : 1; }
+        cout << "Linear search ContainsNone() of " << kValueCount << " values x " << kQueryCount << ": "
+             << duration<double>(steady_clock::now() - start_timepoint).count() << " s" << endl;
+
+        start_timepoint = steady_clock::now();
+        for (auto q = size_t{ 0 }; q < kQueryCount ;++q) { found += ContainsNone(large_container, kV(q + Idx)...) ? 0 : 1; }
+        cout << "ContainsNone() of " << kValueCount << " values x " << kQueryCount << ": "
+             << duration<double>(steady_clock::now() - start_timepoint).count() << " s" << endl;
+
+        start_timepoint   = steady_clock::now();
+        const auto kIndex = MembershipIndex<int>{ large_container, kQueryCount * kValueCount };
+        for (auto q = size_t{ 0 }; q < kQueryCount ;++q) { found += kIndex.ContainsNone(kV(q + Idx)...) ? 0 : 1; }
+        cout << "Reused MembershipIndex ContainsNone() of " << kValueCount << " values x " << kQueryCount << ": "
+             << duration<double>(steady_clock::now() - start_timepoint).count() << " s" << endl;
+    };
+    kBenchmark(std::make_index_sequence<8>{});
+    kBenchmark(std::make_index_sequence<32>{});
+    assert(0 == found);
     
     return 0;
 }
\ No newline at end of file
@@ -2,7 +2,8 @@
  * @file 21_system_handle_wrapper.cpp
  * @author Usam Tayyab (usamatayyab9@gmail.com)
  * @brief 
- *  Compilation command : g++ -std=c++17 21_system_handle_wrapper.cpp
+ *  Compilation command : g++ -std=c++20 -O2 21_system_handle_wrapper.cpp
+ *  With io_uring      : g++ -std=c++20 -O2 -DUSE_IO_URING 21_system_handle_wrapper.cpp
  * This file is solution to "Problem 21. System handle wrapper"
  * mentioned in "Chapter 2: Language Features" of the book:
  * - The Modern C++ Challenge by Marius Bancilla (available at amazon https://www.amazon.com/Modern-Challenge-programmer-real-world-problems/dp/1788993861)
@@ -16,23 +17,316 @@
  * file handles. The class is responsible for creating, moving, deleting, reading and writing to 
  * file descriptor. Copying a ResourceHandler object or assigning is disallowed.
  * 
+ * Apart from Read() and Write(), which allocate per call and issue one system call per buffer, the
+ * class provides I/O without allocations:
+ *  - ReadAt() and WriteAt() use pread()/pwrite() with caller owned buffers.
+ *  - WriteGather() writes many buffers with a single writev() per `kMaxGatherBuffers` buffers.
+ *  - Map() returns a `MappedRegion`, a read only span over an mmap() of the file, with madvise() hints
+ *      about the access pattern, so that the file is read without copying it into a buffer.
+ *  - ReadBatch() reads many (buffer, offset) requests. When compiled with USE_IO_URING the requests are
+ *      submitted to an io_uring, `kIoUringEntries` at a time, so that the kernel processes them together
+ *      with one system call per batch. Otherwise, or if io_uring is not available, pread() is used.
+ *  - CopyTo() copies the whole file to another file inside the kernel using copy_file_range(), or
+ *      sendfile() if the file systems do not support it, so the data is never copied to user space.
+ *      If neither is supported it falls back to pread() and write() through one buffer of
+ *      `kCopyBufferSize` bytes reused for the whole copy.
+ * 
  * Driver code:
  * ResourceHandler object is instantiated and then some data is written using class Write function.
  * Another ResourceHanlder object is instantiated and then some is read using class Read function
  * Printed to console. 
+ * Then moving a ResourceHandler is checked, and all of the above functions are checked against each other
+ * on a file of `kCopyFileSize` bytes. Finally time taken for copying this file using Read() and Write() in
+ * chunks of `kCopyChunk` bytes, and using CopyTo(), is printed.
  * 
  * @copyright Copyright (c) 2023
  * 
  */
 #include <iostream>
 #include <string_view>
+#include <string>
+#include <span>
+#include <vector>
+#include <array>
+#include <optional>
+#include <memory>
+#include <utility>
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <chrono>
+#include <cassert>
+#include <cstring>
+#include <cerrno>
 
 #include <fcntl.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/sendfile.h>
+
+#if defined(USE_IO_URING)
+#include <atomic>
+#include <thread>
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
 
 using std::cout;
 using std::endl;
 using std::string_view;
+using std::string;
+using std::span;
+using std::vector;
+using std::array;
+using std::optional;
+using std::unique_ptr;
+using std::exchange;
+using std::chrono::steady_clock;
+using std::chrono::duration;
+
+inline constexpr auto kMaxGatherBuffers = size_t{ 64 };
+inline constexpr auto kCopyBufferSize   = size_t{ 128 } << 10;
+inline constexpr auto kIoUringEntries   = unsigned{ 64 };
+inline constexpr auto kCopyFileSize     = size_t{ 256 } << 20;
+inline constexpr auto kCopyChunk        = size_t{ 64 } << 10;
+
+/**
+ * @brief Hints passed to madvise() for a MappedRegion.
+ */
+enum class AccessAdvice
+{
+    kNormal     = MADV_NORMAL,
+    kSequential = MADV_SEQUENTIAL,
+    kRandom     = MADV_RANDOM,
+    kWillNeed   = MADV_WILLNEED
+};
+
+/**
+ * @brief A read request of ResourceHandler::ReadBatch(). After the call `result` is the number of
+ *      bytes read, or a negative value if the read failed.
+ */
+struct ReadRequest
+{
+    span<unsigned char> buffer;
+    off_t               offset = 0;
+    ssize_t             result = -1;
+};
+
+/**
+ * @brief Read only memory mapping of a part of a file, unmapped on destruction.
+ */
+class MappedRegion
+{
+public:
+    MappedRegion(const MappedRegion &) = delete;
+    MappedRegion& operator=(const MappedRegion &) = delete;
+
+    /**
+     * @param mapping - address returned by mmap() for @param mapping_length bytes
+     * @param data_offset - offset of the requested bytes in the mapping, since a mapping starts at a page boundary
+     */
+    MappedRegion(void *mapping, const size_t &mapping_length, const size_t &data_offset, const size_t &length) :
+        mapping{ mapping }, mapping_length{ mapping_length }, data{ static_cast<const unsigned char *>(mapping) + data_offset, length }
+    {
+    }
+    MappedRegion(MappedRegion &&rref) :
+        mapping{ exchange(rref.mapping, nullptr) }, mapping_length{ exchange(rref.mapping_length, 0) }, data{ exchange(rref.data, {}) }
+    {
+    }
+    MappedRegion& operator=(MappedRegion &&rref)
+    {
+        if (this != &rref)
+        {
+            Release();
+            mapping        = exchange(rref.mapping, nullptr);
+            mapping_length = exchange(rref.mapping_length, 0);
+            data           = exchange(rref.data, {});
+        }
+        return *this;
+    }
+    ~MappedRegion()
+    {
+        Release();
+    }
+
+    span<const unsigned char> Data() const { return data; }
+
+private:
+    void Release()
+    {
+        if (nullptr != mapping)
+        {
+            munmap(mapping, mapping_length);
+            mapping = nullptr;
+        }
+    }
+
+    void                      *mapping       = nullptr;
+    size_t                    mapping_length = 0;
+    span<const unsigned char> data;
+};
+
+#if defined(USE_IO_URING)
+/**
+ * @brief Minimal io_uring for submitting reads, using the system calls directly so that liburing is not needed.
+ *      Submission and completion rings are shared with the kernel, entries are added at the tail of the
+ *      submission ring and completions are consumed from the head of the completion ring.
+ */
+class IoUringQueue
+{
+public:
+    IoUringQueue(const IoUringQueue &) = delete;
+    IoUringQueue& operator=(const IoUringQueue &) = delete;
+
+    /**
+     * @brief Returns a queue of @param entries entries, or nullptr if io_uring is not available.
+     */
+    static unique_ptr<IoUringQueue> Create(const unsigned &entries)
+    {
+        auto params = io_uring_params{};
+        const auto kRingFd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (kRingFd < 0) { return nullptr; }
+
+        auto queue = unique_ptr<IoUringQueue>{ new IoUringQueue{} };
+        queue->ring_fd        = kRingFd;
+        queue->entries        = params.sq_entries;
+        queue->sq_ring_length = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        queue->cq_ring_length = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+        {
+            queue->sq_ring_length = queue->cq_ring_length = std::max(queue->sq_ring_length, queue->cq_ring_length);
+        }
+        queue->sq_ring = mmap(nullptr, queue->sq_ring_length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, kRingFd, IORING_OFF_SQ_RING);
+        if (MAP_FAILED == queue->sq_ring) { queue->sq_ring = nullptr; return nullptr; }
+        queue->cq_ring = (params.features & IORING_FEAT_SINGLE_MMAP) ? queue->sq_ring
+            : mmap(nullptr, queue->cq_ring_length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, kRingFd, IORING_OFF_CQ_RING);
+        if (MAP_FAILED == queue->cq_ring) { queue->cq_ring = nullptr; return nullptr; }
+        queue->sqes_length = params.sq_entries * sizeof(io_uring_sqe);
+        auto *sqes = mmap(nullptr, queue->sqes_length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, kRingFd, IORING_OFF_SQES);
+        if (MAP_FAILED == sqes) { return nullptr; }
+        queue->sqes = static_cast<io_uring_sqe *>(sqes);
+
+        auto *sq = static_cast<unsigned char *>(queue->sq_ring);
+        auto *cq = static_cast<unsigned char *>(queue->cq_ring);
+        queue->sq_head  = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+        queue->sq_tail  = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        queue->sq_mask  = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        queue->sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        queue->cq_head  = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        queue->cq_tail  = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        queue->cq_mask  = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        queue->cqes     = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+        return queue;
+    }
+
+    ~IoUringQueue()
+    {
+        if (nullptr != sqes) { munmap(sqes, sqes_length); }
+        if (nullptr != cq_ring && cq_ring != sq_ring) { munmap(cq_ring, cq_ring_length); }
+        if (nullptr != sq_ring) { munmap(sq_ring, sq_ring_length); }
+        if (ring_fd >= 0) { close(ring_fd); }
+    }
+
+    /**
+     * @brief Reads all @param requests from @param fd, keeping upto `entries` reads in flight.
+     * @return false if submitting to the ring failed, in which case results of some requests are not set.
+     *      Reads already submitted are waited for before returning, so that the kernel no longer writes
+     *      to the buffers of @param requests and no completion is left in the ring for the next call.
+     */
+    bool Read(const int &fd, span<ReadRequest> requests)
+    {
+        auto next      = size_t{ 0 };
+        auto in_flight = unsigned{ 0 };
+        while (next < size(requests) || in_flight > 0)
+        {
+            auto tail       = *sq_tail;
+            auto to_submit  = unsigned{ 0 };
+            for (; next < size(requests) && in_flight + to_submit < entries ;++next, ++to_submit, ++tail)
+            {
+                const auto kIdx = tail & sq_mask;
+                auto &sqe       = sqes[kIdx];
+                std::memset(&sqe, 0, sizeof(sqe));
+                sqe.opcode    = IORING_OP_READ;
+                sqe.fd        = fd;
+                sqe.addr      = reinterpret_cast<uint64_t>(requests[next].buffer.data());
+                sqe.len       = static_cast<uint32_t>(size(requests[next].buffer));
+                sqe.off       = static_cast<uint64_t>(requests[next].offset);
+                sqe.user_data = next;
+                sq_array[kIdx] = kIdx;
+            }
+            std::atomic_ref<unsigned>{ *sq_tail }.store(tail, std::memory_order_release);
+
+            const auto kFailed = syscall(__NR_io_uring_enter, ring_fd, to_submit, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && EINTR != errno;
+
+            // Entries not taken by the kernel are removed from the submission ring, and submitted again on success
+            const auto kHead     = std::atomic_ref<unsigned>{ *sq_head }.load(std::memory_order_acquire);
+            const auto kNotTaken = tail - kHead;
+            std::atomic_ref<unsigned>{ *sq_tail }.store(kHead, std::memory_order_release);
+            next      -= kNotTaken;
+            in_flight += to_submit - kNotTaken;
+            if (kFailed)
+            {
+                Drain(requests, in_flight);
+                return false;
+            }
+            Reap(requests, in_flight);
+        }
+        return true;
+    }
+
+private:
+    IoUringQueue() = default;
+
+    /**
+     * @brief Sets results of @param requests from the completions in the ring, decrementing @param in_flight.
+     */
+    void Reap(span<ReadRequest> requests, unsigned &in_flight)
+    {
+        auto head = *cq_head;
+        for (; head != std::atomic_ref<unsigned>{ *cq_tail }.load(std::memory_order_acquire) ;++head, --in_flight)
+        {
+            const auto &kCqe = cqes[head & cq_mask];
+            if (kCqe.user_data < size(requests)) { requests[kCqe.user_data].result = kCqe.res; }
+        }
+        std::atomic_ref<unsigned>{ *cq_head }.store(head, std::memory_order_release);
+    }
+
+    /**
+     * @brief Waits for all @param in_flight reads to complete. Completions are posted to the ring even if
+     *      waiting in io_uring_enter() fails, in which case the completion ring is polled.
+     */
+    void Drain(span<ReadRequest> requests, unsigned &in_flight)
+    {
+        while (in_flight > 0)
+        {
+            if (syscall(__NR_io_uring_enter, ring_fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && EINTR != errno)
+            {
+                std::this_thread::yield();
+            }
+            Reap(requests, in_flight);
+        }
+    }
+
+    int           ring_fd        = -1;
+    unsigned      entries        = 0;
+    void          *sq_ring       = nullptr;
+    void          *cq_ring       = nullptr;
+    size_t        sq_ring_length = 0;
+    size_t        cq_ring_length = 0;
+    io_uring_sqe  *sqes          = nullptr;
+    size_t        sqes_length    = 0;
+    unsigned      *sq_head       = nullptr;
+    unsigned      *sq_tail       = nullptr;
+    unsigned      sq_mask        = 0;
+    unsigned      *sq_array      = nullptr;
+    unsigned      *cq_head       = nullptr;
+    unsigned      *cq_tail       = nullptr;
+    unsigned      cq_mask        = 0;
+    io_uring_cqe  *cqes          = nullptr;
+};
+#endif
 
 /**
  * @brief A simple resource manager class for file descriptors using RAII principles.
@@ -70,16 +364,13 @@ class ResourceHandler
     }
 
     /**
-     * @brief Move constructor.
+     * @brief Move constructor, @param rref is left without a file descriptor.
      */
-    ResourceHandler(ResourceHandler &&rref)
+    ResourceHandler(ResourceHandler &&rref) : fd{ exchange(rref.fd, kInvalidFd) }
+#if defined(USE_IO_URING)
+        , ring{ std::move(rref.ring) }
+#endif
     {
-        if (this != &rref)
-        {
-            this->Release();
-            this->fd = rref.fd;
-            rref.Release();
-        }
     }
 
     /**
@@ -90,8 +381,10 @@ class ResourceHandler
         if (this != &rref)
         {
             this->Release();
-            this->fd = rref.fd;
-            rref.Release();
+            this->fd = exchange(rref.fd, kInvalidFd);
+#if defined(USE_IO_URING)
+            this->ring = std::move(rref.ring);
+#endif
         }
         return *this;
     }
@@ -114,11 +407,65 @@ class ResourceHandler
         }
     }
 
+    /**
+     * @brief Writes all @param buffers in order, using one writev() for upto kMaxGatherBuffers buffers.
+     *      Partial writes are continued, so either all bytes are written or an error is returned.
+     * 
+     * @return ssize_t - The number of bytes written, or -1 if an error occurred.
+     */
+    ssize_t WriteGather(span<const string_view> buffers)
+    {
+        if (kInvalidFd == fd) { return -1; }
+
+        auto total   = ssize_t{ 0 };
+        auto vectors = array<iovec, kMaxGatherBuffers>{};
+        while (!buffers.empty())
+        {
+            const auto kCount = std::min(size(buffers), kMaxGatherBuffers);
+            for (auto idx = size_t{ 0 }; idx < kCount ;++idx)
+            {
+                vectors[idx] = iovec{ const_cast<char *>(buffers[idx].data()), buffers[idx].size() };
+            }
+
+            auto *first      = vectors.data();
+            const auto *last = vectors.data() + kCount;
+            while (first != last)
+            {
+                const auto kWritten = writev(fd, first, static_cast<int>(last - first));
+                if (kWritten < 0) { return -1; }
+                total += kWritten;
+                for (auto remaining = static_cast<size_t>(kWritten); remaining > 0 ;)
+                {
+                    const auto kConsumed = std::min(remaining, first->iov_len);
+                    first->iov_base = static_cast<char *>(first->iov_base) + kConsumed;
+                    first->iov_len -= kConsumed;
+                    remaining      -= kConsumed;
+                    if (0 == first->iov_len) { ++first; }
+                }
+                while (first != last && 0 == first->iov_len) { ++first; }
+            }
+            buffers = buffers.subspan(kCount);
+        }
+        return total;
+    }
+
+    /**
+     * @brief Writes @param data at @param offset of the file using pwrite(), the file offset is not changed.
+     * 
+     * @return ssize_t - The number of bytes written, or -1 if an error occurred.
+     */
+    ssize_t WriteAt(span<const unsigned char> data, const off_t &offset)
+    {
+        if (kInvalidFd == fd) { return -1; }
+        return pwrite(fd, data.data(), data.size(), offset);
+    }
+
     /**
      * @brief Reads data from the file.
      * 
      * @param bytes_to_read - The number of bytes to read.
-     * @return std::basic_string<unsigned char> - The read data.
+     * @return std::basic_string<unsigned char> - The read data, which is shorter than @param bytes_to_read
+     *      if the end of file is reached.
      */
     std::basic_string<unsigned char> Read(const size_t &bytes_to_read)
     {
@@ -130,11 +477,137 @@ class ResourceHandler
         {
             auto bytes            = std::basic_string<unsigned char>(bytes_to_read, '\0');
             const auto kBytesRead = read(fd, bytes.data(), bytes_to_read);
-            if (-1 == kBytesRead) { bytes.clear(); }
+            bytes.resize(std::max<ssize_t>(kBytesRead, 0));
             return bytes;
         }
     }
 
+    /**
+     * @brief Reads into @param buffer from @param offset of the file using pread(), the file offset is not changed.
+     * 
+     * @return ssize_t - The number of bytes read, 0 at end of file, or -1 if an error occurred.
+     */
+    ssize_t ReadAt(span<unsigned char> buffer, const off_t &offset) const
+    {
+        if (kInvalidFd == fd) { return -1; }
+        return pread(fd, buffer.data(), buffer.size(), offset);
+    }
+
+    /**
+     * @brief Reads all @param requests, using io_uring if available, see file comments.
+     * 
+     * @return size_t - The number of requests which did not fail.
+     */
+    size_t ReadBatch(span<ReadRequest> requests)
+    {
+#if defined(USE_IO_URING)
+        if (nullptr == ring) { ring = IoUringQueue::Create(kIoUringEntries); }
+        if (nullptr != ring && IsValid())
+        {
+            if (ring->Read(fd, requests))
+            {
+                return std::count_if(begin(requests), end(requests), [](const auto &request) { return request.result >= 0; });
+            }
+            ring.reset(); // All of its reads have completed, requests are read again using pread()
+        }
+#endif
+        auto succeeded = size_t{ 0 };
+        for (auto &request : requests)
+        {
+            request.result = ReadAt(request.buffer, request.offset);
+            succeeded     += (request.result >= 0) ? 1 : 0;
+        }
+        return succeeded;
+    }
+
+    /**
+     * @brief Returns size of the file, or an empty optional if an error occurred.
+     */
+    optional<size_t> Size() const
+    {
+        struct stat status{};
+        if (kInvalidFd == fd || -1 == fstat(fd, &status)) { return {}; }
+        return static_cast<size_t>(status.st_size);
+    }
+
+    /**
+     * @brief Maps @param length bytes of the file starting at @param offset for reading, and passes @param advice
+     *      to madvise(). The file must be opened for reading.
+     * 
+     * @return optional<MappedRegion> - The mapping, or an empty optional if @param length is 0, the range does not
+     *      lie within the file or an error occurred. Pages past the end of file can not be read(SIGBUS), so such
+     *      ranges are rejected.
+     */
+    optional<MappedRegion> Map(const off_t &offset, const size_t &length, const AccessAdvice &advice = AccessAdvice::kSequential) const
+    {
+        const auto kSize = Size();
+        if (!kSize || 0 == length || offset < 0) { return {}; }
+        if (static_cast<size_t>(offset) > *kSize || length > *kSize - static_cast<size_t>(offset)) { return {}; }
+
+        static const auto kPageSize = static_cast<off_t>(sysconf(_SC_PAGESIZE));
+        const auto kMappingOffset   = offset - offset % kPageSize;
+        const auto kDataOffset      = static_cast<size_t>(offset - kMappingOffset);
+        auto *mapping = mmap(nullptr, kDataOffset + length, PROT_READ, MAP_SHARED, fd, kMappingOffset);
+        if (MAP_FAILED == mapping) { return {}; }
+
+        madvise(mapping, kDataOffset + length, static_cast<int>(advice));
+        return MappedRegion{ mapping, kDataOffset + length, kDataOffset, length };
+    }
+
+    /**
+     * @brief Copies the whole file to the current offset of @param destination, see file comments.
+     * 
+     * @return optional<size_t> - The number of bytes copied, or an empty optional if an error occurred.
+     */
+    optional<size_t> CopyTo(ResourceHandler &destination) const
+    {
+        const auto kSize = Size();
+        if (!kSize || !destination.IsValid()) { return {}; }
+
+        // Errors meaning the call is not supported for these files, after which the next method is tried
+        const auto kNotSupported = [](const int &error) { return EXDEV == error || EINVAL == error || ENOSYS == error || EOPNOTSUPP == error; };
+
+        auto offset = off_t{ 0 };
+        while (static_cast<size_t>(offset) < *kSize)
+        {
+            const auto kCopied = copy_file_range(fd, &offset, destination.fd, nullptr, *kSize - static_cast<size_t>(offset), 0);
+            if (0 == kCopied) { return static_cast<size_t>(offset); }
+            if (kCopied > 0 || EINTR == errno) { continue; }
+            if (kNotSupported(errno)) { break; }
+            return {};
+        }
+        while (static_cast<size_t>(offset) < *kSize)
+        {
+            const auto kCopied = sendfile(destination.fd, fd, &offset, *kSize - static_cast<size_t>(offset));
+            if (0 == kCopied) { return static_cast<size_t>(offset); }
+            if (kCopied > 0 || EINTR == errno) { continue; }
+            if (kNotSupported(errno)) { break; }
+            return {};
+        }
+        if (static_cast<size_t>(offset) < *kSize)
+        {
+            auto buffer = vector<unsigned char>(std::min(kCopyBufferSize, *kSize - static_cast<size_t>(offset)));
+            while (static_cast<size_t>(offset) < *kSize)
+            {
+                const auto kRead = pread(fd, buffer.data(), std::min(size(buffer), *kSize - static_cast<size_t>(offset)), offset);
+                if (0 == kRead) { return static_cast<size_t>(offset); }
+                if (kRead < 0)
+                {
+                    if (EINTR == errno) { continue; }
+                    return {};
+                }
+                for (auto data = span{ buffer }.first(static_cast<size_t>(kRead)); !data.empty() ;)
+                {
+                    const auto kWritten = write(destination.fd, data.data(), data.size());
+                    if (kWritten < 0 && EINTR != errno) { return {}; }
+                    if (kWritten > 0) { data = data.subspan(static_cast<size_t>(kWritten)); }
+                }
+                offset += kRead;
+            }
+        }
+        return kSize;
+    }
+
     /**
      * @brief Destructor to release the file descriptor.
      */
@@ -166,19 +639,122 @@ class ResourceHandler
     }
     static constexpr int kInvalidFd{ -1 };// Constant for an invalid file descriptor.
     int fd{ ResourceHandler::kInvalidFd };
+#if defined(USE_IO_URING)
+    unique_ptr<IoUringQueue> ring;// Created on first ReadBatch()
+#endif
 };
 
+/**
+ * @brief Returns true if files at @param path1 and @param path2 have the same contents.
+ */
+bool SameContents(const string &path1, const string &path2)
+{
+    const auto kFile1 = ResourceHandler{ path1, O_RDONLY };
+    const auto kFile2 = ResourceHandler{ path2, O_RDONLY };
+    if (kFile1.Size() != kFile2.Size()) { return false; }
+    if (0 == kFile1.Size()) { return true; }
+
+    const auto kRegion1 = kFile1.Map(0, *kFile1.Size());
+    const auto kRegion2 = kFile2.Map(0, *kFile2.Size());
+    return kRegion1 && kRegion2 && std::equal(begin(kRegion1->Data()), end(kRegion1->Data()), begin(kRegion2->Data()));
+}
+
 int main()
 {
-    auto file_handle = ResourceHandler{ "example.txt", O_CREAT | O_WRONLY };
+    auto file_handle = ResourceHandler{ "example.txt", O_CREAT | O_WRONLY | O_TRUNC, 0644 };
     file_handle.Write("ABCD");
 
     // auto file_handle_copy = file_handle; // error copy-constructor deleted
     auto file_handle3 = ResourceHandler{ "example.txt", O_RDONLY };
     auto data_read = file_handle3.Read(2);
     cout << data_read.size() << endl;
-    cout << "Bytes read: " << data_read.data() << endl;
+    cout << "Bytes read: " << string_view{ reinterpret_cast<const char *>(data_read.data()), data_read.size() } << endl;
 
     // file_handle = file_handle3; // error assignment operator deleted
+
+    // Moved handle keeps the descriptor open, and the moved from handle is invalid
+    auto moved_handle = std::move(file_handle);
+    const auto kMovedWritten = moved_handle.Write("EF");
+    assert(moved_handle.IsValid() && !file_handle.IsValid() && 2 == kMovedWritten);
+    file_handle = std::move(moved_handle);
+    assert(file_handle.IsValid() && !moved_handle.IsValid());
+
+    const auto kDirectory   = std::filesystem::temp_directory_path();
+    const auto kSourcePath  = (kDirectory / "21_system_handle_wrapper_source.bin").string();
+    const auto kCopyPath    = (kDirectory / "21_system_handle_wrapper_copy.bin").string();
+    const auto kCopy2Path   = (kDirectory / "21_system_handle_wrapper_copy2.bin").string();
+    {
+        // Written in 4 KB buffers gathered 256 at a time
+        auto random_engine = std::mt19937{ 21 };
+        auto block         = vector<char>(kCopyFileSize / 64);
+        for (auto &byte : block) { byte = static_cast<char>(random_engine()); }
+        auto buffers = vector<string_view>{};
+        for (auto offset = size_t{ 0 }; offset < size(block) ;offset += 4096) { buffers.emplace_back(block.data() + offset, 4096); }
+
+        auto source = ResourceHandler{ kSourcePath, O_CREAT | O_WRONLY | O_TRUNC, 0644 };
+        for (auto idx = 0; idx < 64 ;++idx)
+        {
+            const auto kGathered = source.WriteGather(buffers);
+            assert(static_cast<ssize_t>(size(block)) == kGathered);
+        }
+        const auto kPattern        = array<unsigned char, 4>{ 'W', 'X', 'Y', 'Z' };
+        const auto kPatternWritten = source.WriteAt(kPattern, 100);
+        assert(4 == kPatternWritten);
+    }
+
+    auto source = ResourceHandler{ kSourcePath, O_RDONLY };
+    assert(source.Size() == kCopyFileSize);
+    auto buffer = array<unsigned char, 8>{};
+    const auto kPatternRead = source.ReadAt(buffer, 98);
+    assert(8 == kPatternRead && 'W' == buffer[2] && 'Z' == buffer[5]);
+
+    const auto kRegion = source.Map(kCopyFileSize - 5000, 5000, AccessAdvice::kRandom);
+    assert(kRegion && 5000 == size(kRegion->Data()));
+    const auto kTailRead = source.ReadAt(buffer, kCopyFileSize - 8);
+    assert(8 == kTailRead && std::equal(begin(buffer), end(buffer), end(kRegion->Data()) - 8));
+    assert(!source.Map(kCopyFileSize - 5000, 5001) && !source.Map(kCopyFileSize + 4096, 1) && !source.Map(-1, 1));
+
+    // Random 4 KB reads in a batch, checked against the mapping of the whole file
+    auto random_engine = std::mt19937{ 22 };
+    auto batch_buffers = vector<unsigned char>(1024 * 4096);
+    auto requests      = vector<ReadRequest>{};
+    for (auto idx = size_t{ 0 }; idx < 1024 ;++idx)
+    {
+        requests.push_back({ span{ batch_buffers }.subspan(idx * 4096, 4096), static_cast<off_t>(random_engine() % (kCopyFileSize - 4096)) });
+    }
+    auto start_timepoint = steady_clock::now();
+    const auto kSucceeded = source.ReadBatch(requests);
+    cout << "ReadBatch() of " << size(requests) << " random 4 KB reads: " << duration<double>(steady_clock::now() - start_timepoint).count() << " s" << endl;
+    assert(size(requests) == kSucceeded);
+    const auto kWholeFile = source.Map(0, kCopyFileSize);
+    for (const auto &kRequest : requests)
+    {
+        assert(4096 == kRequest.result);
+        assert(std::equal(begin(kRequest.buffer), end(kRequest.buffer), kWholeFile->Data().data() + kRequest.offset));
+    }
+
+    {
+        auto reader = ResourceHandler{ kSourcePath, O_RDONLY };
+        auto writer = ResourceHandler{ kCopyPath, O_CREAT | O_WRONLY | O_TRUNC, 0644 };
+        start_timepoint = steady_clock::now();
+        for (auto chunk = reader.Read(kCopyChunk); !chunk.empty() ;chunk = reader.Read(kCopyChunk))
+        {
+            writer.Write(string_view{ reinterpret_cast<const char *>(chunk.data()), chunk.size() });
+        }
+        cout << "Copy of " << (kCopyFileSize >> 20) << " MB using Read() and Write(): " << duration<double>(steady_clock::now() - start_timepoint).count() << " s" << endl;
+    }
+    // Removed before the next copy, so that its dirty pages do not slow the next copy down
+    assert(SameContents(kSourcePath, kCopyPath));
+    std::filesystem::remove(kCopyPath);
+    {
+        auto writer = ResourceHandler{ kCopy2Path, O_CREAT | O_WRONLY | O_TRUNC, 0644 };
+        start_timepoint = steady_clock::now();
+        const auto kCopied = source.CopyTo(writer);
+        cout << "Copy of " << (kCopyFileSize >> 20) << " MB using CopyTo()         : " << duration<double>(steady_clock::now() - start_timepoint).count() << " s" << endl;
+        assert(kCopied == kCopyFileSize);
+    }
+    assert(SameContents(kSourcePath, kCopy2Path));
+
+    for (const auto &kPath : { kSourcePath, kCopy2Path }) { std::filesystem::remove(kPath); }
     return 0;
 }
\ No newline at end of file
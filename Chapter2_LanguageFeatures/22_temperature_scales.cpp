@@ -2,7 +2,7 @@
  * @file 22_temperature_scales.cpp
  * @author Usama Tayyab (usamatayyab9@gmail.com)
  * @brief 
- *  Compilation command : g++ -std=c++17 22_temperature_scales.cpp
+ *  Compilation command : g++ -std=c++20 -O2 -mavx2 -mfma 22_temperature_scales.cpp -lpthread
  *  This file is solution to "Problem 22. Literals of various temperature scales"
  *  mentioned in "Chapter 2: Language Features" of the book:
  *  - The Modern C++ Challenge by Marius Bancilla (available at amazon https://www.amazon.com/Modern-Challenge-programmer-real-world-problems/dp/1788993861)
@@ -25,6 +25,14 @@
  * See function definition for implementation details.
  * 
  * Then a constexpr templated function `TemperatureCast()` is provided to convert temperatures from on scale to other.
+ * Every conversion is linear i.e. dest = src * multiplier + offset, so `kTemperatureConversion<Dest, Src>` computes
+ * the multiplier and offset at compile time by composing conversions to and from celsius, and TemperatureCast()
+ * is a single multiply-add.
+ * 
+ * For converting arrays of temperatures, such as readings of a sensor stream, an overload of `TemperatureCast()`
+ * takes a span of source temperatures and a span for the results. Since `Temperature` is a wrapper of a single
+ * double with no overhead, the spans are processed as arrays of doubles, 4 at a time with AVX2(fused multiply-add
+ * with FMA) or 2 at a time with SSE2. `TemperatureCastParallel()` splits large arrays among threads.
  * 
  * Then a namespace temperature_scales is defined which defines all lieteral operators needed for creating
  * temperature values such as 100_deg, 37.5_f, 100_K etc.
@@ -35,17 +43,40 @@
  * - Initializes some Temperature objects with different scales.
  * - Then cast the temperatures into a different scale and print theri values
  * - Lastly compares the different temperatures and prints theri comparison results. 
+ * - Then bulk conversions between all scales are checked against the per element conversion, and time
+ *      taken for converting `kBulkCount` temperatures per element, in bulk and in parallel is printed.
  * 
  * @copyright Copyright (c) 2023
  * 
  */
 #include <iostream>
 #include <array>
+#include <span>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <type_traits>
+#include <random>
+#include <chrono>
+#include <cassert>
+#include <cmath>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 using std::array;
 using std::cout;
 using std::endl;
 using std::ostream;
+using std::span;
+using std::vector;
+using std::thread;
+using std::chrono::steady_clock;
+using std::chrono::duration;
+
+inline constexpr auto kParallelCastMinimum = size_t{ 1 } << 20;
+inline constexpr auto kBulkCount           = size_t{ 1 } << 24;
 
 /**
  * Extension :
@@ -66,7 +97,7 @@ enum class Scale { kCelsius, kFarhrenheit, kKelvin };
 template<Scale S> class Temperature
 {
     public:
-    const Scale scale{ S };
+    static constexpr Scale scale{ S };
     constexpr explicit Temperature(const double &arg) : amount_{ arg }
     {}
     constexpr explicit operator double() const { return amount_; }
@@ -76,6 +107,9 @@ template<Scale S> class Temperature
     double amount_ { 0.0 };
 };
 
+static_assert(sizeof(Temperature<Scale::kCelsius>) == sizeof(double) && std::is_trivially_copyable_v<Temperature<Scale::kCelsius>>,
+              "Temperature must have the layout of a double, for converting arrays of it");
+
 /**
  * @brief Print Temperature objec @param t1 stream object @param out
  * 
@@ -97,13 +131,60 @@ StreamType& operator<<(StreamType &out, const Temperature<scale> &t1)
 }
 
 
+/**
+ * @brief Conversion between two scales i.e. dest = src * multiplier + offset
+ */
+struct LinearConversion
+{
+    double multiplier = 1.0;
+    double offset     = 0.0;
+};
+
+/**
+ * @brief Returns conversion from scale @param scale to celsius.
+ */
+constexpr LinearConversion ToCelsius(const Scale &scale)
+{
+    switch (scale)
+    {
+    case Scale::kCelsius:     return { 1.0, 0.0 };
+    case Scale::kFarhrenheit: return { 5.0 / 9.0, -32.0 * 5.0 / 9.0 };
+    case Scale::kKelvin:      return { 1.0, -273.15 };
+    }
+    return {};
+}
+
+/**
+ * @brief Returns conversion from celsius to scale @param scale.
+ */
+constexpr LinearConversion FromCelsius(const Scale &scale)
+{
+    switch (scale)
+    {
+    case Scale::kCelsius:     return { 1.0, 0.0 };
+    case Scale::kFarhrenheit: return { 9.0 / 5.0, 32.0 };
+    case Scale::kKelvin:      return { 1.0, 273.15 };
+    }
+    return {};
+}
+
+/**
+ * @brief Conversion from scale @tparam Src to scale @tparam Dest computed at compile time, by converting to celsius
+ *      and then from celsius i.e. dest = (src * m_src + c_src) * m_dest + c_dest. Celsius is used in between since
+ *      the conversions to and from it have the simplest constants, so that for example 100C is exactly 212F.
+ */
+template <Scale Dest, Scale Src>
+inline constexpr auto kTemperatureConversion = []()
+{
+    const auto kSrc  = ToCelsius(Src);
+    const auto kDest = FromCelsius(Dest);
+    return LinearConversion{ kSrc.multiplier * kDest.multiplier, kSrc.offset * kDest.multiplier + kDest.offset };
+}();
+
 /**
  * @brief A utility function for transforming a Temperature into a different scale.
  * 
- * Defines all the combination of functions in a table for converting between all three
- *  scales(celsius, Farhrenheit and kelvin).
- * Based on source scale type and destination scale type Fetches the conversion funtion
- * Passes the value into conversion function and returns the result.
+ * Applies the multiplier and offset of kTemperatureConversion<Dest, Src>, which are compile time constants.
  * 
  * @tparam Dest - unit to which @param temp is converted to
  * @tparam Src - unit of @param temp
@@ -113,27 +194,77 @@ StreamType& operator<<(StreamType &out, const Temperature<scale> &t1)
 template <Scale Dest, Scale Src>
 constexpr Temperature<Dest> TemperatureCast(const Temperature<Src> &temp)
 {
-    constexpr auto Identity = [](const double &arg) -> double { return arg; };    
-    constexpr auto kConversionFunctions = array< array<double(*)(const double &), 3> ,3>
-    {{
-        {
-            Identity,                                                        /* celsius to celsius */
-            [](const double &value){ return ((value * 9.0) / 5.0) + 32.0; }, /* Celsius to Fahrenheit */
-            [](const double &value){ return value + 273.15; }                /* celsius to Kelvin */
-        },
-        {
-            [](const double &value){ return ((value - 32.0) * 5.0) / 9.0; },           /* Fahrenheit to celsius */
-            Identity,                                                                  /* Fahrenheit to Fahrenheit */
-            [](const double &value){ return ((value - 32.0) * 5.0 / 9.0) + 273.15; }  /* Fahrenheit to Kelvin */
-        },
-        {
-            [](const double &value){ return value - 273.15; },                        /* kelvin to celsius */
-            [](const double &value){ return ((value - 273.15) * 9.0 / 5.0) + 32.0; }, /* Kelvin to Fahrenheit */
-            Identity                                                                  /* Kelvin to Kelvin */
-        }
-    }};
-    constexpr auto kConversionFunction = kConversionFunctions[static_cast<int>(Src)][static_cast<int>(Dest)];
-    return Temperature<Dest>( kConversionFunction(temp.Count()) );
+    constexpr auto kConversion = kTemperatureConversion<Dest, Src>;
+    if constexpr (Dest == Src) { return Temperature<Dest>( temp.Count() ); }
+    return Temperature<Dest>( temp.Count() * kConversion.multiplier + kConversion.offset );
+}
+
+/**
+ * @brief Converts all temperatures of @param source into @param destination, which must have atleast as many
+ *      elements, see file comments.
+ * 
+ * @tparam Dest - unit of @param destination
+ * @tparam Src - unit of @param source
+ */
+template <Scale Dest, Scale Src>
+void TemperatureCast(span<const Temperature<Src>> source, span<Temperature<Dest>> destination)
+{
+    constexpr auto kConversion = kTemperatureConversion<Dest, Src>;
+    const auto kCount          = source.size();
+    const auto *kSource        = reinterpret_cast<const double *>(source.data());
+    auto *result               = reinterpret_cast<double *>(destination.data());
+    if constexpr (Dest == Src)
+    {
+        std::copy_n(kSource, kCount, result);
+        return;
+    }
+
+    auto idx = size_t{ 0 };
+#if defined(__AVX2__)
+    const auto kMultiplier = _mm256_set1_pd(kConversion.multiplier);
+    const auto kOffset     = _mm256_set1_pd(kConversion.offset);
+    for (; idx + 4 <= kCount ;idx += 4)
+    {
+#if defined(__FMA__)
+        _mm256_storeu_pd(result + idx, _mm256_fmadd_pd(_mm256_loadu_pd(kSource + idx), kMultiplier, kOffset));
+#else
+        _mm256_storeu_pd(result + idx, _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(kSource + idx), kMultiplier), kOffset));
+#endif
+    }
+#elif defined(__SSE2__)
+    const auto kMultiplier = _mm_set1_pd(kConversion.multiplier);
+    const auto kOffset     = _mm_set1_pd(kConversion.offset);
+    for (; idx + 2 <= kCount ;idx += 2)
+    {
+        _mm_storeu_pd(result + idx, _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(kSource + idx), kMultiplier), kOffset));
+    }
+#endif
+    for (; idx < kCount ;++idx) { result[idx] = kSource[idx] * kConversion.multiplier + kConversion.offset; }
+}
+
+/**
+ * @brief Same as TemperatureCast() of spans, but splits the arrays among @param thread_count threads
+ *      when there are atleast kParallelCastMinimum temperatures.
+ */
+template <Scale Dest, Scale Src>
+void TemperatureCastParallel(span<const Temperature<Src>> source, span<Temperature<Dest>> destination,
+                             const size_t &thread_count = std::max(1u, thread::hardware_concurrency()))
+{
+    if (source.size() < kParallelCastMinimum || thread_count < 2)
+    {
+        TemperatureCast<Dest, Src>(source, destination);
+        return;
+    }
+
+    // Chunks are multiples of 8 elements(a cache line), so that threads do not write to the same cache line
+    const auto kChunk = ((source.size() + thread_count - 1) / thread_count + 7) / 8 * 8;
+    auto threads      = vector<thread>{};
+    for (auto first = size_t{ 0 }; first < source.size() ;first += kChunk)
+    {
+        const auto kLength = std::min(kChunk, source.size() - first);
+        threads.emplace_back([=]() { TemperatureCast<Dest, Src>(source.subspan(first, kLength), destination.subspan(first, kLength)); });
+    }
+    for (auto &t : threads) { t.join(); }
 }
 
 /**
@@ -221,5 +352,47 @@ int main()
     cout << Compare(kC0, kC0) << endl;
     cout << Compare(kK0, kK0) << endl;
 
+    static_assert(TemperatureCast<Scale::kFarhrenheit>(100_deg).Count() == 212.0);
+    static_assert(TemperatureCast<Scale::kKelvin>(0_deg).Count() == 273.15);
+
+    auto random_engine = std::mt19937{ 22 };
+    auto distribution  = std::uniform_real_distribution<double>{ -300.0, 1000.0 };
+    auto celsius       = vector<Temperature<Scale::kCelsius>>{};
+    for (auto idx = size_t{ 0 }; idx < kBulkCount + 3 ;++idx) { celsius.emplace_back(distribution(random_engine)); }
+
+    // Round trip through every scale, each step checked against the per element conversion
+    const auto kCheck = [](const auto &source, const auto &destination)
+    {
+        for (auto idx = size_t{ 0 }; idx < 100'003 ;++idx)
+        {
+            using Dest = std::remove_cvref_t<decltype(destination[0])>;
+            const auto kExpected = TemperatureCast<Dest::scale>(source[idx]).Count();
+            assert(std::abs(destination[idx].Count() - kExpected) <= 1e-12 * std::max(1.0, std::abs(kExpected)));
+        }
+    };
+    auto fahrenheit = vector<Temperature<Scale::kFarhrenheit>>(size(celsius), Temperature<Scale::kFarhrenheit>{ 0 });
+    auto kelvin     = vector<Temperature<Scale::kKelvin>>(size(celsius), Temperature<Scale::kKelvin>{ 0 });
+    auto result     = vector<Temperature<Scale::kCelsius>>(size(celsius), Temperature<Scale::kCelsius>{ 0 });
+    TemperatureCast<Scale::kFarhrenheit, Scale::kCelsius>(celsius, fahrenheit);       kCheck(celsius, fahrenheit);
+    TemperatureCast<Scale::kKelvin, Scale::kFarhrenheit>(fahrenheit, kelvin);         kCheck(fahrenheit, kelvin);
+    TemperatureCast<Scale::kCelsius, Scale::kKelvin>(kelvin, result);                 kCheck(kelvin, result);
+    TemperatureCastParallel<Scale::kKelvin, Scale::kCelsius>(result, kelvin, 3);      kCheck(result, kelvin);
+    TemperatureCastParallel<Scale::kFarhrenheit, Scale::kKelvin>(kelvin, fahrenheit); kCheck(kelvin, fahrenheit);
+    TemperatureCast<Scale::kCelsius, Scale::kFarhrenheit>(fahrenheit, result);        kCheck(fahrenheit, result);
+    TemperatureCast<Scale::kCelsius, Scale::kCelsius>(celsius, result);
+    assert(std::equal(begin(celsius), end(celsius), begin(result), [](const auto &a, const auto &b) { return a.Count() == b.Count(); }));
+
+    auto start_timepoint = steady_clock::now();
+    for (auto idx = size_t{ 0 }; idx < kBulkCount ;++idx) { kelvin[idx] = TemperatureCast<Scale::kKelvin>(fahrenheit[idx]); }
+    cout << "Per element conversion of " << kBulkCount << " temperatures: " << duration<double>(steady_clock::now() - start_timepoint).count() << " s" << endl;
+
+    start_timepoint = steady_clock::now();
+    TemperatureCast<Scale::kKelvin, Scale::kFarhrenheit>(span{ fahrenheit }.first(kBulkCount), kelvin);
+    cout << "Bulk conversion of " << kBulkCount << " temperatures: " << duration<double>(steady_clock::now() - start_timepoint).count() << " s" << endl;
+
+    start_timepoint = steady_clock::now();
+    TemperatureCastParallel<Scale::kKelvin, Scale::kFarhrenheit>(span{ fahrenheit }.first(kBulkCount), kelvin);
+    cout << "Parallel conversion of " << kBulkCount << " temperatures: " << duration<double>(steady_clock::now() - start_timepoint).count() << " s" << endl;
+
     return 0;
 }
\ No newline at end of file
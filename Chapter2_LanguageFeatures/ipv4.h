@@ -0,0 +1,375 @@
+/**
+ * @file ipv4.h
+ * @author Usama Tayyab (usamatayyab9@gmail.com)
+ * @brief
+ *      This file provides the class `IPV4` shared by 15_ipv4_data_type.cpp and 16_enumerating_ipv4.cpp.
+ *
+ *      The address is stored as a single uint32_t in host order, i.e. 172.16.254.1 is stored as
+ *      (10101100 00010000 11111110 00000001) base-2 = (2886794753) base-10. So comparison and
+ *      incrementing are single integer operations, and octets are extracted with shifts.
+ *
+ *      Conversions to and from text do not allocate and do not use streams:
+ *          - FromChars() parses a dotted-quad from a character range, in the manner of std::from_chars.
+ *            With SSSE3 the whole address is parsed with a few vector instructions: dots are located
+ *            using a byte compare, the lengths of the four octets select one of the 81 shuffle masks which
+ *            moves every digit to its place in a 4 byte slot per octet, and the digits of all octets are
+ *            then multiplied by 100, 10, 1 and added using _mm_maddubs_epi16 and _mm_madd_epi16.
+ *          - ToChars() writes the dotted-quad into a caller provided buffer, in the manner of std::to_chars,
+ *            copying each octet from a table of all 256 octet strings.
+ *
+ *      IPV4Range is a range of consecutive addresses, such as a CIDR block 10.0.0.0/8, with a random
+ *      access iterator. Positions are kept in 64 bits so that even 0.0.0.0/0 has a valid end iterator.
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef IPV4_H
+#define IPV4_H
+
+#include <array>
+#include <bit>
+#include <charconv>
+#include <compare>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#if defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief A class for representing an IPV4 address
+ *
+ */
+class IPV4
+{
+public:
+    using octet_type = unsigned char;
+
+    /*! Longest dotted-quad i.e. 255.255.255.255 */
+    static constexpr auto kMaxLength = size_t{ 15 };
+
+    constexpr IPV4() = default;
+    constexpr IPV4(const octet_type b1, const octet_type b2, const octet_type b3, const octet_type b4) :
+        value_{ (uint32_t{ b1 } << 24) | (uint32_t{ b2 } << 16) | (uint32_t{ b3 } << 8) | uint32_t{ b4 } }
+    {
+    }
+    constexpr explicit IPV4(const uint32_t value) : value_{ value }
+    {
+    }
+
+    /**
+     * @brief Returns octet at @param idx, where 0 is the leftmost octet of the dotted form.
+     */
+    constexpr octet_type Octet(const size_t &idx) const
+    {
+        return static_cast<octet_type>(value_ >> (24 - 8 * idx));
+    }
+
+    /**
+     * @brief Returns the integer equivalent of the address, which is how it is stored.
+     * Consider 172.16.254.1 as an example, writing the binary of each octet together gives:
+     * (10101100 00010000 11111110 00000001) base-2 = (2886794753) base-10
+     *
+     *  @return uint32_t - integer representation of an IPV4 address
+     */
+    constexpr uint32_t ToInteger() const { return value_; }
+
+    constexpr auto operator<=>(const IPV4 &) const = default;
+
+    /**
+     * @brief Increments the address by 1, 255.255.255.255 wraps around to 0.0.0.0.
+     *      For example 192.168.1.255 becomes 192.168.2.0.
+     * @return IPV4& - increment the current object and returns its reference
+     */
+    constexpr IPV4& Advance()
+    {
+        ++value_;
+        return *this;
+    }
+
+    std::string ToString() const;
+
+    friend std::istream& operator>>(std::istream &in, IPV4 &address);
+
+    friend std::ostream& operator<<(std::ostream &out, const IPV4 &address)
+    {
+        return out << address.ToString();
+    }
+
+private:
+    uint32_t value_ = 0;
+};
+
+/**
+ * @brief Textual form of every octet value, used by ToChars().
+ */
+struct IPV4OctetText
+{
+    std::array<char, 3> digits{};
+    uint8_t             length = 0;
+};
+
+inline constexpr auto kIPV4OctetTexts = []()
+{
+    auto texts = std::array<IPV4OctetText, 256>{};
+    for (auto value = 0; value < 256 ;++value)
+    {
+        auto &text = texts[value];
+        if (value >= 100) { text.digits[text.length++] = static_cast<char>('0' + value / 100); }
+        if (value >= 10)  { text.digits[text.length++] = static_cast<char>('0' + (value / 10) % 10); }
+        text.digits[text.length++] = static_cast<char>('0' + value % 10);
+    }
+    return texts;
+}();
+
+/**
+ * @brief Writes @param address in dotted form into [@param first, @param last).
+ * @return {end of the written characters, errc{}} on success, or {last, errc::value_too_large}
+ *      if the buffer is too small, in which case contents of the buffer are unspecified.
+ */
+inline std::to_chars_result ToChars(char *first, char *last, const IPV4 &address)
+{
+    auto length = size_t{ 3 };
+    for (auto idx = size_t{ 0 }; idx < 4 ;++idx) { length += kIPV4OctetTexts[address.Octet(idx)].length; }
+    if (static_cast<size_t>(last - first) < length) { return { last, std::errc::value_too_large }; }
+
+    for (auto idx = size_t{ 0 }; idx < 4 ;++idx)
+    {
+        const auto &kText = kIPV4OctetTexts[address.Octet(idx)];
+        std::memcpy(first, kText.digits.data(), kText.length);
+        first += kText.length;
+        if (idx < 3) { *first++ = '.'; }
+    }
+    return { first, std::errc{} };
+}
+
+inline std::string IPV4::ToString() const
+{
+    auto buffer       = std::array<char, kMaxLength + 2>{};
+    const auto kEnd   = ToChars(buffer.data(), buffer.data() + size(buffer), *this).ptr;
+    return std::string(buffer.data(), kEnd);
+}
+
+/**
+ * @brief Parses a dotted-quad from [@param first, @param last) one character at a time.
+ *      Every octet must have 1 to 3 digits and value <= 255, leading zeros are accepted.
+ *      The address ends at the first character which is neither a digit nor a '.'.
+ * @return same as FromChars().
+ */
+inline std::from_chars_result FromCharsScalar(const char *first, const char *last, IPV4 &address)
+{
+    const auto kIsDigit = [](const char &ch) { return ch >= '0' && ch <= '9'; };
+    const auto *current = first;
+    auto value          = uint32_t{ 0 };
+    for (auto idx = 0; idx < 4 ;++idx)
+    {
+        if (idx > 0)
+        {
+            if (current == last || '.' != *current) { return { first, std::errc::invalid_argument }; }
+            ++current;
+        }
+
+        auto octet  = uint32_t{ 0 };
+        auto digits = 0;
+        for (; current != last && kIsDigit(*current) && digits < 3 ;++current, ++digits) { octet = 10 * octet + (*current - '0'); }
+        if (0 == digits || octet > 255) { return { first, std::errc::invalid_argument }; }
+        value = (value << 8) | octet;
+    }
+    if (current != last && (kIsDigit(*current) || '.' == *current)) { return { first, std::errc::invalid_argument }; }
+
+    address = IPV4{ value };
+    return { current, std::errc{} };
+}
+
+#if defined(__SSSE3__)
+/**
+ * @brief Shuffle masks for FromChars(), indexed by the lengths(1 to 3) of the four octets as
+ *      27 * (l1 - 1) + 9 * (l2 - 1) + 3 * (l3 - 1) + (l4 - 1). Octet k is moved to bytes
+ *      [4k, 4k + 3) right aligned i.e. as hundreds, tens and units. Unused bytes select 0x80(zero).
+ */
+inline constexpr auto kIPV4ShuffleMasks = []()
+{
+    auto masks = std::array<std::array<uint8_t, 16>, 81>{};
+    for (auto pattern = 0; pattern < 81 ;++pattern)
+    {
+        auto &mask  = masks[pattern];
+        mask.fill(0x80);
+        auto source = 0;
+        for (auto octet = 0, divisor = 27; octet < 4 ;++octet, divisor /= 3)
+        {
+            const auto kLength = (pattern / divisor) % 3 + 1;
+            for (auto digit = 0; digit < kLength ;++digit)
+            {
+                mask[4 * octet + (3 - kLength) + digit] = static_cast<uint8_t>(source + digit);
+            }
+            source += kLength + 1; // skip the digits and the '.'
+        }
+    }
+    return masks;
+}();
+
+/**
+ * @brief Parses a dotted-quad from the 16 bytes at @param first, see file comments.
+ *      Same rules as FromCharsScalar(), but @param first must point to atleast 16 readable bytes.
+ */
+inline std::from_chars_result FromChars16Bytes(const char *first, IPV4 &address)
+{
+    const auto kBytes   = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+    const auto kDigits  = _mm_sub_epi8(kBytes, _mm_set1_epi8('0'));
+    const auto kIsDigit = _mm_cmpeq_epi8(_mm_min_epu8(kDigits, _mm_set1_epi8(9)), kDigits);
+    const auto kIsDot   = _mm_cmpeq_epi8(kBytes, _mm_set1_epi8('.'));
+
+    // Address is the run of digits and dots at the start, atmost kMaxLength characters
+    const auto kDigitMask = static_cast<uint32_t>(_mm_movemask_epi8(kIsDigit));
+    const auto kLength    = static_cast<uint32_t>(std::countr_one(kDigitMask | static_cast<uint32_t>(_mm_movemask_epi8(kIsDot))));
+    if (kLength > IPV4::kMaxLength) { return { first, std::errc::invalid_argument }; }
+
+    auto dots = static_cast<uint32_t>(_mm_movemask_epi8(kIsDot)) & ((1u << kLength) - 1);
+    if (3 != std::popcount(dots)) { return { first, std::errc::invalid_argument }; }
+
+    auto pattern = 0;
+    auto start   = uint32_t{ 0 };
+    for (auto octet = 0; octet < 4 ;++octet)
+    {
+        const auto kEnd         = (octet < 3) ? static_cast<uint32_t>(std::countr_zero(dots)) : kLength;
+        const auto kOctetLength = kEnd - start;
+        if (kOctetLength < 1 || kOctetLength > 3) { return { first, std::errc::invalid_argument }; }
+
+        pattern = 3 * pattern + static_cast<int>(kOctetLength) - 1;
+        start   = kEnd + 1;
+        dots   &= dots - 1;
+    }
+
+    const auto kMask    = _mm_loadu_si128(reinterpret_cast<const __m128i *>(kIPV4ShuffleMasks[pattern].data()));
+    const auto kPlaced  = _mm_shuffle_epi8(kDigits, kMask);
+    const auto kPairs   = _mm_maddubs_epi16(kPlaced, _mm_setr_epi8(100, 10, 1, 0, 100, 10, 1, 0, 100, 10, 1, 0, 100, 10, 1, 0));
+    const auto kOctets  = _mm_madd_epi16(kPairs, _mm_set1_epi16(1));
+    if (0 != _mm_movemask_epi8(_mm_cmpgt_epi32(kOctets, _mm_set1_epi32(255)))) { return { first, std::errc::invalid_argument }; }
+
+    // Low byte of octet k is at byte 4k, gather them in reverse so that the first octet is the most significant
+    const auto kGathered = _mm_shuffle_epi8(kOctets, _mm_setr_epi8(12, 8, 4, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+    address = IPV4{ static_cast<uint32_t>(_mm_cvtsi128_si32(kGathered)) };
+    return { first + kLength, std::errc{} };
+}
+#endif
+
+/**
+ * @brief Parses a dotted-quad such as 127.0.0.1 from [@param first, @param last), in the manner
+ *      of std::from_chars. See FromCharsScalar() for the accepted format. No allocation is done.
+ *      When atleast 16 characters are available the vectorized parser is used.
+ * @return {pointer past the address, errc{}} on success, in which case @param address is assigned,
+ *      or {first, errc::invalid_argument} if the characters do not form a valid address.
+ */
+inline std::from_chars_result FromChars(const char *first, const char *last, IPV4 &address)
+{
+#if defined(__SSSE3__)
+    if (last - first >= 16) { return FromChars16Bytes(first, address); }
+#endif
+    return FromCharsScalar(first, last, address);
+}
+
+/**
+ * @brief Reads an address in dotted form, sets failbit if it is not a valid address.
+ */
+inline std::istream& operator>>(std::istream &in, IPV4 &address)
+{
+    auto text = std::string{};
+    if (in >> text)
+    {
+        const auto kResult = FromChars(text.data(), text.data() + size(text), address);
+        if (std::errc{} != kResult.ec || kResult.ptr != text.data() + size(text)) { in.setstate(std::ios::failbit); }
+    }
+    return in;
+}
+
+/**
+ * @brief Range of consecutive addresses [first, last], both inclusive.
+ */
+class IPV4Range
+{
+public:
+    class iterator
+    {
+    public:
+        using iterator_concept  = std::random_access_iterator_tag;
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type        = IPV4;
+        using difference_type   = int64_t;
+        using reference         = IPV4;
+
+        constexpr iterator() = default;
+        constexpr explicit iterator(const uint64_t &position) : position_{ position } {}
+
+        constexpr IPV4 operator*() const { return IPV4{ static_cast<uint32_t>(position_) }; }
+        constexpr IPV4 operator[](const difference_type &offset) const { return *(*this + offset); }
+
+        constexpr iterator& operator++() { ++position_; return *this; }
+        constexpr iterator  operator++(int) { auto copy = *this; ++position_; return copy; }
+        constexpr iterator& operator--() { --position_; return *this; }
+        constexpr iterator  operator--(int) { auto copy = *this; --position_; return copy; }
+        constexpr iterator& operator+=(const difference_type &offset) { position_ += offset; return *this; }
+        constexpr iterator& operator-=(const difference_type &offset) { position_ -= offset; return *this; }
+
+        friend constexpr iterator operator+(iterator iter, const difference_type &offset) { return iter += offset; }
+        friend constexpr iterator operator+(const difference_type &offset, iterator iter) { return iter += offset; }
+        friend constexpr iterator operator-(iterator iter, const difference_type &offset) { return iter -= offset; }
+        friend constexpr difference_type operator-(const iterator &lhs, const iterator &rhs)
+        {
+            return static_cast<difference_type>(lhs.position_) - static_cast<difference_type>(rhs.position_);
+        }
+        constexpr auto operator<=>(const iterator &) const = default;
+
+    private:
+        uint64_t position_ = 0;
+    };
+
+    constexpr IPV4Range(const IPV4 &first, const IPV4 &last) : first_{ first.ToInteger() }, end_{ uint64_t{ last.ToInteger() } + 1 }
+    {
+        if (end_ < first_) { end_ = first_; } // last < first is an empty range
+    }
+
+    /**
+     * @brief Returns the block of addresses of a CIDR notation such as 10.0.0.0/8, host bits of the
+     *      address are ignored. Returns an empty optional if @param cidr is not valid.
+     */
+    static std::optional<IPV4Range> FromCIDR(std::string_view cidr)
+    {
+        auto address        = IPV4{};
+        const auto *kEnd    = cidr.data() + cidr.size();
+        const auto kAddress = FromChars(cidr.data(), kEnd, address);
+        auto prefix_length  = 0;
+        if (std::errc{} != kAddress.ec || kAddress.ptr == kEnd || '/' != *kAddress.ptr) { return {}; }
+
+        const auto kPrefix = std::from_chars(kAddress.ptr + 1, kEnd, prefix_length);
+        if (std::errc{} != kPrefix.ec || kPrefix.ptr != kEnd || prefix_length < 0 || prefix_length > 32) { return {}; }
+
+        const auto kHostMask = static_cast<uint32_t>((uint64_t{ 1 } << (32 - prefix_length)) - 1);
+        return IPV4Range{ IPV4{ address.ToInteger() & ~kHostMask }, IPV4{ address.ToInteger() | kHostMask } };
+    }
+
+    constexpr iterator begin() const { return iterator{ first_ }; }
+    constexpr iterator end() const   { return iterator{ end_ }; }
+    constexpr uint64_t size() const  { return end_ - first_; }
+    constexpr bool empty() const     { return end_ == first_; }
+    constexpr IPV4 operator[](const uint64_t &idx) const { return IPV4{ static_cast<uint32_t>(first_ + idx) }; }
+
+    constexpr bool Contains(const IPV4 &address) const
+    {
+        return address.ToInteger() >= first_ && address.ToInteger() < end_;
+    }
+
+private:
+    uint64_t first_;
+    uint64_t end_;
+};
+
+static_assert(std::random_access_iterator<IPV4Range::iterator>);
+
+#endif // IPV4_H
@@ -0,0 +1,315 @@
+/**
+ * @file ipv4_routing_table.h
+ * @author Usama Tayyab (usamatayyab9@gmail.com)
+ * @brief
+ *      This file provides `IPV4RoutingTable`, a longest prefix match table which maps an `IPV4`
+ *      address to the next hop(any 31-bit value chosen by the user) of the longest CIDR prefix
+ *      containing the address.
+ *
+ *      The table uses the DIR-24-8 layout:
+ *          - tbl24 has one 32-bit entry for every /24 block i.e. 2^24 entries indexed by the upper
+ *            24 bits of the address. An entry either holds the next hop of the longest prefix of
+ *            length <= 24 covering the block, or if the block has longer prefixes the index of a
+ *            tbl8 group, marked by `kExtendedBit`.
+ *          - tbl8 groups have 256 entries each, indexed by the lower 8 bits of the address, for the
+ *            prefixes of length 25 to 32.
+ *      So a lookup is one memory access in most cases and two at most. Since tbl24 is 64 MB nearly
+ *      every lookup is a cache miss, the batched Lookup() hides this latency by prefetching the
+ *      tbl24 entries of `kPrefetchDistance` addresses ahead.
+ *
+ *      The table is built once from all prefixes, either in memory or from a prefix file, and is
+ *      immutable afterwards. Prefixes are applied in increasing order of length so that a longer
+ *      prefix overwrites the entries of the shorter ones containing it.
+ *
+ *      `ConcurrentIPV4RoutingTable` allows lookups from many threads while a rebuilt table is swapped
+ *      in. The current table is published through an atomic pointer and old tables are reclaimed using
+ *      hazard pointers: every reader thread keeps a `ConcurrentIPV4RoutingTable::Reader`, which owns a
+ *      slot holding the table it is using. Loading never takes a lock and, while the table is unchanged,
+ *      does not write to memory at all. A writer swaps the pointer and frees the replaced tables which no
+ *      slot holds, the others are kept and checked again on the next swap. Writers, and creating or
+ *      destroying a Reader, take a mutex.
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef IPV4_ROUTING_TABLE_H
+#define IPV4_ROUTING_TABLE_H
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "ipv4.h"
+
+/**
+ * @brief A CIDR prefix such as 10.0.0.0/8 along with its next hop.
+ */
+struct IPV4Prefix
+{
+    IPV4     address;
+    uint8_t  length   = 0;
+    uint32_t next_hop = 0;
+
+    /**
+     * @brief Parses a line of a prefix file i.e. "<address>/<length> <next hop>". Host bits of the
+     *      address are ignored. Returns an empty optional if @param line is not valid.
+     */
+    static std::optional<IPV4Prefix> FromString(std::string_view line);
+};
+
+class IPV4RoutingTable
+{
+public:
+    /*! Next hop returned by the batched Lookup() for an address not covered by any prefix. */
+    static constexpr auto kNoRoute        = uint32_t{ 0x7FFF'FFFF };
+    static constexpr auto kExtendedBit    = uint32_t{ 0x8000'0000 };
+    static constexpr auto kPrefetchDistance = size_t{ 16 };
+
+    /**
+     * @brief Builds the table from @param prefixes, when a prefix appears more than once the last one
+     *      is used. Next hop of every prefix must be less than kNoRoute.
+     */
+    explicit IPV4RoutingTable(std::vector<IPV4Prefix> prefixes) : tbl24_(size_t{ 1 } << 24, kNoRoute)
+    {
+        std::stable_sort(begin(prefixes), end(prefixes), [](const auto &lhs, const auto &rhs) { return lhs.length < rhs.length; });
+        for (const auto &kPrefix : prefixes)
+        {
+            const auto kHostMask = static_cast<uint32_t>((uint64_t{ 1 } << (32 - kPrefix.length)) - 1);
+            const auto kFirst    = kPrefix.address.ToInteger() & ~kHostMask;
+            if (kPrefix.length <= 24)
+            {
+                std::fill_n(begin(tbl24_) + (kFirst >> 8), size_t{ 1 } << (24 - kPrefix.length), kPrefix.next_hop);
+                continue;
+            }
+
+            auto &entry = tbl24_[kFirst >> 8];
+            if (0 == (entry & kExtendedBit))
+            {
+                const auto kGroup = static_cast<uint32_t>(size(tbl8_) / 256);
+                tbl8_.resize(size(tbl8_) + 256, entry);
+                entry = kExtendedBit | kGroup;
+            }
+            const auto kGroupStart = size_t{ entry & ~kExtendedBit } * 256;
+            std::fill_n(begin(tbl8_) + kGroupStart + (kFirst & 0xFF), size_t{ 1 } << (32 - kPrefix.length), kPrefix.next_hop);
+        }
+        prefix_count_ = size(prefixes);
+    }
+
+    /**
+     * @brief Builds the table from the file @param path having one prefix per line in the format
+     *      accepted by IPV4Prefix::FromString(). Empty lines and lines starting with '#' are skipped.
+     *      Returns an empty optional if the file can not be read or has an invalid line.
+     */
+    static std::optional<IPV4RoutingTable> FromFile(const std::string &path)
+    {
+        auto file = std::ifstream{ path };
+        if (!file) { return {}; }
+
+        auto prefixes = std::vector<IPV4Prefix>{};
+        for (auto line = std::string{}; std::getline(file, line) ;)
+        {
+            if (!line.empty() && '\r' == line.back()) { line.pop_back(); }
+            if (line.empty() || '#' == line.front()) { continue; }
+
+            const auto kPrefix = IPV4Prefix::FromString(line);
+            if (!kPrefix) { return {}; }
+            prefixes.push_back(*kPrefix);
+        }
+        return IPV4RoutingTable{ std::move(prefixes) };
+    }
+
+    /**
+     * @brief Returns next hop of the longest prefix containing @param address, or an empty optional
+     *      if there is no such prefix.
+     */
+    std::optional<uint32_t> Lookup(const IPV4 &address) const
+    {
+        const auto kNextHop = NextHop(address.ToInteger());
+        if (kNoRoute == kNextHop) { return {}; }
+        return kNextHop;
+    }
+
+    /**
+     * @brief Looks up all @param addresses and writes next hop of each to @param next_hops(kNoRoute
+     *      if there is no route), see file comments. @param next_hops must be atleast as long as
+     *      @param addresses.
+     */
+    void Lookup(std::span<const IPV4> addresses, std::span<uint32_t> next_hops) const
+    {
+        const auto kCount = size(addresses);
+        for (auto idx = size_t{ 0 }; idx < std::min(kCount, kPrefetchDistance) ;++idx)
+        {
+            __builtin_prefetch(&tbl24_[addresses[idx].ToInteger() >> 8]);
+        }
+        for (auto idx = size_t{ 0 }; idx < kCount ;++idx)
+        {
+            if (idx + kPrefetchDistance < kCount) { __builtin_prefetch(&tbl24_[addresses[idx + kPrefetchDistance].ToInteger() >> 8]); }
+            next_hops[idx] = NextHop(addresses[idx].ToInteger());
+        }
+    }
+
+    size_t PrefixCount() const { return prefix_count_; }
+
+    /**
+     * @brief Returns memory used by the table in bytes.
+     */
+    size_t MemoryUsage() const { return (size(tbl24_) + size(tbl8_)) * sizeof(uint32_t); }
+
+private:
+    uint32_t NextHop(const uint32_t &address) const
+    {
+        const auto kEntry = tbl24_[address >> 8];
+        if (0 == (kEntry & kExtendedBit)) { return kEntry; }
+        return tbl8_[size_t{ kEntry & ~kExtendedBit } * 256 + (address & 0xFF)];
+    }
+
+    std::vector<uint32_t> tbl24_;
+    std::vector<uint32_t> tbl8_;
+    size_t                prefix_count_ = 0;
+};
+
+inline std::optional<IPV4Prefix> IPV4Prefix::FromString(std::string_view line)
+{
+    auto prefix          = IPV4Prefix{};
+    const auto *kEnd     = line.data() + line.size();
+    const auto kAddress  = FromChars(line.data(), kEnd, prefix.address);
+    if (std::errc{} != kAddress.ec || kAddress.ptr == kEnd || '/' != *kAddress.ptr) { return {}; }
+
+    auto length         = 0u;
+    const auto kLength  = std::from_chars(kAddress.ptr + 1, kEnd, length);
+    if (std::errc{} != kLength.ec || length > 32 || kLength.ptr == kEnd || ' ' != *kLength.ptr) { return {}; }
+
+    const auto *current = kLength.ptr;
+    while (current != kEnd && ' ' == *current) { ++current; }
+    const auto kNextHop = std::from_chars(current, kEnd, prefix.next_hop);
+    if (std::errc{} != kNextHop.ec || kNextHop.ptr != kEnd || prefix.next_hop >= IPV4RoutingTable::kNoRoute) { return {}; }
+
+    prefix.length = static_cast<uint8_t>(length);
+    return prefix;
+}
+
+/**
+ * @brief Holds the current IPV4RoutingTable, which readers use while a writer replaces it, see file comments.
+ */
+class ConcurrentIPV4RoutingTable
+{
+    /**
+     * @brief Table a reader is using, on its own cache line so that readers do not share lines.
+     */
+    struct alignas(64) HazardSlot
+    {
+        std::atomic<const IPV4RoutingTable *> table{ nullptr };
+    };
+
+public:
+    /**
+     * @brief A reader of the table, one per reader thread, see file comments.
+     *      A Reader must not outlive the ConcurrentIPV4RoutingTable it was created from.
+     */
+    class Reader
+    {
+    public:
+        explicit Reader(ConcurrentIPV4RoutingTable &owner) : owner_{ &owner }
+        {
+            const auto kLock = std::lock_guard{ owner_->writer_mutex_ };
+            slot_ = owner_->slots_.emplace(end(owner_->slots_));
+        }
+
+        Reader(const Reader &) = delete;
+        Reader& operator=(const Reader &) = delete;
+
+        ~Reader()
+        {
+            const auto kLock = std::lock_guard{ owner_->writer_mutex_ };
+            owner_->slots_.erase(slot_);
+        }
+
+        /**
+         * @brief Returns the current table. A reader should load once and use the returned table for a whole
+         *      batch, so that all addresses of the batch are looked up in the same table. The returned table
+         *      stays valid until the next Load() by this reader, even if it has been replaced meanwhile.
+         *      Never takes a lock. If the table has not changed since the last Load() it only reads the
+         *      current pointer, otherwise it publishes the pointer in its slot and reads it again to check
+         *      that it was not replaced before being published.
+         */
+        const IPV4RoutingTable& Load()
+        {
+            auto *table = owner_->current_.load(std::memory_order_acquire);
+            if (table == slot_->table.load(std::memory_order_relaxed)) { return *table; }
+            for (;;)
+            {
+                slot_->table.store(table, std::memory_order_seq_cst);
+                auto *current = owner_->current_.load(std::memory_order_seq_cst);
+                if (current == table) { return *table; }
+                table = current;
+            }
+        }
+
+    private:
+        ConcurrentIPV4RoutingTable       *owner_ = nullptr;
+        std::list<HazardSlot>::iterator  slot_;
+    };
+
+    explicit ConcurrentIPV4RoutingTable(std::shared_ptr<const IPV4RoutingTable> table)
+        : table_{ std::move(table) }, current_{ table_.get() }
+    {
+    }
+
+    /**
+     * @brief Returns the current table. Takes the writer mutex, readers looking up repeatedly should use a Reader.
+     */
+    std::shared_ptr<const IPV4RoutingTable> Load() const
+    {
+        const auto kLock = std::lock_guard{ writer_mutex_ };
+        return table_;
+    }
+
+    /**
+     * @brief Makes @param table the current table. Readers move to it on their next Load(), lookups which
+     *      already loaded a previous table finish on it. Previous tables no longer used by any reader are freed.
+     */
+    void Store(std::shared_ptr<const IPV4RoutingTable> table)
+    {
+        auto unused = vector_of_tables{};
+        {
+            const auto kLock = std::lock_guard{ writer_mutex_ };
+            current_.store(table.get(), std::memory_order_seq_cst);
+            retired_.push_back(std::exchange(table_, std::move(table)));
+
+            // A table in a slot may still be read, slots are read after publishing so a reader which has not
+            // published a retired table yet will see the new table when it checks again
+            auto kept = vector_of_tables{};
+            for (auto &retired : retired_)
+            {
+                const auto kInUse = std::any_of(begin(slots_), end(slots_), [&retired](const HazardSlot &slot) {
+                    return slot.table.load(std::memory_order_seq_cst) == retired.get();
+                });
+                (kInUse ? kept : unused).push_back(std::move(retired));
+            }
+            retired_ = std::move(kept);
+        }
+        // unused tables are freed here, after the mutex, so that Reader construction does not wait for it
+    }
+
+private:
+    using vector_of_tables = std::vector<std::shared_ptr<const IPV4RoutingTable>>;
+
+    mutable std::mutex                       writer_mutex_; // Held by writers, and when a Reader is created or destroyed
+    std::shared_ptr<const IPV4RoutingTable>  table_;
+    std::atomic<const IPV4RoutingTable *>    current_;
+    vector_of_tables                         retired_;      // Replaced tables which were still in use when last checked
+    std::list<HazardSlot>                    slots_;
+};
+
+#endif // IPV4_ROUTING_TABLE_H
@@ -0,0 +1,403 @@
+/**
+ * @file matrix.h
+ * @author Usama Tayyab (usamatayyab9@gmail.com)
+ * @brief
+ *      This file provides `Matrix<T>`, a runtime sized companion to `Array2D` of 17_2d_array.cpp for
+ *      numeric workloads, and the operations on it.
+ *
+ *      - Matrix<T> has the same interface as Array2D i.e. operator(), At(), Data(), Fill(), Swap(),
+ *        RowCount(), ColumnCount() and iterators, so code written for Array2D compiles with it. Elements
+ *        are stored in row-major order in a single buffer aligned to `kMatrixAlignment`(a cache line).
+ *      - MatrixView<T> is a non-owning view of a matrix or of a submatrix of it. Rows of a view are
+ *        `Stride()` elements apart, so a submatrix is a view with the stride of its parent. All the
+ *        operations below work on views, so they work on submatrices as well.
+ *      - Transpose() copies the matrix in square blocks of `kTransposeBlock` elements, so that both the
+ *        rows being read and the columns being written stay in cache while a block is copied.
+ *      - Map() applies a callable to every element. For arithmetic types the callable is applied to
+ *        `SimdPack<T>`(a GCC vector of 32 bytes) as well, so a generic lambda such as
+ *        [](auto x) { return x * 2 + 1; } processes a whole pack per call and remaining elements one
+ *        at a time.
+ *      - Multiply() computes C = A * B. Rows of C are split into tiles of `kGemmRowBlock` rows, which
+ *        threads take from an atomic counter. For a tile, the depth and columns are blocked so that the
+ *        block of B being used stays in L2 cache, and 4 rows of C are updated together so that every
+ *        pack of B loaded is used 4 times.
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+inline constexpr auto kMatrixAlignment = size_t{ 64 };
+inline constexpr auto kTransposeBlock  = size_t{ 32 };
+inline constexpr auto kGemmRowBlock    = size_t{ 64 };
+inline constexpr auto kGemmDepthBlock  = size_t{ 256 };
+inline constexpr auto kGemmColumnBlock = size_t{ 256 };
+
+/**
+ * @brief Allocator returning memory aligned to @tparam Alignment bytes.
+ */
+template <class T, size_t Alignment = kMatrixAlignment>
+struct AlignedAllocator
+{
+    using value_type = T;
+    template <class U>
+    struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+    AlignedAllocator() = default;
+    template <class U>
+    constexpr AlignedAllocator(const AlignedAllocator<U, Alignment> &) noexcept {}
+
+    T* allocate(const size_t &count)
+    {
+        return static_cast<T *>(::operator new(count * sizeof(T), std::align_val_t{ Alignment }));
+    }
+    void deallocate(T *pointer, const size_t &count)
+    {
+        ::operator delete(pointer, count * sizeof(T), std::align_val_t{ Alignment });
+    }
+
+    friend bool operator==(const AlignedAllocator &, const AlignedAllocator &) { return true; }
+};
+
+/**
+ * @brief Vector of 32 bytes of T, on which arithmetic operators work element wise.
+ */
+template <class T>
+using SimdPack [[gnu::vector_size(32)]] = T;
+
+template <class T>
+inline constexpr auto kSimdPackSize = sizeof(SimdPack<T>) / sizeof(T);
+
+template <class T>
+SimdPack<T> LoadPack(const T *source)
+{
+    auto pack = SimdPack<T>{};
+    std::memcpy(&pack, source, sizeof(pack));
+    return pack;
+}
+
+template <class T, class Pack>
+void StorePack(T *destination, const Pack &pack)
+{
+    static_assert(sizeof(Pack) == sizeof(SimdPack<T>));
+    std::memcpy(destination, &pack, sizeof(pack));
+}
+
+/**
+ * @brief Non-owning view of a matrix, see file comments. @tparam T is const for a read-only view.
+ */
+template <class T>
+class MatrixView
+{
+public:
+    using value_type = std::remove_const_t<T>;
+    using pointer    = T*;
+    using reference  = T&;
+
+    constexpr MatrixView() = default;
+    constexpr MatrixView(pointer data, const size_t &rows, const size_t &columns, const size_t &stride) :
+        data_{ data }, rows_{ rows }, columns_{ columns }, stride_{ stride }
+    {
+    }
+    /**
+     * @brief A view of non-const elements converts to a view of const elements.
+     */
+    template <class U> requires std::is_same_v<const U, T>
+    constexpr MatrixView(const MatrixView<U> &view) :
+        MatrixView{ view.Data(), view.RowCount(), view.ColumnCount(), view.Stride() }
+    {
+    }
+
+    constexpr reference operator()(const size_t &r_idx, const size_t &c_idx) const
+    {
+        return data_[r_idx * stride_ + c_idx];
+    }
+    constexpr reference At(const size_t &r_idx, const size_t &c_idx) const
+    {
+        if (r_idx >= rows_ || c_idx >= columns_) { throw std::out_of_range{ "MatrixView::At() index out of range" }; }
+        return (*this)(r_idx, c_idx);
+    }
+
+    constexpr pointer Data() const               { return data_; }
+    constexpr pointer Row(const size_t &r_idx) const { return data_ + r_idx * stride_; }
+    constexpr size_t RowCount()    const { return rows_;    }
+    constexpr size_t ColumnCount() const { return columns_; }
+    constexpr size_t Stride()      const { return stride_;  }
+
+    /**
+     * @brief Returns view of @param rows x @param columns elements starting at (@param r_idx, @param c_idx).
+     */
+    constexpr MatrixView SubView(const size_t &r_idx, const size_t &c_idx, const size_t &rows, const size_t &columns) const
+    {
+        if (r_idx + rows > rows_ || c_idx + columns > columns_) { throw std::out_of_range{ "MatrixView::SubView() out of range" }; }
+        return MatrixView{ Row(r_idx) + c_idx, rows, columns, stride_ };
+    }
+
+private:
+    pointer data_    = nullptr;
+    size_t  rows_    = 0;
+    size_t  columns_ = 0;
+    size_t  stride_  = 0;
+};
+
+template <class T>
+class Matrix
+{
+public:
+    using value_type        = T;
+    using size_type         = std::size_t;
+    using difference_type   = std::ptrdiff_t;
+    using reference         = value_type&;
+    using const_reference   = const value_type&;
+    using pointer           = value_type*;
+    using const_pointer     = const value_type*;
+    using iterator          = value_type*;
+    using const_iterator    = const value_type*;
+
+    Matrix() = default;
+    Matrix(const size_t &rows, const size_t &columns, const value_type &value = value_type{}) :
+        rows_{ rows }, columns_{ columns }, arr(rows * columns, value)
+    {
+    }
+    /**
+     * @brief Constructs a matrix from @param values in row-major order, remaining elements are value initialized.
+     */
+    Matrix(const size_t &rows, const size_t &columns, std::initializer_list<value_type> values) : Matrix(rows, columns)
+    {
+        if (size(values) > size(arr)) { throw std::length_error{ "Matrix has fewer elements than the values" }; }
+        std::copy(values.begin(), values.end(), arr.begin());
+    }
+
+    value_type& At(const size_t &r_idx, const size_t &c_idx)
+    {
+        return View().At(r_idx, c_idx);
+    }
+    const value_type& At(const size_t &r_idx, const size_t &c_idx) const
+    {
+        return View().At(r_idx, c_idx);
+    }
+    value_type& operator()(const size_t &r_idx, const size_t &c_idx)
+    {
+        return arr[r_idx * columns_ + c_idx];
+    }
+    const value_type& operator()(const size_t &r_idx, const size_t &c_idx) const
+    {
+        return arr[r_idx * columns_ + c_idx];
+    }
+
+    pointer       Data()       { return arr.data(); }
+    const_pointer Data() const { return arr.data(); }
+
+    void Fill(const value_type &arg)
+    {
+        std::fill(arr.begin(), arr.end(), arg);
+    }
+
+    void Swap(Matrix<T> &arg)
+    {
+        if (this != &arg)
+        {
+            arr.swap(arg.arr);
+            std::swap(rows_, arg.rows_);
+            std::swap(columns_, arg.columns_);
+        }
+    }
+
+    size_t RowCount()    const { return rows_;    }
+    size_t ColumnCount() const { return columns_; }
+
+    MatrixView<T>       View()       { return { arr.data(), rows_, columns_, columns_ }; }
+    MatrixView<const T> View() const { return { arr.data(), rows_, columns_, columns_ }; }
+    MatrixView<T>       SubMatrix(const size_t &r_idx, const size_t &c_idx, const size_t &rows, const size_t &columns)
+    {
+        return View().SubView(r_idx, c_idx, rows, columns);
+    }
+    MatrixView<const T> SubMatrix(const size_t &r_idx, const size_t &c_idx, const size_t &rows, const size_t &columns) const
+    {
+        return View().SubView(r_idx, c_idx, rows, columns);
+    }
+
+    iterator       begin()        { return arr.data();              }
+    const_iterator begin()  const { return arr.data();              }
+    const_iterator cbegin() const { return arr.data();              }
+
+    iterator       end()        { return arr.data() + std::size(arr); }
+    const_iterator end()  const { return arr.data() + std::size(arr); }
+    const_iterator cend() const { return arr.data() + std::size(arr); }
+
+private:
+    size_t rows_    = 0;
+    size_t columns_ = 0;
+    std::vector<T, AlignedAllocator<T>> arr;
+};
+
+/**
+ * @brief Writes transpose of @param source into @param destination, which must have as many rows as
+ *      @param source has columns and vice versa. The views must not overlap.
+ */
+template <class T>
+void Transpose(std::type_identity_t<MatrixView<const T>> source, MatrixView<T> destination)
+{
+    if (source.RowCount() != destination.ColumnCount() || source.ColumnCount() != destination.RowCount())
+    {
+        throw std::invalid_argument{ "Transpose() dimensions mismatch" };
+    }
+    for (auto r_block = size_t{ 0 }; r_block < source.RowCount() ;r_block += kTransposeBlock)
+    {
+        const auto kRowEnd = std::min(r_block + kTransposeBlock, source.RowCount());
+        for (auto c_block = size_t{ 0 }; c_block < source.ColumnCount() ;c_block += kTransposeBlock)
+        {
+            const auto kColumnEnd = std::min(c_block + kTransposeBlock, source.ColumnCount());
+            for (auto r_idx = r_block; r_idx < kRowEnd ;++r_idx)
+            {
+                const auto *kRow = source.Row(r_idx);
+                for (auto c_idx = c_block; c_idx < kColumnEnd ;++c_idx) { destination(c_idx, r_idx) = kRow[c_idx]; }
+            }
+        }
+    }
+}
+
+template <class T>
+Matrix<T> Transposed(const Matrix<T> &matrix)
+{
+    auto result = Matrix<T>(matrix.ColumnCount(), matrix.RowCount());
+    Transpose(matrix.View(), result.View());
+    return result;
+}
+
+/**
+ * @brief Writes @param op(x) into @param destination for every element x of @param source, see file
+ *      comments. The views must have the same dimensions, and may be the same view.
+ *      Like Transpose() and Multiply(), T is deduced from @param destination so that a view of
+ *      non-const elements can be passed as @param source.
+ */
+template <class T, class Op>
+void Map(std::type_identity_t<MatrixView<const T>> source, MatrixView<T> destination, Op op)
+{
+    if (source.RowCount() != destination.RowCount() || source.ColumnCount() != destination.ColumnCount())
+    {
+        throw std::invalid_argument{ "Map() dimensions mismatch" };
+    }
+    for (auto r_idx = size_t{ 0 }; r_idx < source.RowCount() ;++r_idx)
+    {
+        const auto *kSource = source.Row(r_idx);
+        auto *destination_row = destination.Row(r_idx);
+        auto c_idx = size_t{ 0 };
+        if constexpr (std::is_arithmetic_v<T>)
+        {
+            for (; c_idx + kSimdPackSize<T> <= source.ColumnCount() ;c_idx += kSimdPackSize<T>)
+            {
+                StorePack(destination_row + c_idx, op(LoadPack(kSource + c_idx)));
+            }
+        }
+        for (; c_idx < source.ColumnCount() ;++c_idx) { destination_row[c_idx] = op(kSource[c_idx]); }
+    }
+}
+
+/**
+ * @brief Adds product of rows [@param r_first, @param r_last) and columns [@param k_first, @param k_last) of
+ *      @param a with rows [@param k_first, @param k_last) and columns [@param c_first, @param c_last) of @param b
+ *      to the corresponding elements of @param c.
+ */
+template <class T>
+void MultiplyBlock(MatrixView<const T> a, MatrixView<const T> b, MatrixView<T> c, size_t r_idx, const size_t &r_last,
+                   const size_t &k_first, const size_t &k_last, const size_t &c_first, const size_t &c_last)
+{
+    constexpr auto kPack = kSimdPackSize<T>;
+    for (; r_idx + 4 <= r_last ;r_idx += 4)
+    {
+        T *c0 = c.Row(r_idx), *c1 = c.Row(r_idx + 1), *c2 = c.Row(r_idx + 2), *c3 = c.Row(r_idx + 3);
+        for (auto k_idx = k_first; k_idx < k_last ;++k_idx)
+        {
+            const auto a0 = a(r_idx, k_idx), a1 = a(r_idx + 1, k_idx), a2 = a(r_idx + 2, k_idx), a3 = a(r_idx + 3, k_idx);
+            const auto *kB = b.Row(k_idx);
+            auto c_idx = c_first;
+            for (; c_idx + kPack <= c_last ;c_idx += kPack)
+            {
+                const auto kPackB = LoadPack(kB + c_idx);
+                StorePack(c0 + c_idx, LoadPack(c0 + c_idx) + a0 * kPackB);
+                StorePack(c1 + c_idx, LoadPack(c1 + c_idx) + a1 * kPackB);
+                StorePack(c2 + c_idx, LoadPack(c2 + c_idx) + a2 * kPackB);
+                StorePack(c3 + c_idx, LoadPack(c3 + c_idx) + a3 * kPackB);
+            }
+            for (; c_idx < c_last ;++c_idx)
+            {
+                c0[c_idx] += a0 * kB[c_idx];
+                c1[c_idx] += a1 * kB[c_idx];
+                c2[c_idx] += a2 * kB[c_idx];
+                c3[c_idx] += a3 * kB[c_idx];
+            }
+        }
+    }
+    for (; r_idx < r_last ;++r_idx)
+    {
+        auto *c_row = c.Row(r_idx);
+        for (auto k_idx = k_first; k_idx < k_last ;++k_idx)
+        {
+            const auto kA  = a(r_idx, k_idx);
+            const auto *kB = b.Row(k_idx);
+            for (auto c_idx = c_first; c_idx < c_last ;++c_idx) { c_row[c_idx] += kA * kB[c_idx]; }
+        }
+    }
+}
+
+/**
+ * @brief Writes @param a * @param b into @param c using @param thread_count threads, see file comments.
+ *      @param c must not overlap with @param a or @param b.
+ */
+template <class T>
+void Multiply(std::type_identity_t<MatrixView<const T>> a, std::type_identity_t<MatrixView<const T>> b, MatrixView<T> c,
+              const size_t &thread_count = std::max(1u, std::thread::hardware_concurrency()))
+{
+    if (a.ColumnCount() != b.RowCount() || a.RowCount() != c.RowCount() || b.ColumnCount() != c.ColumnCount())
+    {
+        throw std::invalid_argument{ "Multiply() dimensions mismatch" };
+    }
+    const auto kTileCount = (c.RowCount() + kGemmRowBlock - 1) / kGemmRowBlock;
+    auto next_tile        = std::atomic<size_t>{ 0 };
+    const auto kWorker    = [&]()
+    {
+        for (auto tile = next_tile++; tile < kTileCount ;tile = next_tile++)
+        {
+            const auto kRowFirst = tile * kGemmRowBlock;
+            const auto kRowLast  = std::min(kRowFirst + kGemmRowBlock, c.RowCount());
+            for (auto r_idx = kRowFirst; r_idx < kRowLast ;++r_idx) { std::fill_n(c.Row(r_idx), c.ColumnCount(), T{}); }
+
+            for (auto k_idx = size_t{ 0 }; k_idx < a.ColumnCount() ;k_idx += kGemmDepthBlock)
+            {
+                for (auto c_idx = size_t{ 0 }; c_idx < c.ColumnCount() ;c_idx += kGemmColumnBlock)
+                {
+                    MultiplyBlock(a, b, c, kRowFirst, kRowLast, k_idx, std::min(k_idx + kGemmDepthBlock, a.ColumnCount()),
+                                  c_idx, std::min(c_idx + kGemmColumnBlock, c.ColumnCount()));
+                }
+            }
+        }
+    };
+
+    auto threads = std::vector<std::thread>{};
+    for (auto idx = size_t{ 1 }; idx < std::min(thread_count, kTileCount) ;++idx) { threads.emplace_back(kWorker); }
+    kWorker();
+    for (auto &thread : threads) { thread.join(); }
+}
+
+template <class T>
+Matrix<T> operator*(const Matrix<T> &a, const Matrix<T> &b)
+{
+    auto result = Matrix<T>(a.RowCount(), b.ColumnCount());
+    Multiply(a.View(), b.View(), result.View());
+    return result;
+}
+
+#endif // MATRIX_H
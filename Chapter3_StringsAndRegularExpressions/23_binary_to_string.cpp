@@ -2,7 +2,7 @@
  * @file 23_binary_to_string.cpp
  * @author Usama Tayyab (usamatayyab9@gmail.com)
  * @brief 
- *  Compilation command : g++ -std=c++17 23_binary_to_string.cpp
+ *  Compilation command : g++ -std=c++20 -O2 -mavx2 23_binary_to_string.cpp
  *  This file is solution to "Problem 23.  Binary to string conversion"
  *  mentioned in "Chapter 3: Strings and Regular Expressions" of the book:
  *  - The Modern C++ Challenge by Marius Bancilla (available at amazon https://www.amazon.com/Modern-Challenge-programmer-real-world-problems/dp/1788993861)
@@ -20,33 +20,150 @@
  * 1. BytesToString() which takes a container and bool flag for uppercase as input and returns a string.
  * 2. BytesToStringFold() which takes a bool flag for determining whether output characters should be in
  *      uppercase or lowercase and Bytes which has to be converted to string.
+ * Both are wrappers of HexEncode(), which writes hex of a span of bytes into a caller provided buffer
+ * without any allocation. Every byte is split into its high and low nibble, and each nibble is converted
+ * to a character by looking it up in a 16 entry table of the hex digits in requested case. With SSSE3 the
+ * lookup is a single _mm_shuffle_epi8 for 16 nibbles, and the characters of high and low nibbles are then
+ * interleaved, so 16 bytes(32 with AVX2) are encoded per iteration.
+ * HexEncodeStream() and HexEncodeFile() encode an input stream or file in chunks of `kHexStreamChunk`
+ * bytes, reusing the same buffers for every chunk.
  * 
  * Driver code:
  * The program first initializes two different containers of different bytes, converts them to string
  * in lowercase and uppercase, prints the string on console.
  * Secondly, uses BytesToStringFold() funtion for converting diffetent characters to string.
+ * Then HexEncode() is checked against snprintf() for all lengths upto 100 and both cases, and the file
+ * encoder is checked against HexEncode(). Lastly time taken for encoding `kBenchmarkSize` bytes using a
+ * stringstream(as the functions above did before) and using HexEncode() is printed.
  * 
  * @copyright Copyright (c) 2023
  */
 #include <iostream>
+#include <fstream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <array>
+#include <span>
 #include <sstream>
 #include <iomanip>
+#include <iterator>
 #include <type_traits>
+#include <filesystem>
+#include <random>
+#include <chrono>
+#include <cassert>
+#include <cstdio>
+
+#if defined(__AVX2__) || defined(__SSSE3__)
+#include <immintrin.h>
+#endif
 
 using std::array;
 using std::cin;
 using std::cout;
 using std::endl;
 using std::byte;
+using std::istream;
 using std::ostream;
 using std::setfill;
 using std::setw;
+using std::span;
 using std::string;
+using std::string_view;
 using std::stringstream;
 using std::vector;
+using std::chrono::steady_clock;
+using std::chrono::duration;
+
+inline constexpr auto kHexStreamChunk = size_t{ 64 } << 10;
+inline constexpr auto kBenchmarkSize  = size_t{ 64 } << 20;
+
+inline constexpr auto kLowercaseHexDigits = string_view{ "0123456789abcdef" };
+inline constexpr auto kUppercaseHexDigits = string_view{ "0123456789ABCDEF" };
+
+/**
+ * @brief Writes hex of @param bytes into @param output, two characters per byte, see file comments.
+ *      If @param output is too small only the bytes which fit are encoded.
+ * 
+ * @return size_t - number of characters written
+ */
+size_t HexEncode(span<const unsigned char> bytes, span<char> output, const bool &is_uppercase)
+{
+    const auto kDigits = is_uppercase ? kUppercaseHexDigits : kLowercaseHexDigits;
+    const auto kCount  = std::min(bytes.size(), output.size() / 2);
+    const auto *source = bytes.data();
+    auto *destination  = output.data();
+    auto idx           = size_t{ 0 };
+#if defined(__AVX2__)
+    const auto kTable256 = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(kDigits.data())));
+    const auto kMask256  = _mm256_set1_epi8(0x0F);
+    for (; idx + 32 <= kCount ;idx += 32)
+    {
+        const auto kBytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + idx));
+        const auto kHigh  = _mm256_shuffle_epi8(kTable256, _mm256_and_si256(_mm256_srli_epi16(kBytes, 4), kMask256));
+        const auto kLow   = _mm256_shuffle_epi8(kTable256, _mm256_and_si256(kBytes, kMask256));
+        // Unpacks work within 128-bit lanes, so they give bytes 0-7 and 16-23, and bytes 8-15 and 24-31
+        const auto kFirst  = _mm256_unpacklo_epi8(kHigh, kLow);
+        const auto kSecond = _mm256_unpackhi_epi8(kHigh, kLow);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(destination + 2 * idx), _mm256_permute2x128_si256(kFirst, kSecond, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(destination + 2 * idx + 32), _mm256_permute2x128_si256(kFirst, kSecond, 0x31));
+    }
+#endif
+#if defined(__SSSE3__)
+    const auto kTable = _mm_loadu_si128(reinterpret_cast<const __m128i *>(kDigits.data()));
+    const auto kMask  = _mm_set1_epi8(0x0F);
+    for (; idx + 16 <= kCount ;idx += 16)
+    {
+        const auto kBytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + idx));
+        const auto kHigh  = _mm_shuffle_epi8(kTable, _mm_and_si128(_mm_srli_epi16(kBytes, 4), kMask));
+        const auto kLow   = _mm_shuffle_epi8(kTable, _mm_and_si128(kBytes, kMask));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + 2 * idx), _mm_unpacklo_epi8(kHigh, kLow));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + 2 * idx + 16), _mm_unpackhi_epi8(kHigh, kLow));
+    }
+#endif
+    for (; idx < kCount ;++idx)
+    {
+        destination[2 * idx]     = kDigits[source[idx] >> 4];
+        destination[2 * idx + 1] = kDigits[source[idx] & 0x0F];
+    }
+    return 2 * kCount;
+}
+
+/**
+ * @brief Writes hex of all bytes of @param in to @param out, in chunks of kHexStreamChunk bytes.
+ * 
+ * @return size_t - number of bytes encoded
+ */
+size_t HexEncodeStream(istream &in, ostream &out, const bool &is_uppercase)
+{
+    auto bytes  = vector<unsigned char>(kHexStreamChunk);
+    auto output = vector<char>(2 * kHexStreamChunk);
+    auto total  = size_t{ 0 };
+    while (in)
+    {
+        in.read(reinterpret_cast<char *>(bytes.data()), static_cast<std::streamsize>(size(bytes)));
+        const auto kCount = static_cast<size_t>(in.gcount());
+        out.write(output.data(), static_cast<std::streamsize>(HexEncode(span{ bytes }.first(kCount), output, is_uppercase)));
+        total += kCount;
+    }
+    return total;
+}
+
+/**
+ * @brief Writes hex of the file @param input_path to the file @param output_path.
+ * 
+ * @return bool - false if either file can not be opened or writing failed
+ */
+bool HexEncodeFile(const string &input_path, const string &output_path, const bool &is_uppercase)
+{
+    auto in  = std::ifstream{ input_path, std::ios::binary };
+    auto out = std::ofstream{ output_path, std::ios::binary };
+    if (!in || !out) { return false; }
+
+    HexEncodeStream(in, out, is_uppercase);
+    return static_cast<bool>(out.flush());
+}
 
 /**
  * @brief converts elements of container into string such that each element is a byte
@@ -59,13 +176,22 @@ using std::vector;
 template <class Container>
 string BytesToString(const Container &c, const bool &is_uppercase)
 {
-    auto ss = stringstream{};
-    if (is_uppercase) { ss.setf(std::ios_base::uppercase); }
-    for (const auto &value : c)
+    using ValueType = std::remove_cvref_t<decltype(*std::cbegin(c))>;
+    auto result     = string(2 * static_cast<size_t>(std::distance(std::cbegin(c), std::cend(c))), '\0');
+    if constexpr (std::contiguous_iterator<decltype(std::cbegin(c))> && 1 == sizeof(ValueType))
     {
-        ss << setw(2) << setfill('0') << std::hex << static_cast<int>(value);
+        HexEncode(span{ reinterpret_cast<const unsigned char *>(std::data(c)), std::size(c) }, result, is_uppercase);
     }
-    return ss.str();
+    else
+    {
+        auto idx = size_t{ 0 };
+        for (const auto &value : c)
+        {
+            const auto kByte = array<unsigned char, 1>{ static_cast<unsigned char>(value) };
+            idx += HexEncode(kByte, span{ result }.subspan(idx), is_uppercase);
+        }
+    }
+    return result;
 }
 
 /**
@@ -79,10 +205,8 @@ string BytesToString(const Container &c, const bool &is_uppercase)
 template <typename ...Bytes>
 string BytesToStringFold(const bool &is_uppercase, Bytes... args)
 {
-    auto sstream = stringstream{};
-    if (is_uppercase) { sstream.setf(std::ios_base::uppercase); }
-    (sstream << setw(2) << setfill('0') << std::hex  << static_cast<int>(args), ...);
-    return sstream.str();
+    const auto kBytes = array<unsigned char, sizeof...(Bytes)>{ static_cast<unsigned char>(args)... };
+    return BytesToString(kBytes, is_uppercase);
 }
 
 int main()
@@ -97,6 +221,50 @@ int main()
 
     cout << BytesToStringFold(true, byte{ 0xBA }, byte{ 0xAD }, byte{ 0xF0 }, byte{ 0x0D }) << '\n';
     cout << BytesToStringFold(false, byte{ 0xBA }, byte{ 0xAD }, byte{ 0xF0 }, byte{ 0x0D }) << '\n';
+
+    assert("010203040506" == BytesToString(vector<int>{ 1, 2, 3, 4, 5, 6 }, false));
+
+    auto random_engine = std::mt19937{ 23 };
+    auto bytes         = vector<unsigned char>(kBenchmarkSize);
+    for (auto &value : bytes) { value = static_cast<unsigned char>(random_engine()); }
+    for (const auto &kUppercase : { false, true })
+    {
+        for (auto length = size_t{ 0 }; length <= 100 ;++length)
+        {
+            auto expected = string{};
+            for (auto idx = size_t{ 0 }; idx < length ;++idx)
+            {
+                auto digits = array<char, 3>{};
+                std::snprintf(digits.data(), size(digits), kUppercase ? "%02X" : "%02x", bytes[idx]);
+                expected += digits.data();
+            }
+            assert(expected == BytesToString(span{ bytes }.first(length), kUppercase));
+        }
+    }
+
+    const auto kInputPath  = (std::filesystem::temp_directory_path() / "23_binary_to_string.bin").string();
+    const auto kOutputPath = (std::filesystem::temp_directory_path() / "23_binary_to_string.txt").string();
+    const auto kFileSize   = 3 * kHexStreamChunk + 5;
+    std::ofstream{ kInputPath, std::ios::binary }.write(reinterpret_cast<const char *>(bytes.data()), kFileSize);
+    assert(HexEncodeFile(kInputPath, kOutputPath, true));
+    auto encoded_file = stringstream{};
+    encoded_file << std::ifstream{ kOutputPath, std::ios::binary }.rdbuf();
+    assert(encoded_file.str() == BytesToString(span{ bytes }.first(kFileSize), true));
+    std::filesystem::remove(kInputPath);
+    std::filesystem::remove(kOutputPath);
+
+    // Same formatting as BytesToString() used before, on a 16th of the data since it is much slower
+    auto start_timepoint = steady_clock::now();
+    auto ss              = stringstream{};
+    for (auto idx = size_t{ 0 }; idx < kBenchmarkSize / 16 ;++idx) { ss << setw(2) << setfill('0') << std::hex << static_cast<int>(bytes[idx]); }
+    const auto kStreamSeconds = duration<double>(steady_clock::now() - start_timepoint).count() * 16;
+    cout << "stringstream: " << (kBenchmarkSize >> 20) / kStreamSeconds << " MB/s" << endl;
+
+    auto output     = vector<char>(2 * kBenchmarkSize);
+    start_timepoint = steady_clock::now();
+    HexEncode(bytes, output, false);
+    cout << "HexEncode(): " << (kBenchmarkSize >> 20) / duration<double>(steady_clock::now() - start_timepoint).count() << " MB/s" << endl;
+    assert(ss.str() == string_view(output.data(), kBenchmarkSize / 8));
     
     return 0;
 }
\ No newline at end of file
@@ -2,7 +2,7 @@
  * @file 24_string_to_binary.cpp
  * @author Usama Tayyab (usamatayyab9@gmail.com)
  * @brief 
- *  Compilation command : g++ -std=c++17 24_string_to_binary.cpp
+ *  Compilation command : g++ -std=c++20 -O2 -mavx2 24_string_to_binary.cpp
  *  This file is solution to "Problem 24.   String to binary conversion"
  *  mentioned in "Chapter 3: Strings and Regular Expressions" of the book:
  *  - The Modern C++ Challenge by Marius Bancilla (available at amazon https://www.amazon.com/Modern-Challenge-programmer-real-world-problems/dp/1788993861)
@@ -20,9 +20,24 @@
  *      string which contains only alpha numeric characters from argument.
  * 3. StringToBinary() which takes a string as input and converts it to binary.
  * 
+ * StringToBinary() is a wrapper of `HexDecoder`, which decodes hex into a caller provided span without any
+ * allocation. Hex digits may be separated by any characters other than letters and digits, such as spaces,
+ * ':' or new lines, and the other letters(g to z) are reported as invalid. Decoding is done in blocks of
+ * `kHexDecodeBlock` characters in two steps:
+ * 1. With SSSE3, 16 characters are classified at a time into digits, hex letters and invalid letters using
+ *      unsigned range comparisons, and converted to nibble values. Nibbles of the hex characters are moved
+ *      together(left packed) by a _mm_shuffle_epi8 for each 8 characters, whose shuffle mask is looked up by
+ *      the 8-bit mask of hex characters in `kLeftPackShuffles`, and stored into a buffer on stack.
+ * 2. Pairs of nibbles are combined into bytes 16 at a time using _mm_maddubs_epi16 with weights 16 and 1.
+ * A nibble left over at the end of a block or chunk is kept by the decoder for the next one, so the input
+ * can be decoded in chunks of any size, see HexDecodeStream().
+ * 
  * Driver code:
  * The program first initializes a string then converts it into binary and
  * prints the binary into required format.
+ * Then HexDecoder is checked against a straightforward decoder on random hex with random separators, in
+ * random chunk sizes, along with invalid characters and small output buffers. Lastly time taken for decoding
+ * `kBenchmarkSize` bytes written as plain hex and as "xx xx xx" lines is printed.
  * 
  * @copyright Copyright (c) 2023
  */
@@ -31,35 +46,100 @@
 #include <string>
 #include <string_view>
 #include <vector>
+#include <array>
+#include <span>
+#include <optional>
 #include <algorithm>
 #include <iterator>
 #include <iomanip>
+#include <sstream>
+#include <bit>
+#include <random>
+#include <chrono>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSSE3__)
+#include <immintrin.h>
+#endif
 
+using std::array;
 using std::back_inserter;
 using std::cin;
 using std::copy;
 using std::copy_if;
 using std::cout;
 using std::endl;
+using std::istream;
+using std::optional;
+using std::ostream;
 using std::ostream_iterator;
 using std::quoted;
+using std::span;
 using std::string;
 using std::string_view;
 using std::vector;
+using std::chrono::steady_clock;
+using std::chrono::duration;
+
+inline constexpr auto kHexDecodeBlock = size_t{ 4096 };
+inline constexpr auto kHexStreamChunk = size_t{ 64 } << 10;
+inline constexpr auto kBenchmarkSize  = size_t{ 32 } << 20;
+
+/**
+ * @brief Value of every character as a hex digit, `kNotHex` for separators and `kInvalidHex` for other letters.
+ */
+inline constexpr auto kNotHex     = uint8_t{ 0xFE };
+inline constexpr auto kInvalidHex = uint8_t{ 0xFF };
+inline constexpr auto kHexValues  = []()
+{
+    auto values = array<uint8_t, 256>{};
+    for (auto ch = 0; ch < 256 ;++ch)
+    {
+        if      (ch >= '0' && ch <= '9') { values[ch] = static_cast<uint8_t>(ch - '0'); }
+        else if (ch >= 'A' && ch <= 'F') { values[ch] = static_cast<uint8_t>(10 + ch - 'A'); }
+        else if (ch >= 'a' && ch <= 'f') { values[ch] = static_cast<uint8_t>(10 + ch - 'a'); }
+        else if ((ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z')) { values[ch] = kInvalidHex; }
+        else { values[ch] = kNotHex; }
+    }
+    return values;
+}();
+
+#if defined(__SSSE3__)
+/**
+ * @brief Shuffle masks which move the bytes whose bits are set in the index to the front, in order.
+ */
+inline constexpr auto kLeftPackShuffles = []()
+{
+    auto shuffles = array<uint64_t, 256>{};
+    for (auto mask = 0; mask < 256 ;++mask)
+    {
+        auto shuffle  = uint64_t{ 0 };
+        auto position = 0;
+        for (auto bit = 0; bit < 8 ;++bit)
+        {
+            if (mask & (1 << bit)) { shuffle |= uint64_t(bit) << (8 * position++); }
+        }
+        for (; position < 8 ;++position) { shuffle |= uint64_t{ 0x80 } << (8 * position); }
+        shuffles[mask] = shuffle;
+    }
+    return shuffles;
+}();
+#endif
 
 /**
  * @brief Converts @param ch1 and @param ch2 to Hex
  * 
  * @param ch1 
  * @param ch2 
- * @return unsigned char 
+ * @return unsigned char - an invalid character is taken as 0
  */
 unsigned char HexToInt(const char &ch1, const char &ch2)
 {
-    auto HexCode = [](const char &ch){
-        if (ch >= '0' && ch <= '9') { return ch - '0';      }
-        if (ch >= 'A' && ch <= 'Z') { return 10 + ch - 'A'; }
-        if (ch >= 'a' && ch <= 'z') { return 10 + ch - 'a'; }
+    auto HexCode = [](const char &ch) {
+        const auto kValue = kHexValues[static_cast<unsigned char>(ch)];
+        return (kValue < 16) ? kValue : 0;
     };
     return HexCode(ch1) * 16 + HexCode(ch2);
 }
@@ -74,42 +154,204 @@ string ExtractAlphaNumericCharacters(string_view str_input)
 {
     auto str = string{};
     copy_if(cbegin(str_input), cend(str_input), back_inserter(str), [](const auto &ch) {
-        return isalnum(ch);
+        return isalnum(static_cast<unsigned char>(ch));
     });
     return str;    
 }
 
+struct HexDecodeResult
+{
+    size_t           consumed = 0;  // number of characters of input processed
+    size_t           written  = 0;  // number of bytes written to output
+    optional<size_t> invalid_offset;// offset of the first invalid character in input, if any
+};
+
+/**
+ * @brief Hex decoder which can be fed input in chunks, see file comments.
+ */
+class HexDecoder
+{
+public:
+    HexDecoder() = default;
+    /**
+     * @brief Constructs a decoder which takes @param pending_nibble as the high nibble of the first byte.
+     */
+    explicit HexDecoder(const uint8_t &pending_nibble) : pending{ pending_nibble } {}
+
+    /**
+     * @brief Decodes @param input into @param output. Decoding stops at the first invalid character, or when
+     *      @param output is full, so `consumed` of the result tells where to continue from.
+     */
+    HexDecodeResult Decode(string_view input, span<unsigned char> output)
+    {
+        auto result = HexDecodeResult{};
+        auto nibbles = array<uint8_t, kHexDecodeBlock + 32>{};
+        while (result.consumed < input.size() && !result.invalid_offset)
+        {
+            // Limit the block so that all nibbles staged from it fit in the output, except a pending one
+            const auto kPending   = pending ? size_t{ 1 } : size_t{ 0 };
+            const auto kMaxLength = 2 * (output.size() - result.written) + 1 - kPending;
+            const auto kLength    = std::min({ kHexDecodeBlock, input.size() - result.consumed, kMaxLength });
+            if (0 == kLength) { break; }
+
+            auto count = kPending;
+            if (pending) { nibbles[0] = *pending; }
+            auto invalid = optional<size_t>{};
+            const auto kProcessed = StageNibbles(input.data() + result.consumed, kLength, nibbles.data(), count, invalid);
+
+            const auto kBytes = count / 2;
+            CombineNibbles(nibbles.data(), kBytes, output.data() + result.written);
+            pending = (count % 2) ? optional<uint8_t>{ nibbles[count - 1] } : optional<uint8_t>{};
+
+            if (invalid) { result.invalid_offset = result.consumed + *invalid; }
+            result.written  += kBytes;
+            result.consumed += kProcessed;
+        }
+        return result;
+    }
+
+    /**
+     * @brief Returns true if the input so far had an odd number of hex digits.
+     */
+    bool HasPendingNibble() const { return pending.has_value(); }
+
+private:
+    /**
+     * @brief Appends nibble values of hex characters of [@param input, @param input + @param length) to
+     *      @param nibbles at @param count, stopping at the first invalid character whose offset is set in @param invalid.
+     * @return number of characters processed
+     */
+    static size_t StageNibbles(const char *input, const size_t &length, uint8_t *nibbles, size_t &count, optional<size_t> &invalid)
+    {
+        auto idx = size_t{ 0 };
+#if defined(__SSSE3__)
+        for (; idx + 16 <= length ;idx += 16)
+        {
+            const auto kChars   = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + idx));
+            const auto kDigit   = _mm_sub_epi8(kChars, _mm_set1_epi8('0'));
+            const auto kLetter  = _mm_sub_epi8(_mm_or_si128(kChars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+            const auto kIsDigit = _mm_cmpeq_epi8(_mm_min_epu8(kDigit, _mm_set1_epi8(9)), kDigit);
+            const auto kIsHex   = _mm_cmpeq_epi8(_mm_min_epu8(kLetter, _mm_set1_epi8(5)), kLetter);
+            const auto kIsAlpha = _mm_cmpeq_epi8(_mm_min_epu8(kLetter, _mm_set1_epi8(25)), kLetter);
+            if (0 != _mm_movemask_epi8(_mm_andnot_si128(kIsHex, kIsAlpha))) { break; } // exact position found below
+
+            const auto kValues = _mm_or_si128(_mm_and_si128(kIsDigit, kDigit), _mm_and_si128(kIsHex, _mm_add_epi8(kLetter, _mm_set1_epi8(10))));
+            const auto kMask   = static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(kIsDigit, kIsHex)));
+            if (0xFFFF == kMask)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(nibbles + count), kValues);
+                count += 16;
+                continue;
+            }
+            const auto kLow     = kMask & 0xFF;
+            const auto kHigh    = kMask >> 8;
+            const auto kShuffle = _mm_set_epi64x(static_cast<int64_t>(kLeftPackShuffles[kHigh] + 0x0808080808080808ull),
+                                                 static_cast<int64_t>(kLeftPackShuffles[kLow]));
+            const auto kPacked  = _mm_shuffle_epi8(kValues, kShuffle);
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(nibbles + count), kPacked);
+            count += std::popcount(kLow);
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(nibbles + count), _mm_srli_si128(kPacked, 8));
+            count += std::popcount(kHigh);
+        }
+#endif
+        for (; idx < length ;++idx)
+        {
+            const auto kValue = kHexValues[static_cast<unsigned char>(input[idx])];
+            if (kInvalidHex == kValue)
+            {
+                invalid = idx;
+                return idx;
+            }
+            if (kNotHex != kValue) { nibbles[count++] = kValue; }
+        }
+        return idx;
+    }
+
+    /**
+     * @brief Writes @param byte_count bytes to @param output from pairs of @param nibbles.
+     */
+    static void CombineNibbles(const uint8_t *nibbles, const size_t &byte_count, unsigned char *output)
+    {
+        auto idx = size_t{ 0 };
+#if defined(__SSSE3__)
+        for (; idx + 8 <= byte_count ;idx += 8)
+        {
+            const auto kPairs = _mm_maddubs_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(nibbles + 2 * idx)), _mm_set1_epi16(0x0110));
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(output + idx), _mm_packus_epi16(kPairs, kPairs));
+        }
+#endif
+        for (; idx < byte_count ;++idx) { output[idx] = static_cast<unsigned char>(nibbles[2 * idx] * 16 + nibbles[2 * idx + 1]); }
+    }
+
+    optional<uint8_t> pending;
+};
+
+/**
+ * @brief Decodes hex from @param in and writes the bytes to @param out, in chunks of kHexStreamChunk characters.
+ *      An odd number of hex digits is reported as invalid at the end of input.
+ */
+HexDecodeResult HexDecodeStream(istream &in, ostream &out)
+{
+    auto decoder = HexDecoder{};
+    auto chunk   = vector<char>(kHexStreamChunk);
+    auto bytes   = vector<unsigned char>(kHexStreamChunk / 2 + 1);
+    auto total   = HexDecodeResult{};
+    while (in && !total.invalid_offset)
+    {
+        in.read(chunk.data(), static_cast<std::streamsize>(size(chunk)));
+        const auto kResult = decoder.Decode(string_view{ chunk.data(), static_cast<size_t>(in.gcount()) }, bytes);
+        out.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(kResult.written));
+        if (kResult.invalid_offset) { total.invalid_offset = total.consumed + *kResult.invalid_offset; }
+        total.consumed += kResult.consumed;
+        total.written  += kResult.written;
+    }
+    if (!total.invalid_offset && decoder.HasPendingNibble()) { total.invalid_offset = total.consumed; }
+    return total;
+}
+
 /**
  * @brief Converts a string of hexadecimal characters in @param str_input to binary representation.
  * 
- * - First extracts all alphanumeric characters from @param str_input.
- * - If the number of alphanumeric characters is odd, takes the first character and treats it as if
+ * - Characters other than letters and digits are skipped.
+ * - If the number of hex digits is odd, takes the first character and treats it as if
  *   the second character is '0'.
- * - Converts pairs of alphanumeric characters to their binary representation.
+ * - Converts pairs of hex digits to their binary representation, stopping at the first letter which
+ *   is not a hex digit.
  * 
  * @param str_input - The input string containing hexadecimal characters.
  * @return vector<unsigned char> - The binary representation of the input string.
  */
 vector<unsigned char> StringToBinary(string_view str_input)
 {
-    const auto kStr = ExtractAlphaNumericCharacters(str_input);
-    auto vec        = vector<unsigned char>{};
-    auto iter       = cbegin(kStr);
-    
-    if (1 == (size(kStr) % 2))
-    {
-        vec.push_back(HexToInt('0', kStr.front()));
-        ++iter;
-    }
-    
-    for (; iter < cend(kStr) ; iter += 2)
+    const auto kDigitCount = std::count_if(cbegin(str_input), cend(str_input), [](const char &ch) {
+        return kHexValues[static_cast<unsigned char>(ch)] < 16;
+    });
+    auto vec     = vector<unsigned char>((kDigitCount + 1) / 2);
+    auto decoder = (1 == kDigitCount % 2) ? HexDecoder{ 0 } : HexDecoder{};
+    vec.resize(decoder.Decode(str_input, vec).written);
+    return vec;
+}
+
+/**
+ * @brief Straightforward decoder for checking HexDecoder, returns the bytes and the offset of first invalid character.
+ */
+std::pair<vector<unsigned char>, optional<size_t>> ReferenceDecode(string_view input)
+{
+    auto bytes = vector<unsigned char>{};
+    auto high  = optional<int>{};
+    for (auto idx = size_t{ 0 }; idx < input.size() ;++idx)
     {
-        const auto &ch1 = *iter;
-        const auto &ch2 = *(iter + 1); 
-        vec.push_back(HexToInt(ch1, ch2));
+        const auto kCh = input[idx];
+        auto value     = -1;
+        if      (kCh >= '0' && kCh <= '9') { value = kCh - '0'; }
+        else if (kCh >= 'a' && kCh <= 'f') { value = kCh - 'a' + 10; }
+        else if (kCh >= 'A' && kCh <= 'F') { value = kCh - 'A' + 10; }
+        else if ((kCh >= 'g' && kCh <= 'z') || (kCh >= 'G' && kCh <= 'Z')) { return { bytes, idx }; }
+        if (value < 0) { continue; }
+        if (high) { bytes.push_back(static_cast<unsigned char>(*high * 16 + value)); high.reset(); }
+        else      { high = value; }
     }
-
-    return vec;
+    return { bytes, {} };
 }
 
 int main()
@@ -123,6 +365,62 @@ int main()
         << std::setw(2) << std::setfill('0')
         << static_cast<int>(elem) << " ";
     }
-    cout << '\n';
+    cout << '\n' << std::dec;
+
+    assert((vector<unsigned char>{ 0xBA, 0xAD, 0xF0, 0x0D }) == StringToBinary("baadF00D"));
+    assert((vector<unsigned char>{ 1, 2, 3, 4, 5, 6 }) == StringToBinary("01:02:03 04-05\n06"));
+    assert((vector<unsigned char>{ 0x0A, 0xBC }) == StringToBinary("ABC"));
+
+    // Random hex with random separators and some invalid letters, decoded in random chunks into random sized outputs
+    auto random_engine = std::mt19937{ 24 };
+    constexpr auto kAlphabet = string_view{ "0123456789abcdefABCDEF0123456789abcdefABCDEF  ::\n-\xC3" };
+    for (auto test = 0; test < 2'000 ;++test)
+    {
+        auto input = string(random_engine() % 300, '\0');
+        for (auto &ch : input) { ch = kAlphabet[random_engine() % kAlphabet.size()]; }
+        if (0 == test % 3 && !input.empty()) { input[random_engine() % input.size()] = 'g' + random_engine() % 20; }
+        const auto [kExpected, kExpectedInvalid] = ReferenceDecode(input);
+
+        auto decoder   = HexDecoder{};
+        auto output    = vector<unsigned char>(input.size());
+        auto written   = size_t{ 0 };
+        auto consumed  = size_t{ 0 };
+        auto invalid   = optional<size_t>{};
+        while (consumed < input.size() && !invalid)
+        {
+            const auto kChunk  = std::min<size_t>(1 + random_engine() % 40, input.size() - consumed);
+            const auto kOutput = std::min<size_t>(random_engine() % 24, size(output) - written);
+            const auto kResult = decoder.Decode(string_view{ input }.substr(consumed, kChunk), span{ output }.subspan(written, kOutput));
+            if (kResult.invalid_offset) { invalid = consumed + *kResult.invalid_offset; }
+            consumed += kResult.consumed;
+            written  += kResult.written;
+        }
+        output.resize(written);
+        assert(kExpected == output && kExpectedInvalid == invalid);
+    }
+
+    auto bytes = vector<unsigned char>(kBenchmarkSize);
+    for (auto &value : bytes) { value = static_cast<unsigned char>(random_engine()); }
+    auto plain = std::ostringstream{}, dump = std::ostringstream{};
+    for (auto idx = size_t{ 0 }; idx < size(bytes) ;++idx)
+    {
+        constexpr auto kDigits = string_view{ "0123456789abcdef" };
+        plain << kDigits[bytes[idx] >> 4] << kDigits[bytes[idx] & 0xF];
+        dump  << kDigits[bytes[idx] >> 4] << kDigits[bytes[idx] & 0xF] << ((15 == idx % 16) ? '\n' : ' ');
+    }
+
+    auto output = vector<unsigned char>(kBenchmarkSize);
+    for (const auto &[kName, kText] : { std::pair{ "plain hex", plain.str() }, std::pair{ "hex dump", dump.str() } })
+    {
+        const auto kStartTimepoint = steady_clock::now();
+        const auto kResult         = HexDecoder{}.Decode(kText, output);
+        const auto kSeconds        = duration<double>(steady_clock::now() - kStartTimepoint).count();
+        assert(kResult.written == kBenchmarkSize && kResult.consumed == kText.size() && output == bytes);
+        cout << "Decoding " << (kText.size() >> 20) << " MB of " << kName << ": " << kText.size() / kSeconds / 1e9 << " GB/s" << endl;
+
+        auto in  = std::istringstream{ kText };
+        auto out = std::ostringstream{};
+        assert(HexDecodeStream(in, out).written == kBenchmarkSize && out.str() == string_view(reinterpret_cast<const char *>(bytes.data()), size(bytes)));
+    }
     return 0;
 }
\ No newline at end of file
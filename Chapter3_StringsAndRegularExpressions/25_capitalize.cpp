@@ -2,7 +2,7 @@
  * @file 25_capitalize.cpp
  * @author Usama Tayyab (usamatayyab9@gmail.com)
  * @brief 
- *  Compilation command : g++ -std=c++17 25_capitalize.cpp 
+ *  Compilation command : g++ -std=c++20 -O2 -mavx2 25_capitalize.cpp 
  *  This file is solution to "Problem 25. Capitalizing an article title"
  *  mentioned in "Chapter 3: Strings and Regular Expressions" of the book:
  *  - The Modern C++ Challenge by Marius Bancilla (available at amazon https://www.amazon.com/Modern-Challenge-programmer-real-world-problems/dp/1788993861)
@@ -16,8 +16,26 @@
  * A function Capitalize() which takes constant reference to string representing the article 
  * which is to be capitalized, converts the input to capitalized version and returns it.
  * 
+ * For strings of char, Capitalize() copies the text once and capitalizes the copy in place with
+ * CapitalizeInPlace(), which treats the text as UTF-8 and does not depend on locale:
+ * - With AVX2, 32 ASCII characters are processed at a time. Letters are found by an unsigned range
+ *   compare on (ch | 0x20) - 'a', the bitmask of letters shifted by one gives the letters preceded by
+ *   a letter, and the remaining letters start a word. The case bit(0x20) of every letter is set, and
+ *   cleared for the letters starting a word.
+ *   A block is processed upto its first byte >= 0x80, and the code point there is handled on its own.
+ * - Non ASCII code points, and the tail, are handled one code point at a time. Letters of
+ *   Latin, Greek and Cyrillic are case mapped by ClassifyCodePoint(), other scripts are taken as letters
+ *   without case, and punctuation and symbols end a word. A letter whose other case has a different
+ *   UTF-8 length, and an invalid UTF-8 sequence, is left as it is.
+ * `StringArena` stores many strings in one buffer and CapitalizeBatch() writes all of them in one go into
+ * one output buffer, with a word ending at the end of each string.
+ * CapitalizeWithLocale() is the previous locale based solution, which is used for other character types.
+ * 
  * Driver code:
  * Test cases for testing the above function.
+ * Then CapitalizeInPlace() is checked against CapitalizeWithLocale() on random ASCII text, against one code point
+ * at a time on random UTF-8 text, and CapitalizeBatch() against Capitalize(). Lastly time taken for
+ * capitalizing `kBenchmarkCount` product names one by one and as a batch is printed.
  * @copyright Copyright (c) 2023
  * 
  */
@@ -27,7 +45,19 @@
 #include <algorithm>
 #include <iterator>
 #include <locale>
+#include <vector>
+#include <span>
+#include <random>
+#include <chrono>
+#include <type_traits>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <bit>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 using std::basic_string;
 using std::basic_string_view;
@@ -39,10 +69,17 @@ using std::find;
 using std::find_if_not;
 using std::isalpha;
 using std::locale;
+using std::span;
 using std::string;
 using std::string_view;
 using std::toupper;
 using std::tolower;
+using std::vector;
+using std::chrono::steady_clock;
+using std::chrono::duration;
+
+inline constexpr auto kCaseBit        = char{ 0x20 };
+inline constexpr auto kBenchmarkCount = size_t{ 2'000'000 };
 
 /**
  * @brief Capitalizes the first letter of each word in the input string.
@@ -55,7 +92,7 @@ using std::tolower;
  * @return basic_string<T> - A new string with the first letter of each word capitalized.
  */
 template<class T>
-auto Capitalize(const basic_string<T> &text)
+auto CapitalizeWithLocale(const basic_string<T> &text)
 {
     const auto loc  = locale{};
     auto IsAlpha    = [&loc](const auto &ch) { return isalpha(ch, loc); };
@@ -78,6 +115,259 @@ auto Capitalize(const basic_string<T> &text)
     return result;
 }
 
+struct LetterCase
+{
+    bool     is_letter = false;
+    char32_t upper     = 0;
+    char32_t lower     = 0;
+};
+
+/**
+ * @brief Returns whether the code point @param cp is a letter and its upper and lower case, see file comments.
+ */
+constexpr LetterCase ClassifyCodePoint(const char32_t &cp)
+{
+    auto InRange = [&cp](const char32_t &first, const char32_t &last) { return cp >= first && cp <= last; };
+    auto Pair    = [&cp](const bool &is_upper, const char32_t &distance) {
+        return is_upper ? LetterCase{ true, cp, cp + distance } : LetterCase{ true, cp - distance, cp };
+    };
+    if (InRange(U'a', U'z') || InRange(U'A', U'Z')) { return Pair(cp < U'a', 0x20); }
+    if (cp < 0xC0) { return { 0xAA == cp || 0xB5 == cp || 0xBA == cp, cp, cp }; }
+    // Latin-1 Supplement and Latin Extended-A
+    if (0xD7 == cp || 0xF7 == cp) { return {}; }
+    if (0xDF == cp || 0x130 == cp || 0x131 == cp || 0x138 == cp || 0x149 == cp || 0x17F == cp) { return { true, cp, cp }; }
+    if (0xFF == cp)  { return { true, 0x178, 0xFF }; }
+    if (0x178 == cp) { return { true, 0x178, 0xFF }; }
+    if (cp < 0x100)  { return Pair(cp < 0xE0, 0x20); }
+    if (cp < 0x180)
+    {
+        const auto kEvenIsUpper = (cp < 0x138) || InRange(0x14A, 0x177);
+        return Pair(kEvenIsUpper == (0 == cp % 2), 1);
+    }
+    // Latin Extended-B, IPA, spacing modifiers and combining marks
+    if (cp < 0x370) { return { true, cp, cp }; }
+    // Greek
+    if (0x37E == cp || InRange(0x384, 0x385) || 0x387 == cp) { return {}; }
+    if (0x386 == cp) { return Pair(true, 0x26); }
+    if (0x3AC == cp) { return Pair(false, 0x26); }
+    if (InRange(0x388, 0x38A)) { return Pair(true, 0x25); }
+    if (InRange(0x3AD, 0x3AF)) { return Pair(false, 0x25); }
+    if (0x38C == cp) { return Pair(true, 0x40); }
+    if (0x3CC == cp) { return Pair(false, 0x40); }
+    if (InRange(0x38E, 0x38F)) { return Pair(true, 0x3F); }
+    if (InRange(0x3CD, 0x3CE)) { return Pair(false, 0x3F); }
+    if (0x3C2 == cp) { return { true, 0x3A3, 0x3C2 }; }
+    if (InRange(0x391, 0x3A9) && 0x3A2 != cp) { return Pair(true, 0x20); }
+    if (InRange(0x3B1, 0x3C9)) { return Pair(false, 0x20); }
+    if (cp < 0x400) { return { true, cp, cp }; }
+    // Cyrillic
+    if (InRange(0x400, 0x40F)) { return Pair(true, 0x50); }
+    if (InRange(0x410, 0x42F)) { return Pair(true, 0x20); }
+    if (InRange(0x430, 0x44F)) { return Pair(false, 0x20); }
+    if (InRange(0x450, 0x45F)) { return Pair(false, 0x50); }
+    if (InRange(0x460, 0x481) || InRange(0x48A, 0x4BF) || InRange(0x4D0, 0x52F)) { return Pair(0 == cp % 2, 1); }
+    if (InRange(0x4C1, 0x4CE)) { return Pair(1 == cp % 2, 1); }
+    // Other alphabets, kana, CJK ideographs, hangul and fullwidth latin are letters. General punctuation,
+    // symbols, CJK punctuation, emoji etc are not.
+    const auto kIsLetter = InRange(0x4C0, 0x1FFF) || InRange(0x2C00, 0x2DFF) || InRange(0x3040, 0xD7FF)
+                        || InRange(0xF900, 0xFAFF) || InRange(0xFF21, 0xFF3A) || InRange(0xFF41, 0xFF5A) || InRange(0x20000, 0x3FFFF);
+    return { kIsLetter, cp, cp };
+}
+
+/**
+ * @brief Decodes the UTF-8 sequence at @param text having @param available bytes. Returns the code point and
+ *      the length of the sequence, length is 0 if the sequence is not valid.
+ */
+constexpr std::pair<char32_t, size_t> DecodeUtf8(const char *text, const size_t &available)
+{
+    const auto kLead = static_cast<unsigned char>(text[0]);
+    auto length      = size_t{ 0 };
+    auto cp          = char32_t{ 0 };
+    auto min_second  = 0x80u, max_second = 0xBFu;
+    if      (kLead < 0x80)                  { return { kLead, 1 }; }
+    else if (kLead >= 0xC2 && kLead <= 0xDF) { length = 2; cp = kLead & 0x1F; }
+    else if (kLead >= 0xE0 && kLead <= 0xEF) { length = 3; cp = kLead & 0x0F; min_second = (0xE0 == kLead) ? 0xA0 : 0x80; max_second = (0xED == kLead) ? 0x9F : 0xBF; }
+    else if (kLead >= 0xF0 && kLead <= 0xF4) { length = 4; cp = kLead & 0x07; min_second = (0xF0 == kLead) ? 0x90 : 0x80; max_second = (0xF4 == kLead) ? 0x8F : 0xBF; }
+    else { return { 0, 0 }; }
+    if (length > available) { return { 0, 0 }; }
+    for (auto idx = size_t{ 1 }; idx < length ;++idx)
+    {
+        const auto kByte = static_cast<unsigned char>(text[idx]);
+        if (kByte < ((1 == idx) ? min_second : 0x80u) || kByte > ((1 == idx) ? max_second : 0xBFu)) { return { 0, 0 }; }
+        cp = (cp << 6) | (kByte & 0x3F);
+    }
+    return { cp, length };
+}
+
+/**
+ * @brief Writes the 2-byte UTF-8 encoding of @param cp to @param text.
+ */
+void EncodeUtf8TwoBytes(const char32_t &cp, char *text)
+{
+    text[0] = static_cast<char>(0xC0 | (cp >> 6));
+    text[1] = static_cast<char>(0x80 | (cp & 0x3F));
+}
+
+/**
+ * @brief Capitalizes the code point at @param idx of @param text, which may not extend past @param limit.
+ *      @param in_word tells whether the previous code point was a letter.
+ * @return index of the next code point
+ */
+size_t CapitalizeCodePoint(span<char> text, const size_t &idx, const size_t &limit, bool &in_word)
+{
+    if (const auto kCh = static_cast<unsigned char>(text[idx]); kCh < 0x80)
+    {
+        const auto kIsLetter = static_cast<unsigned char>((kCh | kCaseBit) - 'a') < 26;
+        if (kIsLetter) { text[idx] = static_cast<char>(in_word ? (kCh | kCaseBit) : (kCh & ~kCaseBit)); }
+        in_word = kIsLetter;
+        return idx + 1;
+    }
+    const auto [kCodePoint, kLength] = DecodeUtf8(text.data() + idx, limit - idx);
+    if (0 == kLength)
+    {
+        in_word = false;
+        return idx + 1;
+    }
+    const auto kLetter = ClassifyCodePoint(kCodePoint);
+    if (kLetter.is_letter)
+    {
+        const auto kTarget = in_word ? kLetter.lower : kLetter.upper;
+        if (1 == kLength && kTarget < 0x80)                          { text[idx] = static_cast<char>(kTarget); }
+        else if (2 == kLength && kTarget >= 0x80 && kTarget < 0x800) { EncodeUtf8TwoBytes(kTarget, text.data() + idx); }
+    }
+    in_word = kLetter.is_letter;
+    return idx + kLength;
+}
+
+#if defined(__AVX2__)
+/**
+ * @brief Returns a vector whose byte i is 0xFF if bit i of @param mask is set and 0 otherwise.
+ */
+__m256i ExpandBitmask(const uint32_t &mask)
+{
+    const auto kBytes = _mm256_shuffle_epi8(_mm256_set1_epi32(static_cast<int>(mask)),
+        _mm256_setr_epi64x(0x0000000000000000, 0x0101010101010101, 0x0202020202020202, 0x0303030303030303));
+    const auto kBits  = _mm256_set1_epi64x(static_cast<int64_t>(0x8040201008040201ull));
+    return _mm256_cmpeq_epi8(_mm256_and_si256(kBytes, kBits), kBits);
+}
+
+/**
+ * @brief Capitalizes the ASCII characters at @param block before the first non ASCII one, upto 32 characters,
+ *      see file comments. Bit i of @param starts is set if a string starts at character i.
+ * @return number of characters capitalized
+ */
+size_t CapitalizeAsciiBlock(char *block, const uint32_t &starts, bool &in_word)
+{
+    const auto kChars   = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block));
+    const auto kNonAscii = static_cast<uint32_t>(_mm256_movemask_epi8(kChars));
+    const auto kLength  = (0 == kNonAscii) ? size_t{ 32 } : static_cast<size_t>(std::countr_zero(kNonAscii));
+    if (0 == kLength) { return 0; }
+
+    const auto kCaseBits = _mm256_set1_epi8(kCaseBit);
+    const auto kLetter   = _mm256_sub_epi8(_mm256_or_si256(kChars, kCaseBits), _mm256_set1_epi8('a'));
+    const auto kIsLetter = _mm256_cmpeq_epi8(_mm256_min_epu8(kLetter, _mm256_set1_epi8(25)), kLetter);
+    const auto kLetters  = static_cast<uint32_t>(_mm256_movemask_epi8(kIsLetter)) & (~uint32_t{ 0 } >> (32 - kLength));
+    const auto kFollows  = ((kLetters << 1) | (in_word ? 1u : 0u)) & ~starts;
+    const auto kLowered  = _mm256_or_si256(kChars, _mm256_and_si256(ExpandBitmask(kLetters), kCaseBits));
+    const auto kUpper    = _mm256_and_si256(ExpandBitmask(kLetters & ~kFollows), kCaseBits);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(block), _mm256_andnot_si256(kUpper, kLowered));
+    in_word = 0 != ((kLetters >> (kLength - 1)) & 1);
+    return kLength;
+}
+#endif
+
+/**
+ * @brief Capitalizes UTF-8 @param text in place, see file comments. A word also ends at every offset in
+ *      @param string_starts which must be sorted, this allows capitalizing many strings stored together.
+ */
+void CapitalizeInPlace(span<char> text, span<const size_t> string_starts = {})
+{
+    auto in_word    = false;
+    auto next_start = begin(string_starts);
+    auto idx        = size_t{ 0 };
+    while (idx < size(text))
+    {
+#if defined(__AVX2__)
+        if (idx + 32 <= size(text))
+        {
+            auto starts = uint32_t{ 0 };
+            for (auto current = next_start; current != end(string_starts) && *current < idx + 32 ;++current)
+            {
+                starts |= uint32_t{ 1 } << (*current - idx);
+            }
+            const auto kLength = CapitalizeAsciiBlock(text.data() + idx, starts, in_word);
+            idx += kLength;
+            for (; next_start != end(string_starts) && *next_start < idx ;++next_start) {}
+            if (32 == kLength) { continue; }
+        }
+#endif
+        // A non ASCII code point, or the tail
+        for (; next_start != end(string_starts) && *next_start <= idx ;++next_start)
+        {
+            if (*next_start == idx) { in_word = false; }
+        }
+        const auto kLimit = (next_start != end(string_starts)) ? std::min(*next_start, size(text)) : size(text);
+        idx = CapitalizeCodePoint(text, idx, kLimit, in_word);
+    }
+}
+
+/**
+ * @brief Capitalizes the first letter of each word in @param text, see file comments.
+ */
+template<class T>
+auto Capitalize(const basic_string<T> &text)
+{
+    if constexpr (std::is_same_v<T, char>)
+    {
+        auto result = text;
+        CapitalizeInPlace(result);
+        return result;
+    }
+    else
+    {
+        return CapitalizeWithLocale(text);
+    }
+}
+
+/**
+ * @brief Stores many strings one after another in a single buffer.
+ */
+class StringArena
+{
+public:
+    void Add(string_view str)
+    {
+        starts_.push_back(buffer_.size());
+        buffer_.append(str);
+    }
+
+    size_t size() const { return starts_.size(); }
+
+    string_view operator[](const size_t &idx) const
+    {
+        const auto kEnd = (idx + 1 < starts_.size()) ? starts_[idx + 1] : buffer_.size();
+        return string_view{ buffer_ }.substr(starts_[idx], kEnd - starts_[idx]);
+    }
+
+    string_view Buffer() const { return buffer_; }
+    span<const size_t> Starts() const { return starts_; }
+
+private:
+    string         buffer_;
+    vector<size_t> starts_;
+};
+
+/**
+ * @brief Writes all strings of @param input capitalized into @param output, which must be as long as
+ *      input.Buffer(). String i is at the same offset in @param output as in input.Buffer().
+ */
+void CapitalizeBatch(const StringArena &input, span<char> output)
+{
+    const auto kBuffer = input.Buffer();
+    std::copy(cbegin(kBuffer), cend(kBuffer), output.data());
+    CapitalizeInPlace(output.first(size(kBuffer)), input.Starts());
+}
+
 int main()
 {
     using namespace std::string_literals;
@@ -92,6 +382,92 @@ int main()
     assert("++++Text----Inside=====Operators" == Capitalize("++++text----inside=====operators"s));
     assert("     Empty Spaces Before Any Text" == Capitalize("     empty spaces before any text"s));
     assert("   A   Lot      Of   Spaces     Before  Between    And After Text.     " == Capitalize("   a   lot      of   spaces     before  between    and after text.     "s));
+    assert(L"The C++ Challenge" == Capitalize(L"the C++ CHALLENGE"s));
+    assert("Éclair Crème Brûlée, Straße" == Capitalize("ÉCLAIR crème BRÛLÉE, straße"s));
+    // Every case pair maps back, final sigma is the only lower case letter which is not the lower case of its upper case
+    for (auto cp = char32_t{ 0 }; cp < 0x530 ;++cp)
+    {
+        const auto kLetter = ClassifyCodePoint(cp);
+        assert(ClassifyCodePoint(kLetter.upper).upper == kLetter.upper);
+        assert(ClassifyCodePoint(kLetter.upper).lower == kLetter.lower || 0x3C2 == cp);
+    }
+    assert("Ελληνικά Σασ Κείμενο" == Capitalize("ελληνικά σασ ΚΕΊΜΕΝΟ"s));
+    assert("Όλα Ύλη Ώρα Άλλα Έχω Ήλιο Ίδιο" == Capitalize("όλα ύλη ώρα άλλα έχω ήλιο ίδιο"s));
+    assert("Όλα Ύλη Ώρα Καλό Στύλο Τώρα" == Capitalize("ΌΛΑ ΎΛΗ ΏΡΑ ΚΑΛΌ ΣΤΎΛΟ ΤΏΡΑ"s));
+    assert("Москва Ёлка — «Привет»" == Capitalize("МОСКВА ёлка — «привет»"s));
+    assert("Long Ascii Prefix To Fill A Simd Block Then Çà Et Là, Then Ascii Again And Again" ==
+           Capitalize("LONG ascii prefix to fill a simd block then çÀ et LÀ, then ascii again AND again"s));
+    assert("\xFF\xC3 Abc" == Capitalize("\xFF\xC3 aBC"s));
+
+    auto arena = StringArena{};
+    for (const auto kName : { "usb-c CABLE"sv, "ab"sv, "cd"sv, ""sv, "ÉTÉ sale"sv, "a long product name which spans more than one block"sv })
+    {
+        arena.Add(kName);
+    }
+    auto batch = string(arena.Buffer().size(), '\0');
+    CapitalizeBatch(arena, batch);
+    assert("Usb-C CableAbCdÉté SaleA Long Product Name Which Spans More Than One Block" == batch);
+
+    // Random ASCII text, of which ASCII results must match the locale based solution
+    auto random_engine = std::mt19937{ 25 };
+    constexpr auto kAlphabet = "abcdefXYZ  ,.-+1"sv;
+    for (auto test = 0; test < 2'000 ;++test)
+    {
+        auto text = string(random_engine() % 200, ' ');
+        for (auto &ch : text) { ch = kAlphabet[random_engine() % size(kAlphabet)]; }
+        assert(CapitalizeWithLocale(text) == Capitalize(text));
+    }
+
+    // Random UTF-8 text split into strings, checked against capitalizing one code point at a time
+    constexpr auto kMixedAlphabet = std::array{ "a"sv, "Z"sv, "q"sv, " "sv, "-"sv, "é"sv, "Ö"sv, "ß"sv, "Ж"sv, "я"sv, "Σ"sv, "—"sv, "«"sv, "漢"sv, "\xC3"sv };
+    for (auto test = 0; test < 2'000 ;++test)
+    {
+        auto strings = StringArena{};
+        for (auto count = random_engine() % 8; count > 0 ;--count)
+        {
+            auto text = string{};
+            for (auto length = random_engine() % 60; length > 0 ;--length) { text.append(kMixedAlphabet[random_engine() % size(kMixedAlphabet)]); }
+            auto expected = text;
+            auto in_word  = false;
+            for (auto idx = size_t{ 0 }; idx < size(expected) ;) { idx = CapitalizeCodePoint(expected, idx, size(expected), in_word); }
+            assert(expected == Capitalize(text));
+            strings.Add(text);
+        }
+        auto output = string(strings.Buffer().size(), '\0');
+        CapitalizeBatch(strings, output);
+        for (auto idx = size_t{ 0 }; idx < strings.size() ;++idx)
+        {
+            assert(Capitalize(string{ strings[idx] }) == string_view{ output }.substr(strings.Starts()[idx], strings[idx].size()));
+        }
+    }
+
+    auto names = StringArena{};
+    constexpr auto kWords = std::array{ "wireless"sv, "MOUSE"sv, "usb-c"sv, "Charger"sv, "65w"sv, "stainless"sv, "steel"sv, "WATER"sv, "bottle"sv, "crème"sv, "brûlée"sv, "kit"sv };
+    auto name = string{};
+    for (auto idx = size_t{ 0 }; idx < kBenchmarkCount ;++idx)
+    {
+        name.clear();
+        for (auto count = 3 + random_engine() % 6; count > 0 ;--count)
+        {
+            name.append(kWords[random_engine() % size(kWords)]).push_back(' ');
+        }
+        names.Add(name);
+    }
+
+    auto start_timepoint = steady_clock::now();
+    auto total           = size_t{ 0 };
+    for (auto idx = size_t{ 0 }; idx < names.size() ;++idx) { total += CapitalizeWithLocale(string{ names[idx] }).size(); }
+    cout << "Capitalizing " << kBenchmarkCount << " names with locale one by one: " << duration<double>(steady_clock::now() - start_timepoint).count() << " sec\n";
+
+    start_timepoint = steady_clock::now();
+    for (auto idx = size_t{ 0 }; idx < names.size() ;++idx) { total += Capitalize(string{ names[idx] }).size(); }
+    cout << "Capitalizing " << kBenchmarkCount << " names one by one: " << duration<double>(steady_clock::now() - start_timepoint).count() << " sec\n";
+
+    auto output = string(names.Buffer().size(), '\0');
+    start_timepoint = steady_clock::now();
+    CapitalizeBatch(names, output);
+    cout << "Capitalizing " << kBenchmarkCount << " names as a batch: " << duration<double>(steady_clock::now() - start_timepoint).count() << " sec\n";
+    assert(Capitalize(string{ names[7] }) == string_view{ output }.substr(names.Starts()[7], names[7].size()) && total > 0);
 
     cout << "All Test cases passed\n";
     return 0;
@@ -2,7 +2,7 @@
  * @file 26_join_strings.cpp
  * @author Usama Tayyab (usamatayyab9@gmail.com)
  * @brief 
- * Compilation command : g++ -std=c++17 26_join_strings.cpp
+ * Compilation command : g++ -std=c++20 -O2 26_join_strings.cpp
  * This file is solution to "Problem 26. Joining strings together separated by a delimiter"
  *  mentioned in "Chapter 3: Strings and Regular Expressions" of the book:
  *  - The Modern C++ Challenge by Marius Bancilla (available at amazon https://www.amazon.com/Modern-Challenge-programmer-real-world-problems/dp/1788993861)
@@ -19,8 +19,19 @@
  * A function JoinStringsWithDelimeter() which takes container of strings and delimter and joins all the strings.
  * See function details for implementation details.
  * 
+ * The joined length is computed by JoinedLength() in a first pass over the container, and the strings are
+ * then copied into the result in a second pass, so the result is allocated exactly once. Other forms are:
+ * - AppendJoinedStrings() which appends to an existing string, growing it once, so a buffer can be reused
+ *   for many joins without any allocation after the first.
+ * - JoinStringsToStream() and JoinStringsToFile() which do not build the joined string at all. Strings
+ *   are gathered into a `BlockWriter` buffer of `kJoinBlockSize` bytes which is written to an ostream or a
+ *   file descriptor whenever it fills, strings larger than the buffer are written directly.
+ * 
  * Driver code:
  * Executes the above function with different argumetns and compares the output is an assertion.
+ * Then time taken for exporting `kBenchmarkRows` CSV rows by appending with operator+=, JoinStringsWithDelimeter(),
+ * AppendJoinedStrings() and JoinStringsToFile() is printed. JoinStringsToFile() writes to a file in the temporary
+ * directory, which is checked and removed afterwards.
  * 
  * @copyright Copyright (c) 2023
  * 
@@ -36,6 +47,15 @@
 #include <list>
 #include <array>
 #include <forward_list>
+#include <ostream>
+#include <sstream>
+#include <fstream>
+#include <chrono>
+#include <filesystem>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
 
 using std::accumulate;
 using std::array;
@@ -47,10 +67,61 @@ using std::endl;
 using std::forward_list;
 using std::list;
 using std::next;
+using std::ostream;
 using std::size;
 using std::string;
 using std::string_view;
 using std::vector;
+using std::chrono::steady_clock;
+using std::chrono::duration;
+
+inline constexpr auto kJoinBlockSize = size_t{ 1 } << 20;
+inline constexpr auto kBenchmarkRows = size_t{ 2'000'000 };
+
+/**
+ * @brief Returns length of the strings in container @param c joined with @param delimeter.
+ */
+template<class Container>
+size_t JoinedLength(const Container &c, string_view delimeter)
+{
+    /*!
+        Almost all container provide size() function which returns number of elements in container.
+        std::forward_list does not provide any functionality for fetching number of elements
+        in it. One method would be to write a separate size function using templates for std::forward_list
+        and for other containers use their size(). So therefore for-loop is used to calculate size.
+    */
+    auto accumulated_string_lengths = size_t{ 0 };
+    auto container_size             = size_t{ 0 };
+    for (const auto &str : c)
+    {
+        accumulated_string_lengths += size(str);
+        ++container_size;
+    }
+    const auto kTotalDelimeters = 0 == container_size ? 0 : size(delimeter) * (container_size - 1);
+    return accumulated_string_lengths + kTotalDelimeters;
+}
+
+/**
+ * @brief Copies strings in container @param c joined with @param delimeter to @param destination, which must
+ *      have room for JoinedLength() characters.
+ * @return pointer past the last character written
+ */
+template<class Container>
+char *CopyJoined(const Container &c, string_view delimeter, char *destination)
+{
+    auto is_first = true;
+    for (const auto &kStr : c)
+    {
+        if (!is_first)//Delimeter goes before every string except the first one
+        {
+            destination = std::copy_n(delimeter.data(), size(delimeter), destination);
+        }
+        const auto kView = string_view{ kStr };
+        destination      = std::copy_n(kView.data(), size(kView), destination);
+        is_first         = false;
+    }
+    return destination;
+}
 
 /**
  * @brief Joins a collection of strings with a specified delimiter.
@@ -70,37 +141,112 @@ using std::vector;
 template<class Container>
 string JoinStringsWithDelimeter(const Container &c, string_view delimeter)
 {
-    /*!
-        Almost all container provide size() function which returns number of elements in container.
-        std::forward_list does not provide any functionality for fetching number of elements
-        in it. One method would be to write a separate size function using templates for std::forward_list
-        and for other containers use their size(). So therefore for-loop is used to calculate size.
-    */
-    auto accumulated_string_lengths = size_t{ 0 };
-    auto container_size             = size_t{ 0 };
-    for (const auto &str : c)
+    auto str = string(JoinedLength(c, delimeter), '\0');
+    CopyJoined(c, delimeter, str.data());
+    return str;
+}
+
+/**
+ * @brief Appends strings in container @param c joined with @param delimeter to @param buffer, growing it atmost once.
+ */
+template<class Container>
+void AppendJoinedStrings(string &buffer, const Container &c, string_view delimeter)
+{
+    const auto kOldSize = size(buffer);
+    buffer.resize(kOldSize + JoinedLength(c, delimeter));
+    CopyJoined(c, delimeter, buffer.data() + kOldSize);
+}
+
+/**
+ * @brief Buffers output in blocks of kJoinBlockSize bytes and passes full blocks to @tparam Sink, which is called
+ *      as sink(string_view) and returns false on failure. Once the sink fails nothing more is written.
+ */
+template<class Sink>
+class BlockWriter
+{
+public:
+    explicit BlockWriter(Sink sink) : sink_{ std::move(sink) } { buffer_.reserve(kJoinBlockSize); }
+
+    void Write(string_view data)
     {
-        accumulated_string_lengths += size(str);
-        ++container_size;
+        if (size(buffer_) + size(data) > kJoinBlockSize) { Flush(); }
+        if (size(data) >= kJoinBlockSize) { good_ = good_ && sink_(data); }
+        else                              { buffer_.append(data); }
     }
-    const auto kTotalDelimeters = 0 == container_size ? 0 : size(delimeter) * (container_size - 1);
-    const auto kTotalSize       = accumulated_string_lengths + kTotalDelimeters;
-    auto str                    = string(kTotalSize, '\0');
-    if (container_size > 0)
+
+    /**
+     * @brief Writes the buffered data, returns false if any write failed so far.
+     */
+    bool Flush()
+    {
+        if (!buffer_.empty()) { good_ = good_ && sink_(string_view{ buffer_ }); }
+        buffer_.clear();
+        return good_;
+    }
+
+private:
+    Sink   sink_;
+    string buffer_;
+    bool   good_ = true;
+};
+
+/**
+ * @brief Writes strings in container @param c joined with @param delimeter to @param writer.
+ */
+template<class Container, class Sink>
+void WriteJoined(BlockWriter<Sink> &writer, const Container &c, string_view delimeter)
+{
+    auto is_first = true;
+    for (const auto &kStr : c)
+    {
+        if (!is_first) { writer.Write(delimeter); }
+        writer.Write(kStr);
+        is_first = false;
+    }
+}
+
+/**
+ * @brief Writes strings in container @param c joined with @param delimeter to @param out in large blocks.
+ * @return true if all of the output was written
+ */
+template<class Container>
+bool JoinStringsToStream(ostream &out, const Container &c, string_view delimeter)
+{
+    auto writer = BlockWriter{ [&out](string_view data) {
+        return static_cast<bool>(out.write(data.data(), static_cast<std::streamsize>(size(data))));
+    } };
+    WriteJoined(writer, c, delimeter);
+    return writer.Flush();
+}
+
+/**
+ * @brief Writes all of @param data to file descriptor @param fd, retrying partial and interrupted writes.
+ */
+bool WriteAll(const int &fd, string_view data)
+{
+    while (!data.empty())
     {
-        auto idx              = size_t{ 0 };
-        auto destination_iter = begin(str);
-        for (const auto &kStr : c)
+        const auto kWritten = ::write(fd, data.data(), size(data));
+        if (kWritten < 0)
         {
-            destination_iter = copy(cbegin(kStr), cend(kStr), destination_iter);
-            if (idx != container_size - 1)//For idx == last element dont add delimeter
-            {
-                destination_iter = copy(cbegin(delimeter), cend(delimeter), destination_iter);
-            }
-            ++idx;
+            if (EINTR == errno) { continue; }
+            return false;
         }
+        data.remove_prefix(static_cast<size_t>(kWritten));
     }
-    return str;
+    return true;
+}
+
+/**
+ * @brief Writes strings in container @param c joined with @param delimeter to file descriptor @param fd in large blocks.
+ * @return true if all of the output was written
+ */
+template<class Container>
+bool JoinStringsToFile(const int &fd, const Container &c, string_view delimeter)
+{
+    auto writer = BlockWriter{ [fd](string_view data) { return WriteAll(fd, data); } };
+    WriteJoined(writer, c, delimeter);
+    return writer.Flush();
 }
 
 int main() 
@@ -128,6 +274,68 @@ int main()
 
     assert(JoinStringsWithDelimeter( forward_list<string_view>{ "I"sv, "Am"sv, "A"sv, "Forward"sv, "List"sv, "Without"sv, "Any"sv, "Delimeter"sv} , "") == "IAmAForwardListWithoutAnyDelimeter"s);
 
+    auto buffer = "header\n"s;
+    AppendJoinedStrings(buffer, array{ "a"sv, "b"sv, "c"sv }, ",");
+    AppendJoinedStrings(buffer, list<string>{}, ",");
+    AppendJoinedStrings(buffer, forward_list{ "\nd"sv, "e"sv }, ",");
+    assert("header\na,b,c\nd,e"s == buffer);
+
+    auto stream = std::ostringstream{};
+    const auto kLarge = string(kJoinBlockSize + 10, 'x');
+    const auto kStreamed = JoinStringsToStream(stream, list{ "small"sv, string_view{ kLarge }, "tail"sv }, "|");
+    assert(kStreamed && JoinStringsWithDelimeter(list{ "small"sv, string_view{ kLarge }, "tail"sv }, "|") == stream.str());
+
+    // CSV export: every row is joined into one buffer, and rows are joined with new lines
+    auto rows = vector<array<string, 4>>(kBenchmarkRows);
+    for (auto idx = size_t{ 0 }; idx < size(rows) ;++idx)
+    {
+        rows[idx] = { std::to_string(idx), "product name " + std::to_string(idx % 977), std::to_string(idx * 37 % 10'000) + ".99", "in stock" };
+    }
+
+    auto start_timepoint = steady_clock::now();
+    auto appended        = string{};
+    for (const auto &kRow : rows)
+    {
+        appended += kRow[0] + "," + kRow[1] + "," + kRow[2] + "," + kRow[3] + "\n";
+    }
+    cout << "Exporting " << kBenchmarkRows << " rows with operator+=: " << duration<double>(steady_clock::now() - start_timepoint).count() << " sec\n";
+
+    start_timepoint = steady_clock::now();
+    auto lines      = vector<string>{};
+    lines.reserve(size(rows));
+    for (const auto &kRow : rows) { lines.push_back(JoinStringsWithDelimeter(kRow, ",")); }
+    auto joined = JoinStringsWithDelimeter(lines, "\n") + "\n";
+    cout << "Exporting " << kBenchmarkRows << " rows with JoinStringsWithDelimeter(): " << duration<double>(steady_clock::now() - start_timepoint).count() << " sec\n";
+    assert(appended == joined);
+
+    start_timepoint = steady_clock::now();
+    auto csv        = string{};
+    for (const auto &kRow : rows)
+    {
+        AppendJoinedStrings(csv, kRow, ",");
+        csv.push_back('\n');
+    }
+    cout << "Exporting " << kBenchmarkRows << " rows with AppendJoinedStrings(): " << duration<double>(steady_clock::now() - start_timepoint).count() << " sec\n";
+    assert(appended == csv);
+
+    // Rows are joined to a file in the temporary directory, the final new line is written after them
+    const auto kPath = (std::filesystem::temp_directory_path() / "26_join_strings.csv").string();
+    const auto kFd   = ::open(kPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (kFd < 0)
+    {
+        cout << "Unable to open " << kPath << '\n';
+        return 1;
+    }
+    start_timepoint = steady_clock::now();
+    lines.clear();
+    for (const auto &kRow : rows) { lines.push_back(JoinStringsWithDelimeter(kRow, ",")); }
+    const auto kWritten = JoinStringsToFile(kFd, lines, "\n") && WriteAll(kFd, "\n");
+    cout << "Exporting " << kBenchmarkRows << " rows with JoinStringsToFile(): " << duration<double>(steady_clock::now() - start_timepoint).count() << " sec\n";
+    ::close(kFd);
+    assert(kWritten && appended == (std::ostringstream{} << std::ifstream{ kPath }.rdbuf()).str());
+    std::filesystem::remove(kPath);
+    assert(!JoinStringsToFile(-1, list{ "a"sv, "b"sv }, ","));
+
     cout << "All tests passed!!!\n";
     return 0;
 }
\ No newline at end of file
@@ -2,7 +2,7 @@
  * @file 27_split.cpp
  * @author Usama Tayyab (usamatayyab9@gmail.com)
  * @brief 
- *  Compilation command : g++ -std=c++17 27_split.cpp
+ *  Compilation command : g++ -std=c++20 -O2 -mavx2 27_split.cpp -lpthread
  *  This file is solution to "Problem 27. Splitting a string into tokens with a list of possible delimiters"
  *  mentioned in "Chapter 3: Strings and Regular Expressions" of the book:
  *  - The Modern C++ Challenge by Marius Bancilla (available at amazon https://www.amazon.com/Modern-Challenge-programmer-real-world-problems/dp/1788993861)
@@ -16,10 +16,27 @@
  * This provides only a single function called Split which takes a string and delimeters as input
  * and returns a vector of all possible tokens.
  * 
+ * SplitView() returns a `SplitRange`, a lazy range of string_view tokens which refer to the input, so iterating
+ * over it does not allocate. Split() builds its vector from this range.
+ * Delimeters are compiled into a `DelimeterSet` which has a 256-bit bitmap of the delimeters for the scalar
+ * scan and, when the delimeters have atmost 8 different high nibbles(always true for ASCII delimeters), two
+ * pshufb nibble tables:
+ * - Every different high nibble gets one bit of a byte.
+ * - Entry h of the high table has the bit of high nibble h.
+ * - Entry l of the low table has the bits of all high nibbles h for which character (h << 4 | l) is a delimeter.
+ * So a character is a delimeter iff low_table[ch & 0xF] & high_table[ch >> 4] is not zero, which classifies 32
+ * characters with AVX2(16 with SSSE3) using two shuffles. Tokens in logs are short, so rather than scanning for
+ * every token boundary separately, the SplitRange iterator classifies a window of 64 characters into a bitmask
+ * and finds the boundaries in it by counting trailing zeros, moving to the next window only when it runs out.
+ * SplitIntoChunks() divides a large text into chunks ending at delimeters, each of which is a SplitRange, and
+ * ForEachTokenParallel() iterates over the chunks in separate threads.
+ * 
  * Driver code:
  * - Input 2 strings from user for representing target string and other representing a list of delimeters.
  * - Genrates token using Split function
  * - Prints all tokens on console 
+ * - Checks SplitView() and the chunks against find_first_of() on random text, then prints time taken for
+ *   tokenizing a `kBenchmarkSize` bytes log with Split(), SplitView() and ForEachTokenParallel().
  * 
  * @copyright Copyright (c) 2023
  * 
@@ -32,7 +49,19 @@
 #include <locale>
 #include <cassert>
 #include <vector>
+#include <array>
+#include <bit>
+#include <ranges>
+#include <thread>
+#include <random>
+#include <chrono>
+#include <cstdint>
+
+#if defined(__SSSE3__)
+#include <immintrin.h>
+#endif
 
+using std::array;
 using std::cbegin;
 using std::cend;
 using std::cin;
@@ -42,7 +71,266 @@ using std::find_first_of;
 using std::ostream_iterator;
 using std::string;
 using std::string_view;
+using std::thread;
 using std::vector;
+using namespace std::string_view_literals;
+using std::chrono::steady_clock;
+using std::chrono::duration;
+
+inline constexpr auto kBenchmarkSize = size_t{ 256 } << 20;
+
+/**
+ * @brief A set of delimeter characters which finds them in text, see file comments.
+ */
+class DelimeterSet
+{
+public:
+    explicit DelimeterSet(string_view delimeters)
+    {
+        auto high_nibbles = uint16_t{ 0 };
+        for (const auto &kCh : delimeters)
+        {
+            const auto kByte = static_cast<unsigned char>(kCh);
+            bitmap_[kByte / 64] |= uint64_t{ 1 } << (kByte % 64);
+            high_nibbles        |= uint16_t(1u << (kByte >> 4));
+        }
+        has_nibble_tables_ = std::popcount(high_nibbles) <= 8;
+        if (!has_nibble_tables_) { return; }
+
+        auto bucket = 0;
+        for (auto high = 0; high < 16 ;++high)
+        {
+            if (0 == (high_nibbles & (1u << high))) { continue; }
+            high_table_[high] = static_cast<uint8_t>(1u << bucket++);
+            for (auto low = 0; low < 16 ;++low)
+            {
+                if (Contains(static_cast<char>(high << 4 | low))) { low_table_[low] |= high_table_[high]; }
+            }
+        }
+    }
+
+    bool Contains(const char &ch) const
+    {
+        const auto kByte = static_cast<unsigned char>(ch);
+        return 0 != (bitmap_[kByte / 64] & (uint64_t{ 1 } << (kByte % 64)));
+    }
+
+    /**
+     * @brief Returns pointer to the first delimeter in [@param first, @param last), or @param last if there is none.
+     */
+    const char *Find(const char *first, const char *last) const { return Scan<true>(first, last); }
+
+    /**
+     * @brief Returns pointer to the first character in [@param first, @param last) which is not a delimeter, or
+     *      @param last if there is none.
+     */
+    const char *FindNot(const char *first, const char *last) const { return Scan<false>(first, last); }
+
+    /**
+     * @brief Returns a mask whose bit i is set if @param first[i] is a delimeter, for the atmost 64 characters
+     *      before @param last. Bits past @param last are set.
+     */
+    uint64_t Classify64(const char *first, const char *last) const
+    {
+        auto mask = uint64_t{ 0 };
+#if defined(__AVX2__)
+        if (has_nibble_tables_ && last - first >= 64)
+        {
+            const auto kLowTable  = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(low_table_.data())));
+            const auto kHighTable = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(high_table_.data())));
+            const auto kNibble    = _mm256_set1_epi8(0x0F);
+            for (auto offset = 0; offset < 64 ;offset += 32)
+            {
+                const auto kChars = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(first + offset));
+                const auto kLow   = _mm256_shuffle_epi8(kLowTable, _mm256_and_si256(kChars, kNibble));
+                const auto kHigh  = _mm256_shuffle_epi8(kHighTable, _mm256_and_si256(_mm256_srli_epi16(kChars, 4), kNibble));
+                const auto kOther = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(kLow, kHigh), _mm256_setzero_si256())));
+                mask |= uint64_t{ ~kOther } << offset;
+            }
+            return mask;
+        }
+#elif defined(__SSSE3__)
+        if (has_nibble_tables_ && last - first >= 64)
+        {
+            const auto kLowTable  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(low_table_.data()));
+            const auto kHighTable = _mm_loadu_si128(reinterpret_cast<const __m128i *>(high_table_.data()));
+            const auto kNibble    = _mm_set1_epi8(0x0F);
+            for (auto offset = 0; offset < 64 ;offset += 16)
+            {
+                const auto kChars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first + offset));
+                const auto kLow   = _mm_shuffle_epi8(kLowTable, _mm_and_si128(kChars, kNibble));
+                const auto kHigh  = _mm_shuffle_epi8(kHighTable, _mm_and_si128(_mm_srli_epi16(kChars, 4), kNibble));
+                const auto kOther = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(kLow, kHigh), _mm_setzero_si128())));
+                mask |= uint64_t{ ~kOther & 0xFFFF } << offset;
+            }
+            return mask;
+        }
+#endif
+        const auto kCount = std::min<std::ptrdiff_t>(64, last - first);
+        for (auto idx = 0; idx < kCount ;++idx)
+        {
+            mask |= uint64_t{ Contains(first[idx]) } << idx;
+        }
+        return (64 == kCount) ? mask : (mask | (~uint64_t{ 0 } << kCount));
+    }
+
+private:
+    template<bool kFindDelimeter>
+    const char *Scan(const char *first, const char *last) const
+    {
+        // Tokens and runs of delimeters are often short, so the first character is checked on its own
+        if (first == last || kFindDelimeter == Contains(*first)) { return first; }
+        ++first;
+#if defined(__AVX2__)
+        if (has_nibble_tables_)
+        {
+            const auto kLowTable  = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(low_table_.data())));
+            const auto kHighTable = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(high_table_.data())));
+            const auto kNibble    = _mm256_set1_epi8(0x0F);
+            for (; last - first >= 32 ;first += 32)
+            {
+                const auto kChars = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(first));
+                const auto kLow   = _mm256_shuffle_epi8(kLowTable, _mm256_and_si256(kChars, kNibble));
+                const auto kHigh  = _mm256_shuffle_epi8(kHighTable, _mm256_and_si256(_mm256_srli_epi16(kChars, 4), kNibble));
+                const auto kOther = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(kLow, kHigh), _mm256_setzero_si256())));
+                const auto kFound = kFindDelimeter ? ~kOther : kOther;
+                if (0 != kFound) { return first + std::countr_zero(kFound); }
+            }
+        }
+#elif defined(__SSSE3__)
+        if (has_nibble_tables_)
+        {
+            const auto kLowTable  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(low_table_.data()));
+            const auto kHighTable = _mm_loadu_si128(reinterpret_cast<const __m128i *>(high_table_.data()));
+            const auto kNibble    = _mm_set1_epi8(0x0F);
+            for (; last - first >= 16 ;first += 16)
+            {
+                const auto kChars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+                const auto kLow   = _mm_shuffle_epi8(kLowTable, _mm_and_si128(kChars, kNibble));
+                const auto kHigh  = _mm_shuffle_epi8(kHighTable, _mm_and_si128(_mm_srli_epi16(kChars, 4), kNibble));
+                const auto kOther = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(kLow, kHigh), _mm_setzero_si128())));
+                const auto kFound = (kFindDelimeter ? ~kOther : kOther) & 0xFFFF;
+                if (0 != kFound) { return first + std::countr_zero(kFound); }
+            }
+        }
+#endif
+        for (; first != last && kFindDelimeter != Contains(*first) ;++first) {}
+        return first;
+    }
+
+    array<uint64_t, 4> bitmap_{};
+    array<uint8_t, 16> low_table_{};
+    array<uint8_t, 16> high_table_{};
+    bool               has_nibble_tables_ = false;
+};
+
+/**
+ * @brief Lazy range of the non empty tokens of a text separated by delimeters of a DelimeterSet. Tokens refer
+ *      to the text, which must outlive the range. The DelimeterSet is small and is copied into the range, so
+ *      a temporary DelimeterSet can be passed. Iterators refer to the range and must not outlive it.
+ */
+class SplitRange : public std::ranges::view_interface<SplitRange>
+{
+public:
+    class Iterator
+    {
+    public:
+        using iterator_concept  = std::forward_iterator_tag;
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = string_view;
+        using difference_type   = std::ptrdiff_t;
+
+        Iterator() = default;
+        Iterator(const DelimeterSet *delimeters, const char *first, const char *last)
+            : delimeters_{ delimeters }, last_{ last }, window_{ first }, window_end_{ first }
+        {
+            Advance(first);
+        }
+
+        string_view operator*() const { return token_; }
+
+        Iterator &operator++()
+        {
+            Advance(token_.data() + token_.size());
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            auto previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const Iterator &other) const { return token_.data() == other.token_.data(); }
+        bool operator==(std::default_sentinel_t) const { return nullptr == token_.data(); }
+
+    private:
+        /**
+         * @brief Moves to the token starting at or after @param position.
+         */
+        void Advance(const char *position)
+        {
+            const auto *kFirst = Scan<false>(position);
+            if (kFirst == last_)
+            {
+                token_ = string_view{};
+                return;
+            }
+            const auto *kLast = Scan<true>(kFirst);
+            token_            = string_view{ kFirst, static_cast<size_t>(kLast - kFirst) };
+        }
+
+        /**
+         * @brief Returns the first delimeter(or non delimeter) at or after @param position. Delimeters are found
+         *      from the mask of a 64 character window, which is classified again only when the scan leaves it.
+         */
+        template<bool kFindDelimeter>
+        const char *Scan(const char *position)
+        {
+            while (position < last_)
+            {
+                if (position >= window_end_)
+                {
+                    window_      = position;
+                    window_end_  = position + std::min<std::ptrdiff_t>(64, last_ - position);
+                    window_mask_ = delimeters_->Classify64(position, last_);
+                }
+                const auto kBits = (kFindDelimeter ? window_mask_ : ~window_mask_) >> (position - window_);
+                if (0 != kBits) { return std::min(position + std::countr_zero(kBits), last_); }
+                position = window_end_;
+            }
+            return last_;
+        }
+
+        const DelimeterSet *delimeters_  = nullptr;
+        const char         *last_        = nullptr;
+        const char         *window_      = nullptr;
+        const char         *window_end_  = nullptr;
+        uint64_t            window_mask_ = 0;
+        string_view         token_;
+    };
+
+    SplitRange() : delimeters_{ string_view{} } {}
+    SplitRange(string_view text, const DelimeterSet &delimeters) : text_{ text }, delimeters_{ delimeters } {}
+
+    Iterator begin() const { return Iterator{ &delimeters_, text_.data(), text_.data() + text_.size() }; }
+    Iterator end() const { return Iterator{}; }
+
+    string_view Text() const { return text_; }
+
+private:
+    string_view  text_;
+    DelimeterSet delimeters_;
+};
+
+/**
+ * @brief Returns a lazy range of tokens of @param text separated by any of @param delimeters.
+ */
+SplitRange SplitView(string_view text, const DelimeterSet &delimeters)
+{
+    return SplitRange{ text, delimeters };
+}
 
 /**
  * @brief Splits a string into tokens using specified delimiters.
@@ -56,25 +344,71 @@ using std::vector;
  */
 auto Split(string_view text, string_view delimeters)
 {
-    auto tokens = vector<string>{};
+    const auto kDelimeters = DelimeterSet{ delimeters };
+    auto tokens            = vector<string>{};
+    for (const auto &kToken : SplitView(text, kDelimeters))
+    {
+        tokens.emplace_back(kToken);
+    }
+    return tokens;
+}
+
+/**
+ * @brief Divides @param text into atmost @param chunk_count ranges of about equal size, every range except the
+ *      last one ends at a delimeter, so no token is split between two ranges.
+ */
+vector<SplitRange> SplitIntoChunks(string_view text, const DelimeterSet &delimeters, const size_t &chunk_count)
+{
+    auto chunks       = vector<SplitRange>{};
+    const auto *kLast = text.data() + size(text);
+    const auto *first = text.data();
+    for (auto idx = size_t{ 1 }; idx <= chunk_count && first != kLast ;++idx)
+    {
+        const auto *kTarget = text.data() + size(text) * idx / chunk_count;
+        const auto *kEnd    = (idx == chunk_count) ? kLast : delimeters.Find(std::max(first, kTarget), kLast);
+        chunks.emplace_back(string_view{ first, static_cast<size_t>(kEnd - first) }, delimeters);
+        first = kEnd;
+    }
+    return chunks;
+}
+
+/**
+ * @brief Calls @param visitor(chunk_index, token) for every token of @param text, the chunks from SplitIntoChunks()
+ *      are processed in parallel using @param thread_count threads, tokens of a chunk are visited in order.
+ */
+template<class Visitor>
+void ForEachTokenParallel(string_view text, const DelimeterSet &delimeters, Visitor &&visitor, const size_t &thread_count = std::max(1u, thread::hardware_concurrency()))
+{
+    const auto kChunks = SplitIntoChunks(text, delimeters, thread_count);
+    auto threads       = vector<thread>{};
+    for (auto idx = size_t{ 0 }; idx < size(kChunks) ;++idx)
+    {
+        threads.emplace_back([&kChunks, &visitor, idx]() {
+            for (const auto &kToken : kChunks[idx]) { visitor(idx, kToken); }
+        });
+    }
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+}
+
+static_assert(std::ranges::forward_range<SplitRange>);
+
+/**
+ * @brief The straightforward split, used for checking.
+ */
+vector<string_view> ReferenceSplit(string_view text, string_view delimeters)
+{
+    auto tokens = vector<string_view>{};
     auto first  = cbegin(text);
     while (true)
     {
         auto last = find_first_of(first, cend(text), cbegin(delimeters), cend(delimeters));
-        /*! [first, last) is a token or it can be an empty string
-            It might be possible delimeters are consecutive, then
-            first == last and token will be empty.
-        */
-        if (first != last) { tokens.push_back(string{ first, last }); }
-        /*! If search is at end i.e last == end(text) then last + 1 will be going beyond
-            the limit, therfore break the loop before. However if last != cend(text) then it
-            means that there are some still characters left to process.
-        */
+        if (first != last) { tokens.emplace_back(first, last); }
         if (last == cend(text)) { break; }
-        
         first = last + 1;
     }
-
     return tokens;
 }
 
@@ -93,5 +427,75 @@ int main()
     cout << "List of tokens:\n";
     copy(cbegin(kTokens), cend(kTokens), ostream_iterator<string>{cout, "\n"});
 
+    assert((vector<string>{ "this", "is", "a", "sample" }) == Split("this,is.a sample!!", ",.! "));
+    assert((vector<string>{ "no delimeters" }) == Split("no delimeters", ""));
+    assert(Split(",,,", ",").empty());
+
+    // Random text, including delimeter sets which have more than 8 high nibbles
+    auto random_engine = std::mt19937{ 27 };
+    for (auto test = 0; test < 2'000 ;++test)
+    {
+        auto random_text      = string(random_engine() % 300, '\0');
+        auto random_delimeters = string(1 + random_engine() % ((0 == test % 10) ? 40 : 4), '\0');
+        for (auto &ch : random_delimeters) { ch = static_cast<char>(random_engine()); }
+        for (auto &ch : random_text)
+        {
+            ch = (0 == random_engine() % 4) ? random_delimeters[random_engine() % size(random_delimeters)] : static_cast<char>(random_engine());
+        }
+        const auto kDelimeters = DelimeterSet{ random_delimeters };
+        const auto kExpected   = ReferenceSplit(random_text, random_delimeters);
+        const auto kRange      = SplitView(random_text, kDelimeters);
+        assert(std::ranges::equal(kExpected, kRange));
+        assert(std::ranges::equal(kExpected, SplitView(random_text, DelimeterSet{ random_delimeters })));
+
+        auto chunked = vector<string_view>{};
+        for (const auto &kChunk : SplitIntoChunks(random_text, kDelimeters, 1 + test % 7))
+        {
+            std::ranges::copy(kChunk, std::back_inserter(chunked));
+        }
+        assert(kExpected == chunked);
+    }
+
+    // A log having lines of space separated fields
+    auto log = string{};
+    log.reserve(kBenchmarkSize + 256);
+    constexpr auto kLevels = array{ "INFO"sv, "WARN"sv, "DEBUG"sv, "ERROR"sv };
+    while (size(log) < kBenchmarkSize)
+    {
+        log.append("2023-10-16T12:").append(std::to_string(random_engine() % 60)).append(" [").append(kLevels[random_engine() % size(kLevels)])
+           .append("] worker-").append(std::to_string(random_engine() % 64)).append(" request id=").append(std::to_string(random_engine()))
+           .append(" took ").append(std::to_string(random_engine() % 1000)).append("ms\n");
+    }
+    const auto kLogDelimeters = DelimeterSet{ " []=\n" };
+
+    auto start_timepoint = steady_clock::now();
+    const auto kCopied   = Split(log, " []=\n");
+    cout << "Split() of " << (size(log) >> 20) << " MB log into " << size(kCopied) << " tokens: " << duration<double>(steady_clock::now() - start_timepoint).count() << " sec\n";
+
+    start_timepoint = steady_clock::now();
+    auto count      = size_t{ 0 };
+    auto length     = size_t{ 0 };
+    for (const auto &kToken : ReferenceSplit(log, " []=\n")) { ++count; length += size(kToken); }
+    cout << "find_first_of() into vector<string_view>: " << duration<double>(steady_clock::now() - start_timepoint).count() << " sec\n";
+
+    start_timepoint    = steady_clock::now();
+    auto lazy_count    = size_t{ 0 };
+    auto lazy_length   = size_t{ 0 };
+    for (const auto &kToken : SplitView(log, kLogDelimeters)) { ++lazy_count; lazy_length += size(kToken); }
+    cout << "SplitView(): " << duration<double>(steady_clock::now() - start_timepoint).count() << " sec\n";
+    assert(count == lazy_count && length == lazy_length && count == size(kCopied));
+
+    start_timepoint = steady_clock::now();
+    auto counts     = vector<array<size_t, 8>>(std::max(1u, thread::hardware_concurrency())); // one cache line for each chunk
+    ForEachTokenParallel(log, kLogDelimeters, [&counts](const size_t &chunk, string_view token) {
+        ++counts[chunk][0];
+        counts[chunk][1] += size(token);
+    }, size(counts));
+    cout << "ForEachTokenParallel() with " << size(counts) << " threads: " << duration<double>(steady_clock::now() - start_timepoint).count() << " sec\n";
+    auto parallel_count  = size_t{ 0 };
+    auto parallel_length = size_t{ 0 };
+    for (const auto &kCount : counts) { parallel_count += kCount[0]; parallel_length += kCount[1]; }
+    assert(count == parallel_count && length == parallel_length);
+
     return 0;
 }
\ No newline at end of file
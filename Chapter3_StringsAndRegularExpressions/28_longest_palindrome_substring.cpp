@@ -2,7 +2,7 @@
  * @file 28_longest_palindrome_substring.cpp
  * @author Usama Tayyab (usamatayyab9@gmail.com)
  * @brief 
- * Compilation command : g++ -std=c++17 28_longest_palindrome_substring.cpp
+ * Compilation command : g++ -std=c++20 -O2 28_longest_palindrome_substring.cpp
  * 
  *  This file is solution to "Problem 28. Longest palindromic substring"
  *  mentioned in "Chapter 3: Strings and Regular Expressions" of the book:
@@ -14,10 +14,16 @@
  * should be returned.
  * 
  * Solution:
- * - See function comments of LongestPalindromeSubstring() for understanding the algorithm
+ * - See function comments of ForEachMaximalPalindrome() for understanding the algorithm
+ * - LongestPalindrome() returns offset and length of the longest palindrome as a `PalindromeSpan`, and
+ *   LongestPalindromeSubstring() copies it into a string.
+ * - MaximalPalindromes() returns every palindrome which can not be extended on both sides, that is the
+ *   longest palindrome around every center, of atleast a given length.
  * Driver code:
  * - Takes a string input from user
  * - Computes and prints the longest palidromic substring
+ * - Checks LongestPalindrome() and MaximalPalindromes() against brute force on random strings, then prints
+ *   time taken on `kBenchmarkSize` characters of random DNA and of a single repeated character.
  * 
  * @copyright Copyright (c) 2023
  * 
@@ -27,9 +33,14 @@
 #include <string_view>
 #include <vector>
 #include <iterator>
-#include <unordered_map>
 #include <utility>
 #include <algorithm>
+#include <random>
+#include <chrono>
+#include <limits>
+#include <cassert>
+#include <cstdint>
+#include <memory>
 
 using std::cbegin;
 using std::cend;
@@ -42,26 +53,23 @@ using std::find_if;
 using std::pair;
 using std::string;
 using std::string_view;
-using std::unordered_map;
 using std::vector;
+using std::chrono::steady_clock;
+using std::chrono::duration;
+
+inline constexpr auto kBenchmarkSize = size_t{ 100'000'000 };
 
 /**
- * @brief   Get the Character Indices Map object
- * @param   str 
- * @return  unordered_map<char, vector<size_t>>
- *          For each character in str corresponding vector contains all
- *          indices at which it is present
+ * @brief A substring given by its offset and length, instead of a copy.
  */
-auto GetCharacterIndicesMap(string_view str)
+struct PalindromeSpan
 {
-    auto char_vec_umap = unordered_map<char, vector<size_t>>{};
-    for (auto idx = size_t{ 0 }; idx < size(str) ;++idx)
-    {
-        const auto &kCurrentChar = str[idx];
-        char_vec_umap[kCurrentChar].push_back(idx);
-    }
-    return char_vec_umap;
-}
+    size_t offset = 0;
+    size_t length = 0;
+
+    bool operator==(const PalindromeSpan &) const = default;
+    auto operator<=>(const PalindromeSpan &) const = default;
+};
 
 /**
  * @brief Tests whether a given string is palindrome or not
@@ -75,60 +83,101 @@ bool IsPalindrome(string_view str)
 }
 
 /**
- * @brief Tests whether length of str is greater than @param len 
- *        and it is a palindrome or not. 
- * @param len 
- * @param str 
- * @return true, if str is palindrome and length of @param str > @param len
- * @return false, otherwise
+ * @brief One pass of Manacher's algorithm over the odd(@tparam kEven = false) or the even length palindromes
+ *      of @param str, calls @param visitor(center, radius) for every center. @param radii is used for storing
+ *      radius of every center, it must have room for size(@param str) radii.
  */
-bool IsLongerPalindrome(size_t len, string_view str)
+template<bool kEven, class Radius, class Visitor>
+void ManacherPass(string_view str, Radius *radii, Visitor &&visitor)
 {
-    return (size(str) > len) && (IsPalindrome(str));
+    constexpr auto kShift = std::ptrdiff_t{ kEven ? 1 : 0 };
+    const auto kLength    = static_cast<std::ptrdiff_t>(size(str));
+    auto left             = std::ptrdiff_t{ 0 };
+    auto right            = std::ptrdiff_t{ -1 };
+    for (auto idx = std::ptrdiff_t{ 0 }; idx < kLength ;++idx)
+    {
+        // Inside [left, right] the mirror center already tells the radius upto right
+        auto radius = (idx > right) ? 1 - kShift : std::min<std::ptrdiff_t>(radii[left + right - idx + kShift], right - idx + 1);
+        while (idx - radius - kShift >= 0 && idx + radius < kLength && str[idx - radius - kShift] == str[idx + radius])
+        {
+            ++radius;
+        }
+        radii[idx] = static_cast<Radius>(radius);
+        visitor(idx, radius);
+        if (idx + radius - 1 > right)
+        {
+            left  = idx - radius + 1 - kShift;
+            right = idx + radius - 1;
+        }
+    }
 }
 
 /**
- * @brief Calculates the longest palindrome substring of param str
- * @details Algorithm works as follows
- *          1. Generates a map such that for each character in str, all the indices
- *              at which it occurs are stored in vector. All indices are in sorted order.
- *          2. Start traversing str from left call it left_idx:
- *              2.1 Fetch its indices vector from map
- *              2.2 Traverse the indices vector in reverse order i.e. larger indices first,
- *                   it will always be greater the left index. call it right_idx
- *              2.2.1 if length of substring [left_indx, right_idx + 1) is greater max length of
- *                      result string AND substring [left_indx, right_idx + 1) is also palindrome,
- *                      then update max lenght = right_idx - left_indx + 1. If condition is met
- *                      then stop traversing indices vector.
- * @param str 
- * @return string 
+ * @brief Calls @param visitor(PalindromeSpan) for the maximal palindrome of every center of @param str which is
+ *      atleast @param min_length long, first for the odd length ones and then for the even length ones, each
+ *      in order of center.
+ * @details Uses Manacher's algorithm which takes O(n):
+ *          1. radius[i] of center i is the number of characters matching on both sides of i, plus 1 for the
+ *              odd length palindromes which have i in the middle. For even length ones the center is between i - 1 and i.
+ *          2. [left, right] is the palindrome reaching the farthest right found so far. If i is inside it, the
+ *              palindrome around i is the mirror of the one around left + right - i, atleast upto right. So the
+ *              radius starts from there, and characters are compared only beyond right.
+ *          3. Every comparison which matches moves right forward, so there are atmost n of them in total.
+ *          Radii are stored as 32-bit when @param str is shorter than 4 GB.
  */
-string LongestPalindromeSubstring(string_view str)
+template<class Visitor>
+void ForEachMaximalPalindrome(string_view str, const size_t &min_length, Visitor &&visitor)
 {
-    const auto kIndicesUmap           = GetCharacterIndicesMap(str);
-    auto first                        = size_t{ 0 };
-    auto max_palindrome_length_so_far = size_t{ 1 };
+    auto Run = [&](auto radius_type) {
+        // Every radius is written before it is read, so the array is not initialized
+        const auto radii = std::make_unique_for_overwrite<decltype(radius_type)[]>(size(str));
+        ManacherPass<false>(str, radii.get(), [&](const std::ptrdiff_t &center, const std::ptrdiff_t &radius) {
+            if (static_cast<size_t>(2 * radius - 1) >= min_length) { visitor(PalindromeSpan{ static_cast<size_t>(center - radius + 1), static_cast<size_t>(2 * radius - 1) }); }
+        });
+        ManacherPass<true>(str, radii.get(), [&](const std::ptrdiff_t &center, const std::ptrdiff_t &radius) {
+            if (radius > 0 && static_cast<size_t>(2 * radius) >= min_length) { visitor(PalindromeSpan{ static_cast<size_t>(center - radius), static_cast<size_t>(2 * radius) }); }
+        });
+    };
+    if (size(str) < std::numeric_limits<uint32_t>::max()) { Run(uint32_t{}); }
+    else                                                    { Run(uint64_t{}); }
+}
 
-    for (auto left_idx = size_t{ 0 }; left_idx < size(str) ;++left_idx)
-    {
-        const auto &kCurrentCh  = str[left_idx];
-        const auto &kIndicesVec = kIndicesUmap.at(kCurrentCh);
-        if (size(kIndicesVec) > 1)
+/**
+ * @brief Returns all maximal palindromes of @param str which are atleast @param min_length long, sorted by offset.
+ */
+vector<PalindromeSpan> MaximalPalindromes(string_view str, const size_t &min_length = 1)
+{
+    auto palindromes = vector<PalindromeSpan>{};
+    ForEachMaximalPalindrome(str, min_length, [&palindromes](const PalindromeSpan &palindrome) { palindromes.push_back(palindrome); });
+    std::sort(begin(palindromes), end(palindromes));
+    return palindromes;
+}
+
+/**
+ * @brief Returns offset and length of the longest palindrome substring of @param str, the first one if there
+ *      are more than one.
+ */
+PalindromeSpan LongestPalindrome(string_view str)
+{
+    auto longest = PalindromeSpan{};
+    ForEachMaximalPalindrome(str, 1, [&longest](const PalindromeSpan &palindrome) {
+        if (palindrome.length > longest.length || (palindrome.length == longest.length && palindrome.offset < longest.offset))
         {
-            auto pos = find_if(crbegin(kIndicesVec), crend(kIndicesVec),
-            [max_palindrome_length_so_far, left_idx, str](const auto &right_idx)
-            {
-                return IsLongerPalindrome(max_palindrome_length_so_far, str.substr(left_idx, right_idx - left_idx + 1));
-            });
-            if (pos != crend(kIndicesVec))
-            {
-                first                        = left_idx;
-                const auto &kRightIdx        = *pos;
-                max_palindrome_length_so_far = kRightIdx - left_idx + 1;
-            }
+            longest = palindrome;
         }
-    }
-    return string{str, first, max_palindrome_length_so_far};
+    });
+    return longest;
+}
+
+/**
+ * @brief Calculates the longest palindrome substring of param str, see LongestPalindrome()
+ * @param str 
+ * @return string 
+ */
+string LongestPalindromeSubstring(string_view str)
+{
+    const auto kLongest = LongestPalindrome(str);
+    return string{ str.substr(kLongest.offset, kLongest.length) };
 }
 
 int main()
@@ -139,5 +188,48 @@ int main()
 
     auto longest_palindrome_string = LongestPalindromeSubstring(str);
     cout << "Longest palindrome substring: " << longest_palindrome_string << '\n';
+
+    assert("" == LongestPalindromeSubstring(""));
+    assert("a" == LongestPalindromeSubstring("abc"));
+    assert("abba" == LongestPalindromeSubstring("xabbay"));
+    assert("level" == LongestPalindromeSubstring("sahararlevelmadam"));
+    assert((vector<PalindromeSpan>{ { 0, 1 }, { 0, 3 }, { 2, 1 } }) == MaximalPalindromes("aba"));
+    assert((vector<PalindromeSpan>{ { 0, 4 }, { 3, 2 } }) == MaximalPalindromes("abbaa", 2));
+
+    // Random strings of a small alphabet against brute force
+    auto random_engine = std::mt19937{ 28 };
+    for (auto test = 0; test < 2'000 ;++test)
+    {
+        auto random_str = string(random_engine() % 60, 'a');
+        for (auto &ch : random_str) { ch = static_cast<char>('a' + random_engine() % (1 + test % 3)); }
+
+        auto expected_longest = PalindromeSpan{};
+        auto expected_maximal = vector<PalindromeSpan>{};
+        for (auto first = size_t{ 0 }; first < size(random_str) ;++first)
+        {
+            for (auto length = size_t{ 1 }; first + length <= size(random_str) ;++length)
+            {
+                if (!IsPalindrome(string_view{ random_str }.substr(first, length))) { continue; }
+                if (length > expected_longest.length) { expected_longest = { first, length }; }
+                if (0 == first || first + length == size(random_str) || random_str[first - 1] != random_str[first + length])
+                {
+                    expected_maximal.push_back({ first, length });
+                }
+            }
+        }
+        assert(expected_longest == LongestPalindrome(random_str));
+        assert(expected_maximal == MaximalPalindromes(random_str));
+    }
+
+    auto dna = string(kBenchmarkSize, 'A');
+    for (auto &ch : dna) { ch = "ACGT"[random_engine() % 4]; }
+    const auto kRepeated = string(kBenchmarkSize, 'a');
+    for (const auto &[kName, kText] : { pair{ "random DNA", string_view{ dna } }, pair{ "repeated character", string_view{ kRepeated } } })
+    {
+        const auto kStartTimepoint = steady_clock::now();
+        const auto kLongest        = LongestPalindrome(kText);
+        cout << "Longest palindrome of " << kBenchmarkSize << " characters of " << kName << " is at " << kLongest.offset
+             << " of length " << kLongest.length << ", took " << duration<double>(steady_clock::now() - kStartTimepoint).count() << " sec\n";
+    }
     return 0;
 }
\ No newline at end of file